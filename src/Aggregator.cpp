@@ -0,0 +1,160 @@
+#include "Aggregator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void Aggregator::Quantile::add(double value, size_t count) {
+    // The first five values are kept as they come, and become the initial markers once sorted.
+    if (count <= 5) {
+        heights[count - 1] = value;
+        if (count == 5) {
+            std::sort(heights, heights + 5);
+            double p = probability;
+            double initial[5] = {1, 1 + 2 * p, 1 + 4 * p, 3 + 2 * p, 5};
+            for (int i = 0; i < 5; i++) {
+                positions[i] = i + 1;
+                desired[i] = initial[i];
+            }
+        }
+        return;
+    }
+
+    int cell;
+    if (value < heights[0]) {
+        heights[0] = value;
+        cell = 0;
+    } else if (value >= heights[4]) {
+        heights[4] = value;
+        cell = 3;
+    } else {
+        cell = 0;
+        while (cell < 3 && value >= heights[cell + 1]) {
+            cell++;
+        }
+    }
+    for (int i = cell + 1; i < 5; i++) {
+        positions[i]++;
+    }
+    double p = probability;
+    double increments[5] = {0, p / 2, p, (1 + p) / 2, 1};
+    for (int i = 0; i < 5; i++) {
+        desired[i] += increments[i];
+    }
+
+    // Move the middle markers towards their desired positions, parabolically when it keeps them ordered.
+    for (int i = 1; i < 4; i++) {
+        double offset = desired[i] - positions[i];
+        if ((offset >= 1 && positions[i + 1] - positions[i] > 1) || (offset <= -1 && positions[i - 1] - positions[i] < -1)) {
+            double d = offset > 0 ? 1.0 : -1.0;
+            double below = positions[i] - positions[i - 1];
+            double above = positions[i + 1] - positions[i];
+            double parabolic = heights[i] + d / (positions[i + 1] - positions[i - 1])
+                * ((below + d) * (heights[i + 1] - heights[i]) / above + (above - d) * (heights[i] - heights[i - 1]) / below);
+            if (heights[i - 1] < parabolic && parabolic < heights[i + 1]) {
+                heights[i] = parabolic;
+            } else {
+                int j = i + int(d);
+                heights[i] += d * (heights[j] - heights[i]) / (positions[j] - positions[i]);
+            }
+            positions[i] += d;
+        }
+    }
+}
+
+double Aggregator::Quantile::estimate(size_t count) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    if (count >= 5) {
+        return heights[2];
+    }
+    // Too few values for the markers: the exact quantile, interpolated between order statistics.
+    double sorted[5];
+    std::copy(heights, heights + count, sorted);
+    std::sort(sorted, sorted + count);
+    double rank = probability * double(count - 1);
+    size_t below = size_t(rank);
+    size_t above = std::min(below + 1, count - 1);
+    return sorted[below] + (rank - double(below)) * (sorted[above] - sorted[below]);
+}
+
+Aggregator::Aggregator(int window, std::span<const double> percentiles, size_t decimation)
+    : window(std::max(window, 0)), probabilities(percentiles.begin(), percentiles.end()), decimation(decimation) {
+    for (double& probability : probabilities) {
+        probability = std::clamp(probability, 0.0, 1.0);
+    }
+}
+
+void Aggregator::open(long index, int time) {
+    current = Window();
+    current.index = index;
+    current.start = time;
+    sumOfSquares = 0.0;
+    quantiles.assign(probabilities.size(), Quantile());
+    for (size_t i = 0; i < probabilities.size(); i++) {
+        quantiles[i].probability = probabilities[i];
+    }
+}
+
+void Aggregator::add(int time, double value) {
+    // Floor division, so that windows stay aligned on multiples of their length for negative times too.
+    long index = 0;
+    if (window > 0) {
+        index = time / window;
+        if (time % window != 0 && time < 0) {
+            index--;
+        }
+    }
+    if (current.count > 0 && index != current.index) {
+        flush();
+    }
+    if (current.count == 0) {
+        open(index, time);
+    }
+
+    current.count++;
+    current.end = time;
+    current.last = value;
+    if (current.count == 1) {
+        current.min = value;
+        current.max = value;
+    } else {
+        current.min = std::min(current.min, value);
+        current.max = std::max(current.max, value);
+    }
+    double delta = value - current.mean;
+    current.mean += delta / double(current.count);
+    sumOfSquares += delta * (value - current.mean);
+    for (Quantile& quantile : quantiles) {
+        quantile.add(value, current.count);
+    }
+
+    numValues++;
+    if (decimation > 0 && numValues % decimation == 0) {
+        samples.push_back({time, value});
+    }
+}
+
+Aggregator::Window Aggregator::getCurrent() const {
+    Window statistics = current;
+    statistics.variance = current.count > 1 ? sumOfSquares / double(current.count - 1) : 0.0;
+    statistics.percentiles.resize(quantiles.size());
+    for (size_t i = 0; i < quantiles.size(); i++) {
+        statistics.percentiles[i] = quantiles[i].estimate(current.count);
+    }
+    return statistics;
+}
+
+void Aggregator::flush() {
+    if (current.count > 0) {
+        windows.push_back(getCurrent());
+        current = Window();
+    }
+}
+
+void Aggregator::reset() {
+    windows.clear();
+    samples.clear();
+    current = Window();
+    numValues = 0;
+}
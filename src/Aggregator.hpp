@@ -0,0 +1,135 @@
+#ifndef AGGREGATOR_HPP
+#define AGGREGATOR_HPP
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @class Aggregator
+ * @brief Online statistics of the values of a system over reporting windows, and decimated samples.
+ * @details An aggregator receives the value of a system after every step of a run (see
+ * Model::attachAggregator) and keeps, for each reporting window, the count, mean, sample variance,
+ * minimum, maximum and last value, plus estimates of chosen percentiles. It can also keep every k-th value
+ * as a sample. Nothing is stored per step: memory and output grow with the number of windows and samples,
+ * not with the number of steps.
+ *
+ * Windows are aligned on multiples of their length: with a window of 60, the values of times 0 to 59 make
+ * one window, 60 to 119 the next, and so on. A window of zero makes one window of the whole history.
+ * Means and variances are updated with Welford's method, and percentiles with the P-square algorithm of
+ * Jain and Chlamtac, which keeps five markers per percentile and needs no stored values.
+ *
+ * @code
+ * Aggregator hourly(60, std::vector<double>{0.5, 0.95});
+ * model->attachAggregator(queue, &hourly);
+ * model->execute(0, 24 * 60, 1);
+ * hourly.flush();
+ * for (const Aggregator::Window& window : hourly.getWindows()) { ... window.percentiles[1] ... }
+ * @endcode
+ *
+ * @see Model::attachAggregator
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class Aggregator {
+    public:
+        /**
+         * @struct Window
+         * @brief Statistics of the values of one reporting window.
+         */
+        struct Window {
+            long index = 0;             /**< Index of the window: its first time divided by the window length. */
+            int start = 0;              /**< Time of the first value. */
+            int end = 0;                /**< Time of the last value. */
+            size_t count = 0;           /**< Number of values. */
+            double mean = 0.0;
+            double variance = 0.0;      /**< Sample variance, zero for fewer than two values. */
+            double min = 0.0;
+            double max = 0.0;
+            double last = 0.0;          /**< Last value of the window. */
+            vector<double> percentiles; /**< Estimate of each percentile, in the order given to the constructor. */
+        };
+
+        /**
+         * @struct Sample
+         * @brief A value kept by decimation.
+         */
+        struct Sample {
+            int time;
+            double value;
+        };
+
+    private:
+        /// P-square estimator of one quantile.
+        struct Quantile {
+            double probability;
+            double heights[5];      /**< Marker heights; the first values observed until there are five. */
+            double positions[5];    /**< Actual marker positions, from 1. */
+            double desired[5];      /**< Desired marker positions. */
+
+            void add(double value, size_t count);
+            double estimate(size_t count) const;
+        };
+
+        int window;                     /**< Length of the windows, or 0 for a single window. */
+        vector<double> probabilities;   /**< Percentiles to estimate, as probabilities in [0, 1]. */
+        size_t decimation;              /**< Keep every decimation-th value, or none if 0. */
+
+        vector<Window> windows;         /**< Closed windows. */
+        Window current;                 /**< Open window. */
+        double sumOfSquares = 0.0;      /**< Sum of squared deviations of the open window (Welford). */
+        vector<Quantile> quantiles;     /**< Estimators of the open window. */
+        vector<Sample> samples;         /**< Values kept by decimation. */
+        size_t numValues = 0;           /**< Values received since the last reset. */
+
+        void open(long index, int time);
+
+    public:
+        /**
+         * @brief Constructs an aggregator.
+         * @param window The length of the reporting windows in model time, or 0 for one window.
+         * @param percentiles The percentiles to estimate, as probabilities in [0, 1].
+         * @param decimation Keep every decimation-th value as a sample, or none if 0.
+         */
+        explicit Aggregator(int window = 0, std::span<const double> percentiles = {}, size_t decimation = 0);
+
+        /**
+         * @brief Adds the value of a time.
+         * @details Times must not decrease; a time in a later window closes the open one.
+         * @param time The time of the value.
+         * @param value The value.
+         * @return None.
+         */
+        void add(int time, double value);
+
+        /**
+         * @brief Closes the open window, if it has values.
+         * @return None.
+         */
+        void flush();
+
+        /**
+         * @brief Removes all windows and samples.
+         * @return None.
+         */
+        void reset();
+
+        /**
+         * @brief Gets the closed windows, in order.
+         * @return The windows.
+         */
+        const vector<Window>& getWindows() const { return windows; }
+
+        /**
+         * @brief Gets the statistics of the open window so far.
+         * @return The open window; its count is zero if it has no value.
+         */
+        Window getCurrent() const;
+
+        const vector<Sample>& getSamples() const { return samples; }
+        int getWindowLength() const { return window; }
+};
+
+#endif
@@ -9,13 +9,16 @@
 #if !defined(HANDLE_BODY)
 #define HANDLE_BODY
 
+#include <atomic>
+
 #ifndef DEBUGING
 #define DEBUGING
 
-inline int numHandleCreated = 0;
-inline int numHandleDeleted = 0;
-inline int numBodyCreated = 0;
-inline int numBodyDeleted = 0;
+// Atomic, since handles may be created by several threads (see Model::createSystems).
+inline std::atomic<int> numHandleCreated = 0;
+inline std::atomic<int> numHandleDeleted = 0;
+inline std::atomic<int> numBodyCreated = 0;
+inline std::atomic<int> numBodyDeleted = 0;
 
 #endif
 
@@ -31,7 +34,7 @@ class Handle{
 
 	public:
 		/// constructor
-		Handle<T>(){
+		Handle(){
 			pImpl_ = new T;
 			pImpl_->attach();
 			
@@ -41,7 +44,7 @@ class Handle{
 		}
 
 		/// Destructor
-		virtual ~Handle<T>() { 
+		virtual ~Handle() { 
 			pImpl_->detach(); 
 		
 			#ifdef DEBUGING
@@ -50,7 +53,7 @@ class Handle{
 		}
 
 		/// copy constructor
-		Handle<T>(const Handle &hd) : pImpl_(hd.pImpl_) { 
+		Handle(const Handle &hd) : pImpl_(hd.pImpl_) { 
 			pImpl_->attach(); 			
 			
 			#ifdef DEBUGING
@@ -120,7 +123,7 @@ class Body{
 		/// Implementation
 		Body &operator=(const Body &) { return *this; }
 
-		int refCount_; /// the number of references to this class
+		std::atomic<int> refCount_; /// the number of references to this class, shared across threads
 };
 
 #endif
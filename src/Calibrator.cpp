@@ -0,0 +1,304 @@
+#include "Calibrator.hpp"
+#include "DelayFlow.hpp"
+#include "ExpressionFlow.hpp"
+#include "LookupFlow.hpp"
+#include "StochasticFlow.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <random>
+
+bool Calibrator::addParameter(const string& name, double lower, double upper) {
+    vector<string> names = model->getParameterNames();
+    if (lower > upper || std::find(names.begin(), names.end(), name) == names.end()) {
+        return false;
+    }
+    parameters.push_back({name, lower, upper});
+    return true;
+}
+
+bool Calibrator::addObservation(System* system, const TimeSeries* series, double weight) {
+    if (!system || !series) {
+        return false;
+    }
+    auto it = std::find(model->beginSystems(), model->endSystems(), system);
+    if (it == model->endSystems()) {
+        return false;
+    }
+    observations.push_back({size_t(it - model->beginSystems()), series, weight});
+    return true;
+}
+
+bool Calibrator::isConcurrent() const {
+    // Forks evaluate these flows from their own state; other flows read the shared systems.
+    return std::all_of(model->beginFlows(), model->endFlows(), [](Flow* flow) {
+        return flow->isLinear() || dynamic_cast<ExpressionFlow*>(flow) || dynamic_cast<LookupFlow*>(flow)
+            || dynamic_cast<DelayFlow*>(flow) || dynamic_cast<StochasticFlow*>(flow);
+    });
+}
+
+double Calibrator::objective(Model* run, std::span<const double> values) const {
+    for (size_t p = 0; p < parameters.size(); p++) {
+        run->setParameter(parameters[p].name, values[p]);
+    }
+    vector<TimeSeries::Cursor> cursors(observations.size());
+    double total = 0.0;
+    for (const StepView& view : run->steps(startTime, endTime, timeStep)) {
+        for (size_t o = 0; o < observations.size(); o++) {
+            const Observation& observation = observations[o];
+            double difference = view.values[observation.index] - observation.series->valueAt(cursors[o], view.time);
+            total += observation.weight * difference * difference;
+        }
+    }
+    // Diverging runs must lose every comparison.
+    return std::isnan(total) ? std::numeric_limits<double>::infinity() : total;
+}
+
+void Calibrator::evaluate(Model* origin, const vector<double>& candidates, vector<double>& objectives,
+                          bool concurrent) const {
+    size_t dimensions = parameters.size();
+    size_t count = candidates.size() / dimensions;
+    objectives.resize(count);
+
+    // Forking only copies the state, so every candidate starts from a fresh one.
+    vector<std::unique_ptr<Model>> runs(count);
+    for (size_t i = 0; i < count; i++) {
+        runs[i].reset(origin->fork());
+    }
+    auto evaluateOne = [&](size_t i) {
+        objectives[i] = objective(runs[i].get(), std::span<const double>(candidates.data() + i * dimensions, dimensions));
+    };
+    if (concurrent && count > 1) {
+        ThreadPool::getInstance().parallelFor(count, evaluateOne);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            evaluateOne(i);
+        }
+    }
+}
+
+double Calibrator::evaluate(std::span<const double> values) const {
+    if (values.size() != parameters.size()) {
+        return std::numeric_limits<double>::infinity();
+    }
+    std::unique_ptr<Model> run(model->fork());
+    return objective(run.get(), values);
+}
+
+void Calibrator::clamp(std::span<double> values) const {
+    for (size_t p = 0; p < parameters.size(); p++) {
+        values[p] = std::clamp(values[p], parameters[p].lower, parameters[p].upper);
+    }
+}
+
+bool Calibrator::run(const Settings& settings, Result& result) const {
+    if (parameters.empty()) {
+        return false;
+    }
+    result = Result();
+    auto start = std::chrono::steady_clock::now();
+
+    // The origin holds the values the runs start from, so the model may change while they execute.
+    std::unique_ptr<Model> origin(model->fork());
+    if (settings.method == NELDER_MEAD) {
+        nelderMead(origin.get(), settings, isConcurrent(), result);
+    } else {
+        differentialEvolution(origin.get(), settings, isConcurrent(), result);
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.evaluationsPerSecond = result.seconds > 0.0 ? double(result.evaluations) / result.seconds : 0.0;
+    if (!result.trace.empty()) {
+        result.iterations = result.trace.back().iteration;
+    }
+    return true;
+}
+
+bool Calibrator::apply(const Result& result) const {
+    if (result.parameters.size() != parameters.size()) {
+        return false;
+    }
+    for (size_t p = 0; p < parameters.size(); p++) {
+        model->setParameter(parameters[p].name, result.parameters[p]);
+    }
+    return true;
+}
+
+void Calibrator::differentialEvolution(Model* origin, const Settings& settings, bool concurrent, Result& result) const {
+    auto start = std::chrono::steady_clock::now();
+    size_t dimensions = parameters.size();
+    size_t size = std::max<size_t>(settings.population ? settings.population : 10 * dimensions, 4);
+    std::mt19937_64 random(settings.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<size_t> member(0, size - 1);
+    std::uniform_int_distribution<size_t> dimension(0, dimensions - 1);
+
+    vector<double> population(size * dimensions);
+    for (size_t i = 0; i < size; i++) {
+        for (size_t p = 0; p < dimensions; p++) {
+            const Parameter& parameter = parameters[p];
+            population[i * dimensions + p] = parameter.lower + unit(random) * (parameter.upper - parameter.lower);
+        }
+    }
+    vector<double> objectives;
+    evaluate(origin, population, objectives, concurrent);
+    result.evaluations += size;
+
+    auto record = [&](size_t iteration) {
+        size_t best = size_t(std::min_element(objectives.begin(), objectives.end()) - objectives.begin());
+        result.objective = objectives[best];
+        result.parameters.assign(population.begin() + best * dimensions, population.begin() + (best + 1) * dimensions);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.trace.push_back({iteration, result.evaluations, seconds, result.objective});
+        auto [lowest, highest] = std::minmax_element(objectives.begin(), objectives.end());
+        result.converged = *highest - *lowest <= settings.tolerance;
+    };
+    record(0);
+
+    vector<double> trials(size * dimensions);
+    vector<double> trialObjectives;
+    for (size_t iteration = 1; !result.converged && result.evaluations + size <= settings.maxEvaluations; iteration++) {
+        for (size_t i = 0; i < size; i++) {
+            size_t a, b, c;
+            do { a = member(random); } while (a == i);
+            do { b = member(random); } while (b == i || b == a);
+            do { c = member(random); } while (c == i || c == a || c == b);
+            size_t forced = dimension(random);
+            double* trial = trials.data() + i * dimensions;
+            for (size_t p = 0; p < dimensions; p++) {
+                bool mutate = p == forced || unit(random) < settings.crossover;
+                trial[p] = mutate ? population[a * dimensions + p]
+                                        + settings.mutation * (population[b * dimensions + p] - population[c * dimensions + p])
+                                  : population[i * dimensions + p];
+            }
+            clamp(std::span<double>(trial, dimensions));
+        }
+        evaluate(origin, trials, trialObjectives, concurrent);
+        result.evaluations += size;
+
+        for (size_t i = 0; i < size; i++) {
+            if (trialObjectives[i] <= objectives[i]) {
+                objectives[i] = trialObjectives[i];
+                std::copy(trials.begin() + i * dimensions, trials.begin() + (i + 1) * dimensions,
+                          population.begin() + i * dimensions);
+            }
+        }
+        record(iteration);
+    }
+}
+
+void Calibrator::nelderMead(Model* origin, const Settings& settings, bool concurrent, Result& result) const {
+    auto start = std::chrono::steady_clock::now();
+    size_t dimensions = parameters.size();
+    size_t size = dimensions + 1;
+
+    // The initial simplex starts from the current values, with an edge of a twentieth of each range.
+    vector<double> simplex(size * dimensions);
+    for (size_t p = 0; p < dimensions; p++) {
+        const Parameter& parameter = parameters[p];
+        double value = std::clamp(origin->getParameter(parameter.name), parameter.lower, parameter.upper);
+        double edge = 0.05 * (parameter.upper - parameter.lower);
+        for (size_t i = 0; i < size; i++) {
+            simplex[i * dimensions + p] = value;
+        }
+        simplex[(p + 1) * dimensions + p] = value + edge <= parameter.upper ? value + edge : value - edge;
+    }
+    vector<double> objectives;
+    evaluate(origin, simplex, objectives, concurrent);
+    result.evaluations += size;
+
+    vector<double> single;
+    auto evaluatePoint = [&](const vector<double>& candidate) {
+        evaluate(origin, candidate, single, false);
+        result.evaluations++;
+        return single[0];
+    };
+    auto vertex = [&](size_t i) { return simplex.begin() + i * dimensions; };
+    auto replaceWorst = [&](size_t worst, const vector<double>& candidate, double value) {
+        std::copy(candidate.begin(), candidate.end(), vertex(worst));
+        objectives[worst] = value;
+    };
+
+    vector<size_t> order(size);
+    vector<double> centroid(dimensions);
+    vector<double> reflected(dimensions);
+    vector<double> moved(dimensions);
+    for (size_t iteration = 0;; iteration++) {
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&objectives](size_t a, size_t b) { return objectives[a] < objectives[b]; });
+        size_t best = order.front();
+        size_t worst = order.back();
+        size_t secondWorst = order[size - 2];
+
+        result.objective = objectives[best];
+        result.parameters.assign(vertex(best), vertex(best) + dimensions);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.trace.push_back({iteration, result.evaluations, seconds, result.objective});
+        result.converged = objectives[worst] - objectives[best] <= settings.tolerance;
+        if (result.converged || result.evaluations >= settings.maxEvaluations) {
+            break;
+        }
+
+        std::fill(centroid.begin(), centroid.end(), 0.0);
+        for (size_t i = 0; i < size; i++) {
+            if (i != worst) {
+                for (size_t p = 0; p < dimensions; p++) {
+                    centroid[p] += simplex[i * dimensions + p] / double(dimensions);
+                }
+            }
+        }
+        auto along = [&](double factor, vector<double>& into) {
+            for (size_t p = 0; p < dimensions; p++) {
+                into[p] = centroid[p] + factor * (simplex[worst * dimensions + p] - centroid[p]);
+            }
+            clamp(into);
+        };
+
+        along(-1.0, reflected);
+        double reflectedObjective = evaluatePoint(reflected);
+        if (reflectedObjective < objectives[best]) {
+            along(-2.0, moved);
+            double expandedObjective = evaluatePoint(moved);
+            if (expandedObjective < reflectedObjective) {
+                replaceWorst(worst, moved, expandedObjective);
+            } else {
+                replaceWorst(worst, reflected, reflectedObjective);
+            }
+            continue;
+        }
+        if (reflectedObjective < objectives[secondWorst]) {
+            replaceWorst(worst, reflected, reflectedObjective);
+            continue;
+        }
+
+        // Contract towards the better of the reflected and worst points, or shrink towards the best.
+        bool outside = reflectedObjective < objectives[worst];
+        along(outside ? -0.5 : 0.5, moved);
+        double contractedObjective = evaluatePoint(moved);
+        if (contractedObjective < std::min(reflectedObjective, objectives[worst])) {
+            replaceWorst(worst, moved, contractedObjective);
+            continue;
+        }
+        vector<double> shrunk;
+        shrunk.reserve(dimensions * dimensions);
+        for (size_t i = 0; i < size; i++) {
+            if (i != best) {
+                for (size_t p = 0; p < dimensions; p++) {
+                    shrunk.push_back(simplex[best * dimensions + p] + 0.5 * (simplex[i * dimensions + p] - simplex[best * dimensions + p]));
+                }
+            }
+        }
+        vector<double> shrunkObjectives;
+        evaluate(origin, shrunk, shrunkObjectives, concurrent);
+        result.evaluations += dimensions;
+        for (size_t i = 0, s = 0; i < size; i++) {
+            if (i != best) {
+                std::copy(shrunk.begin() + s * dimensions, shrunk.begin() + (s + 1) * dimensions, vertex(i));
+                objectives[i] = shrunkObjectives[s++];
+            }
+        }
+    }
+}
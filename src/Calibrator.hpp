@@ -0,0 +1,182 @@
+#ifndef CALIBRATOR_HPP
+#define CALIBRATOR_HPP
+
+#include "Model.hpp"
+#include "TimeSeries.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @class Calibrator
+ * @brief Fits model parameters to observed series with derivative-free optimizers.
+ * @details The objective of a candidate is the weighted sum, over the steps of a run and the observations,
+ * of the squared difference between the value of a system and its observed series at that time. Runs do
+ * not rebuild the model: every candidate runs in a fork of it (see Model::fork), which shares its systems,
+ * flows, execution plan and compiled step and only copies the state, so the model is built (and compiled)
+ * once for the whole calibration. The candidates of an iteration are evaluated in parallel on the thread
+ * pool, one fork each.
+ *
+ * Two optimizers are available:
+ * - DIFFERENTIAL_EVOLUTION (rand/1/bin): a population explores the bounds; a whole generation is evaluated
+ *   at once, so it keeps every core busy and suits rugged objectives;
+ * - NELDER_MEAD: a simplex that needs few evaluations on smooth objectives; its initial simplex and shrinks
+ *   are evaluated in parallel, the other moves one at a time.
+ *
+ * Every run reports the number of evaluations, the evaluations per second and the best objective after
+ * each iteration (the convergence trace).
+ *
+ * @code
+ * Calibrator calibrator(model, 0, 365, 1);
+ * calibrator.addParameter("contact", 0.0, 2.0);
+ * calibrator.addParameter("recovery", 0.01, 0.5);
+ * calibrator.addObservation(infected, &reported);
+ * Calibrator::Result result;
+ * calibrator.run(Calibrator::Settings(), result);
+ * calibrator.apply(result);
+ * @endcode
+ *
+ * @note The values at the start of the runs are those of the model when run is called, and the model is
+ * left unchanged until apply. Models whose flows are not all linear, expression, lookup, delay or
+ * stochastic flows are evaluated on the calling thread only, since their forks cannot run concurrently.
+ * @see Model::fork
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class Calibrator {
+    public:
+        /**
+         * @brief Optimization method.
+         */
+        enum Method {
+            DIFFERENTIAL_EVOLUTION,     /**< Differential evolution, rand/1/bin. */
+            NELDER_MEAD                 /**< Nelder-Mead simplex. */
+        };
+
+        /**
+         * @struct Settings
+         * @brief Options of a calibration run.
+         */
+        struct Settings {
+            Method method = DIFFERENTIAL_EVOLUTION;
+            size_t maxEvaluations = 10000;  /**< Stop once this many candidates were evaluated. */
+            double tolerance = 1e-10;       /**< Stop when the objectives of the population or simplex differ less. */
+            size_t population = 0;          /**< Population of differential evolution, or 0 for ten per parameter. */
+            double mutation = 0.7;          /**< Differential weight of differential evolution. */
+            double crossover = 0.9;         /**< Crossover probability of differential evolution. */
+            uint64_t seed = 1;              /**< Seed of the random numbers of differential evolution. */
+        };
+
+        /**
+         * @struct Progress
+         * @brief State of a calibration after one iteration.
+         */
+        struct Progress {
+            size_t iteration;       /**< Generation or simplex move, from 0 for the initial evaluation. */
+            size_t evaluations;     /**< Evaluations so far. */
+            double seconds;         /**< Time elapsed since the start. */
+            double best;            /**< Best objective so far. */
+        };
+
+        /**
+         * @struct Result
+         * @brief Outcome of a calibration run.
+         */
+        struct Result {
+            vector<double> parameters;      /**< Best values found, in the order the parameters were added. */
+            double objective = std::numeric_limits<double>::infinity();    /**< Objective of the best values. */
+            size_t evaluations = 0;
+            size_t iterations = 0;
+            double seconds = 0.0;
+            double evaluationsPerSecond = 0.0;
+            bool converged = false;         /**< Set if the tolerance was reached before the evaluation budget. */
+            vector<Progress> trace;         /**< Progress after each iteration. */
+        };
+
+    private:
+        struct Parameter {
+            string name;
+            double lower;
+            double upper;
+        };
+
+        struct Observation {
+            size_t index;                   /**< Index of the system among the systems of the model. */
+            const TimeSeries* series;
+            double weight;
+        };
+
+        Model* model;
+        int startTime;
+        int endTime;
+        int timeStep;
+        vector<Parameter> parameters;
+        vector<Observation> observations;
+
+        bool isConcurrent() const;
+        double objective(Model* run, std::span<const double> values) const;
+        void evaluate(Model* origin, const vector<double>& candidates, vector<double>& objectives, bool concurrent) const;
+        void clamp(std::span<double> values) const;
+        void differentialEvolution(Model* origin, const Settings& settings, bool concurrent, Result& result) const;
+        void nelderMead(Model* origin, const Settings& settings, bool concurrent, Result& result) const;
+
+    public:
+        /**
+         * @brief Constructs a calibrator of a model.
+         * @param model The model, which must outlive the calibrator.
+         * @param startTime The time at which the runs begin.
+         * @param endTime The time at which the runs end.
+         * @param timeStep The increment in time between the steps of the runs.
+         */
+        Calibrator(Model* model, int startTime, int endTime, int timeStep)
+            : model(model), startTime(startTime), endTime(endTime), timeStep(timeStep) {}
+
+        /**
+         * @brief Adds a parameter to fit.
+         * @param name The name of a model parameter.
+         * @param lower The lowest value allowed.
+         * @param upper The highest value allowed.
+         * @return True if the parameter was added, false if the model has no such parameter or lower > upper.
+         */
+        bool addParameter(const string& name, double lower, double upper);
+
+        /**
+         * @brief Adds an observed series of a system to the objective.
+         * @param system The system.
+         * @param series The observed values, which must outlive the calibrator.
+         * @param weight The weight of the squared differences of the system.
+         * @return True if the observation was added, false if the system is not in the model or the series is null.
+         */
+        bool addObservation(System* system, const TimeSeries* series, double weight = 1.0);
+
+        /**
+         * @brief Computes the objective of some parameter values.
+         * @param values The value of each parameter, in the order they were added.
+         * @return The objective, or infinity if the number of values is wrong.
+         */
+        double evaluate(std::span<const double> values) const;
+
+        /**
+         * @brief Searches for the parameter values of least objective.
+         * @param settings The method and its options.
+         * @param result Receives the best values found, the statistics and the convergence trace.
+         * @return True if the search ran, false if no parameter was added.
+         */
+        bool run(const Settings& settings, Result& result) const;
+
+        /**
+         * @brief Sets the model parameters to the values of a result.
+         * @param result The result of a run.
+         * @return True if the values were set, false if the result does not match the parameters.
+         */
+        bool apply(const Result& result) const;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "CompiledStep.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+/// Writes a double as a C++ literal that reads back exactly.
+static string literal(double value) {
+    if (std::isnan(value)) {
+        return "__builtin_nan(\"\")";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "__builtin_inf()" : "(-__builtin_inf())";
+    }
+    std::ostringstream out;
+    out << std::hexfloat << value;
+    return "(" + out.str() + ")";
+}
+
+/// Quotes a path for the shell: single quotes, with each embedded quote closed, escaped and reopened.
+static string quote(const string& path) {
+    string quoted = "'";
+    for (char c : path) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+static string translate(const Expression& expression) {
+    static const char* binaryOperators[] = {"+", "-", "*", "/"};
+    std::ostringstream out;
+    const vector<Expression::Instruction>& code = expression.getCode();
+    for (size_t i = 0; i < code.size(); i++) {
+        const Expression::Instruction& in = code[i];
+        string a = "r" + std::to_string(in.a);
+        string b = "r" + std::to_string(in.b);
+        out << "        const double r" << i << " = ";
+        switch (in.op) {
+            case Expression::CONSTANT:  out << literal(in.value); break;
+            case Expression::STATE:     out << "state[" << in.a << "]"; break;
+            case Expression::PARAMETER: out << "parameters[" << in.a << "]"; break;
+            case Expression::ADD:
+            case Expression::SUB:
+            case Expression::MUL:
+            case Expression::DIV:
+                out << a << " " << binaryOperators[in.op - Expression::ADD] << " " << b;
+                break;
+            case Expression::POW:       out << "std::pow(" << a << ", " << b << ")"; break;
+            case Expression::MIN:       out << "std::fmin(" << a << ", " << b << ")"; break;
+            case Expression::MAX:       out << "std::fmax(" << a << ", " << b << ")"; break;
+            case Expression::NEG:       out << "-" << a; break;
+            case Expression::EXP:       out << "std::exp(" << a << ")"; break;
+            case Expression::LOG:       out << "std::log(" << a << ")"; break;
+            case Expression::SQRT:      out << "std::sqrt(" << a << ")"; break;
+            case Expression::ABS:       out << "std::fabs(" << a << ")"; break;
+        }
+        out << ";\n";
+    }
+    out << "        const double flow = r" << (code.size() - 1) << ";\n";
+    return out.str();
+}
+
+CompiledStep::~CompiledStep() {
+    dlclose(library);
+}
+
+string CompiledStep::generate(const ExecutionPlan& plan) {
+    std::ostringstream out;
+    out << "// Generated by CompiledStep; do not edit.\n"
+        << "#include <cmath>\n\n"
+        << "extern \"C\" void step(const double* state, const double* parameters, const double* rates, double* changes) {\n"
+        << "    for (unsigned long i = 0; i < " << plan.getLinearOperator().getOrder() << "UL; i++) {\n"
+        << "        changes[i] = 0.0;\n"
+        << "    }\n";
+
+    const vector<ExecutionPlan::FlowEntry>& linearFlows = plan.getLinearFlows();
+    for (size_t k = 0; k < linearFlows.size(); k++) {
+        const ExecutionPlan::FlowEntry& entry = linearFlows[k];
+        out << "    {\n"
+            << "        const double flow = rates[" << k << "] * state[" << entry.source << "];\n"
+            << "        changes[" << entry.source << "] -= flow;\n"
+            << "        changes[" << entry.destination << "] += flow;\n"
+            << "    }\n";
+    }
+
+    for (const ExecutionPlan::ExpressionEntry& expressionEntry : plan.getExpressionFlows()) {
+        out << "    {\n"
+            << translate(expressionEntry.expression)
+            << "        changes[" << expressionEntry.entry.source << "] -= flow;\n"
+            << "        changes[" << expressionEntry.entry.destination << "] += flow;\n"
+            << "    }\n";
+    }
+
+    out << "}\n";
+    return out.str();
+}
+
+CompiledStep* CompiledStep::compile(const ExecutionPlan& plan, const string& directory, const string& name) {
+    if (plan.readsSystems()) {
+        return nullptr;
+    }
+
+    // dlopen returns the already loaded library for a path it has seen, so every build gets its own file.
+    static std::atomic<int> counter{0};
+    string base = directory + "/" + name + "_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+    string sourcePath = base + ".cpp";
+    string libraryPath = base + ".so";
+
+    std::ofstream source(sourcePath);
+    source << generate(plan);
+    source.close();
+    if (!source) {
+        std::remove(sourcePath.c_str());
+        return nullptr;
+    }
+
+    const char* compiler = std::getenv("CXX");
+    string command = string(compiler ? compiler : "g++") + " -std=c++20 -O2 -fPIC -shared -o "
+                     + quote(libraryPath) + " " + quote(sourcePath);
+    int status = std::system(command.c_str());
+    std::remove(sourcePath.c_str());
+    if (status != 0) {
+        std::remove(libraryPath.c_str());
+        return nullptr;
+    }
+
+    // The mapping outlives the file, so the library is removed as soon as it is loaded.
+    void* library = dlopen(libraryPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    std::remove(libraryPath.c_str());
+    if (!library) {
+        return nullptr;
+    }
+    StepFunction function = (StepFunction) dlsym(library, "step");
+    if (!function) {
+        dlclose(library);
+        return nullptr;
+    }
+    return new CompiledStep(library, function);
+}
@@ -0,0 +1,38 @@
+#include "DelayFlow.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+double DelayFlow::equation() const {
+    if (this->getSource()) {
+        return rate * this->getSource()->getValue();
+    }
+    return 0.0;
+}
+
+bool DelayFlow::setDelay(size_t steps, Kind kind, size_t order) {
+    if (steps == 0 || (kind == EXPONENTIAL && (order == 0 || steps < order))) {
+        return false;
+    }
+    this->delay = steps;
+    this->kind = kind;
+    this->order = kind == EXPONENTIAL ? order : 1;
+    contents.assign(kind == PIPELINE ? steps : order, 0.0);
+    head = 0;
+    return true;
+}
+
+void DelayFlow::fill(double outflow) {
+    // In steady state each stage of an exponential delay holds outflow * delay / order.
+    double content = kind == PIPELINE ? outflow : outflow * double(delay) / double(order);
+    std::fill(contents.begin(), contents.end(), content);
+}
+
+double DelayFlow::getInTransit() const {
+    return std::accumulate(contents.begin(), contents.end(), 0.0);
+}
+
+void DelayFlow::setContents(std::span<const double> contents, size_t head) {
+    std::copy(contents.begin(), contents.end(), this->contents.begin());
+    this->head = head;
+}
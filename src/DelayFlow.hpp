@@ -0,0 +1,122 @@
+#ifndef DELAY_FLOW_HPP
+#define DELAY_FLOW_HPP
+
+#include "FlowImpl.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @class DelayFlow
+ * @brief Flow that delivers what leaves its source to its destination after a delay.
+ * @details At every step, `rate * source` leaves the source and enters the delay; the destination
+ * receives what leaves the delay. Quantities in transit are kept inside the flow rather than in extra
+ * systems, so long delays do not add systems to the model:
+ * - a PIPELINE delay (material delay of fixed duration) delivers each entry exactly `delay` steps later.
+ *   The quantities in transit are held in a ring buffer of `delay` slots, so a step costs O(1) whatever
+ *   the delay;
+ * - an EXPONENTIAL delay of order n (DELAY1 for n = 1, DELAY3 for n = 3) passes the entries through n
+ *   stages, each draining `n / delay` of its content per step, for an average delay of `delay` steps.
+ *   A step costs O(n). The delay must be at least n steps.
+ *
+ * Like the values of systems, the contents of the delay persist from one run to the next; the model
+ * works on its own copy during a run and stores it back in the flow when the run ends.
+ *
+ * @code
+ * DelayFlow* shipping = model->createFlow<DelayFlow>("shipping", orders, deliveries);
+ * shipping->setRate(0.2);
+ * shipping->setDelay(30);                             // pipeline of 30 steps
+ * shipping->setDelay(12, DelayFlow::EXPONENTIAL, 3);   // or DELAY3 of 12 steps
+ * @endcode
+ *
+ * @see ExecutionPlan
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class DelayFlow : public FlowHandle {
+    public:
+        /**
+         * @brief Shapes of delay.
+         */
+        enum Kind {
+            PIPELINE,       /**< Fixed delay: entries leave exactly `delay` steps later. */
+            EXPONENTIAL     /**< Cascade of `order` first-order stages with an average delay of `delay` steps. */
+        };
+
+    private:
+        double rate = 0.0;          /**< Fraction of the source entering the delay per step. */
+        size_t delay = 1;           /**< Duration of the delay, in steps. */
+        Kind kind = PIPELINE;       /**< Shape of the delay. */
+        size_t order = 1;           /**< Number of stages of an exponential delay. */
+        vector<double> contents;    /**< Ring buffer of a pipeline, or stages of an exponential delay. */
+        size_t head = 0;            /**< Slot of the pipeline whose content leaves at the next step. */
+
+    public:
+        DelayFlow(const string& name = "", System* source = nullptr, System* destination = nullptr)
+            : FlowHandle(name, source, destination), contents(1, 0.0) {}
+
+        /**
+         * @brief Gets the quantity entering the delay at this step.
+         * @return `rate` times the value of the source.
+         */
+        double equation() const override;
+
+        double getRate() const override { return rate; }
+
+        /**
+         * @brief Sets the fraction of the source entering the delay per step.
+         * @param rate The fraction.
+         */
+        void setRate(double rate) { this->rate = rate; }
+
+        /**
+         * @brief Sets the duration and shape of the delay, emptying it.
+         * @param steps The duration of the delay, in steps (at least one, and at least `order` for exponential delays).
+         * @param kind The shape of the delay.
+         * @param order The number of stages of an exponential delay.
+         * @return True if the delay was set, false if the duration is too short for the order.
+         */
+        bool setDelay(size_t steps, Kind kind = PIPELINE, size_t order = 1);
+
+        size_t getDelay() const { return delay; }
+        Kind getKind() const { return kind; }
+        size_t getOrder() const { return order; }
+
+        /**
+         * @brief Fills the delay with its steady state for a constant outflow.
+         * @param outflow The quantity leaving the delay per step.
+         * @return None.
+         */
+        void fill(double outflow);
+
+        /**
+         * @brief Gets the total quantity in transit.
+         * @return The sum of the contents of the delay.
+         */
+        double getInTransit() const;
+
+        /**
+         * @brief Gets the contents of the delay: its ring buffer, or its stages.
+         * @return The contents, whose size is the delay of a pipeline or the order of an exponential delay.
+         */
+        const vector<double>& getContents() const { return contents; }
+
+        /**
+         * @brief Gets the slot of a pipeline whose content leaves the delay at the next step.
+         * @return The slot index.
+         */
+        size_t getHead() const { return head; }
+
+        /**
+         * @brief Replaces the contents of the delay, as left by a run.
+         * @param contents The contents; must have the size of getContents.
+         * @param head The slot of a pipeline whose content leaves at the next step.
+         * @return None.
+         */
+        void setContents(std::span<const double> contents, size_t head);
+};
+
+#endif
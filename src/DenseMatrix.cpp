@@ -0,0 +1,56 @@
+#include "DenseMatrix.hpp"
+
+DenseMatrix::DenseMatrix(size_t order) : order(order), elements(order * order, 0.0) {}
+
+DenseMatrix DenseMatrix::identity(size_t order) {
+    DenseMatrix matrix(order);
+    for (size_t i = 0; i < order; i++) {
+        matrix(i, i) = 1.0;
+    }
+    return matrix;
+}
+
+DenseMatrix DenseMatrix::operator*(const DenseMatrix& other) const {
+    DenseMatrix product(order);
+    // i-k-j order keeps the innermost loop contiguous in both operands.
+    for (size_t i = 0; i < order; i++) {
+        double* row = &product.elements[i * order];
+        for (size_t k = 0; k < order; k++) {
+            double a = elements[i * order + k];
+            if (a == 0.0) {
+                continue;
+            }
+            const double* otherRow = &other.elements[k * order];
+            for (size_t j = 0; j < order; j++) {
+                row[j] += a * otherRow[j];
+            }
+        }
+    }
+    return product;
+}
+
+void DenseMatrix::apply(vector<double>& x) const {
+    vector<double> result(order, 0.0);
+    for (size_t i = 0; i < order; i++) {
+        const double* row = &elements[i * order];
+        double sum = 0.0;
+        for (size_t j = 0; j < order; j++) {
+            sum += row[j] * x[j];
+        }
+        result[i] = sum;
+    }
+    x.swap(result);
+}
+
+void DenseMatrix::applyPower(vector<double>& x, long long n) const {
+    DenseMatrix square = *this;
+    while (n > 0) {
+        if (n & 1) {
+            square.apply(x);
+        }
+        n >>= 1;
+        if (n > 0) {
+            square = square * square;
+        }
+    }
+}
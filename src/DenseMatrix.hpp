@@ -0,0 +1,68 @@
+#ifndef DENSE_MATRIX_HPP
+#define DENSE_MATRIX_HPP
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @class DenseMatrix
+ * @brief Square row-major matrix used as the step operator of linear models.
+ * @details When every flow of a model is linear, one Euler step is the product `x' = M x` with 
+ * `M = I + A`, where A holds the flow rates. DenseMatrix provides the operations needed to apply 
+ * `M^n` to a state vector in O(log n) matrix products by repeated squaring.
+ * 
+ * @see Model::fastForward
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class DenseMatrix {
+    private:
+        size_t order;               /**< Number of rows and columns. */
+        vector<double> elements;    /**< Elements in row-major order. */
+
+    public:
+        /**
+         * @brief Constructs a zero matrix.
+         * @param order The number of rows and columns.
+         */
+        explicit DenseMatrix(size_t order = 0);
+
+        /**
+         * @brief Constructs an identity matrix.
+         * @param order The number of rows and columns.
+         * @return The identity matrix of the given order.
+         */
+        static DenseMatrix identity(size_t order);
+
+        size_t getOrder() const { return order; }
+
+        double& operator()(size_t row, size_t column) { return elements[row * order + column]; }
+        double operator()(size_t row, size_t column) const { return elements[row * order + column]; }
+
+        /**
+         * @brief Multiplies two matrices of the same order.
+         * @param other The right-hand side operand.
+         * @return The product `this * other`.
+         */
+        DenseMatrix operator*(const DenseMatrix& other) const;
+
+        /**
+         * @brief Multiplies the matrix by a vector in place.
+         * @param x The vector, replaced by `this * x`.
+         * @return None.
+         */
+        void apply(vector<double>& x) const;
+
+        /**
+         * @brief Multiplies the n-th power of the matrix by a vector in place.
+         * @details Uses repeated squaring, so only O(log n) matrix products are computed.
+         * @param x The vector, replaced by `this^n * x`.
+         * @param n The power.
+         * @return None.
+         */
+        void applyPower(vector<double>& x, long long n) const;
+};
+
+#endif
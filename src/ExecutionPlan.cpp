@@ -0,0 +1,519 @@
+#include "ExecutionPlan.hpp"
+#include "ExpressionFlow.hpp"
+#include "DelayFlow.hpp"
+#include "LookupFlow.hpp"
+#include "StochasticFlow.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+void ExecutionPlan::build(const vector<System*>& systems, const vector<Flow*>& flows) {
+    indices.clear();
+    indices.reserve(systems.size());
+    for (size_t i = 0; i < systems.size(); i++) {
+        indices[systems[i]] = i;
+    }
+
+    linearFlows.clear();
+    expressionFlows.clear();
+    lookupGroups.clear();
+    delayFlows.clear();
+    stochasticFlows.clear();
+    genericFlows.clear();
+    for (Flow* flow : flows) {
+        addFlow(flow);
+    }
+    assembleOperator();
+}
+
+bool ExecutionPlan::addFlow(Flow* flow) {
+    long source = indexOf(flow->getSource());
+    long destination = indexOf(flow->getDestination());
+    if (source < 0 || destination < 0) {
+        return false;
+    }
+
+    FlowEntry entry{flow, size_t(source), size_t(destination)};
+    if (flow->isLinear()) {
+        linearFlows.push_back(entry);
+        operatorOutdated = true;
+    } else if (dynamic_cast<LookupFlow*>(flow)) {
+        return addLookup(entry);
+    } else if (DelayFlow* delay = dynamic_cast<DelayFlow*>(flow)) {
+        delayFlows.push_back({entry, delay});
+    } else if (StochasticFlow* stochastic = dynamic_cast<StochasticFlow*>(flow)) {
+        stochasticFlows.push_back({entry, stochastic, stochastic->getStream()});
+    } else if (dynamic_cast<ExpressionFlow*>(flow)) {
+        return linkExpression(entry);
+    } else {
+        genericFlows.push_back(entry);
+    }
+    return true;
+}
+
+void ExecutionPlan::removeFlow(Flow* flow) {
+    auto isFlow = [flow](const FlowEntry& entry) { return entry.flow == flow; };
+    if (std::erase_if(linearFlows, isFlow) > 0) {
+        operatorOutdated = true;
+    }
+    std::erase_if(expressionFlows, [flow](const ExpressionEntry& entry) { return entry.entry.flow == flow; });
+    for (LookupGroup& group : lookupGroups) {
+        for (size_t k = 0; k < group.flows.size(); k++) {
+            if (group.flows[k].flow == flow) {
+                group.flows.erase(group.flows.begin() + k);
+                group.inputs.erase(group.inputs.begin() + k);
+                break;
+            }
+        }
+    }
+    std::erase_if(lookupGroups, [](const LookupGroup& group) { return group.flows.empty(); });
+    std::erase_if(delayFlows, [flow](const DelayEntry& entry) { return entry.entry.flow == flow; });
+    std::erase_if(stochasticFlows, [flow](const StochasticEntry& entry) { return entry.entry.flow == flow; });
+    std::erase_if(genericFlows, isFlow);
+}
+
+bool ExecutionPlan::update() {
+    if (operatorOutdated) {
+        assembleOperator();
+    }
+    if (lookupsOutdated()) {
+        vector<FlowEntry> entries;
+        for (const LookupGroup& group : lookupGroups) {
+            entries.insert(entries.end(), group.flows.begin(), group.flows.end());
+        }
+        lookupGroups.clear();
+        for (const FlowEntry& entry : entries) {
+            addLookup(entry);
+        }
+    }
+    if (expressionsOutdated()) {
+        vector<FlowEntry> entries;
+        for (const ExpressionEntry& expressionEntry : expressionFlows) {
+            entries.push_back(expressionEntry.entry);
+        }
+        expressionFlows.clear();
+        for (const FlowEntry& entry : entries) {
+            linkExpression(entry);
+        }
+        return true;
+    }
+    return false;
+}
+
+void ExecutionPlan::assembleOperator() {
+    vector<SparseMatrix::Triplet> triplets;
+    triplets.reserve(2 * linearFlows.size());
+    for (const FlowEntry& entry : linearFlows) {
+        triplets.push_back({entry.source, entry.source, 0.0});
+        triplets.push_back({entry.destination, entry.source, 0.0});
+    }
+    linearOperator.assemble(indices.size(), triplets);
+
+    rates.clear();
+    ratePositions.clear();
+    ratePositions.reserve(2 * linearFlows.size());
+    for (const FlowEntry& entry : linearFlows) {
+        ratePositions.push_back(linearOperator.find(entry.source, entry.source));
+        ratePositions.push_back(linearOperator.find(entry.destination, entry.source));
+    }
+    operatorOutdated = false;
+    refreshRates();
+}
+
+bool ExecutionPlan::linkExpression(const FlowEntry& entry) {
+    const ExpressionFlow* flow = dynamic_cast<const ExpressionFlow*>(entry.flow);
+    const vector<ExpressionFlow::Symbol>& symbols = flow->getBoundSymbols();
+    if (!flow->isBound()) {
+        return false;
+    }
+
+    vector<Expression::Binding> bindings;
+    for (const ExpressionFlow::Symbol& symbol : symbols) {
+        switch (symbol.kind) {
+            case ExpressionFlow::SOURCE:
+                bindings.push_back({false, entry.source});
+                break;
+            case ExpressionFlow::DESTINATION:
+                bindings.push_back({false, entry.destination});
+                break;
+            case ExpressionFlow::SYSTEM: {
+                long index = indexOf(symbol.system);
+                if (index < 0) {
+                    return false;
+                }
+                bindings.push_back({false, size_t(index)});
+                break;
+            }
+            case ExpressionFlow::PARAMETER:
+                bindings.push_back({true, symbol.parameter});
+                break;
+        }
+    }
+    expressionFlows.push_back({entry, flow->getExpression().link(bindings), flow->getVersion()});
+    return true;
+}
+
+bool ExecutionPlan::addLookup(const FlowEntry& entry) {
+    const LookupFlow* flow = static_cast<const LookupFlow*>(entry.flow);
+    long input = indexOf(flow->getInput());
+    if (input < 0) {
+        return false;
+    }
+
+    auto group = std::find_if(lookupGroups.begin(), lookupGroups.end(),
+                              [flow](const LookupGroup& group) { return group.table.shares(flow->getTable()); });
+    if (group == lookupGroups.end()) {
+        group = lookupGroups.insert(lookupGroups.end(), {flow->getTable(), {}, {}});
+    }
+    group->flows.push_back(entry);
+    group->inputs.push_back(size_t(input));
+    return true;
+}
+
+bool ExecutionPlan::lookupsOutdated() const {
+    for (const LookupGroup& group : lookupGroups) {
+        for (size_t k = 0; k < group.flows.size(); k++) {
+            const LookupFlow* flow = static_cast<const LookupFlow*>(group.flows[k].flow);
+            if (!flow->getTable().shares(group.table) || indexOf(flow->getInput()) != long(group.inputs[k])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ExecutionPlan::expressionsOutdated() const {
+    for (const ExpressionEntry& expressionEntry : expressionFlows) {
+        if (static_cast<const ExpressionFlow*>(expressionEntry.entry.flow)->getVersion() != expressionEntry.version) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ExecutionPlan::refreshRates() {
+    // Plans are shared by forked models, so nothing is written unless a rate actually changed.
+    bool changed = rates.size() != linearFlows.size();
+    for (size_t i = 0; i < linearFlows.size() && !changed; i++) {
+        changed = rates[i] != linearFlows[i].flow->getRate();
+    }
+    if (!changed) {
+        return;
+    }
+
+    vector<double>& values = linearOperator.getValues();
+    std::fill(values.begin(), values.end(), 0.0);
+    rates.resize(linearFlows.size());
+    for (size_t i = 0; i < linearFlows.size(); i++) {
+        double rate = linearFlows[i].flow->getRate();
+        rates[i] = rate;
+        values[ratePositions[2 * i]] -= rate;
+        values[ratePositions[2 * i + 1]] += rate;
+    }
+}
+
+void ExecutionPlan::accumulate(const vector<double>& state, const vector<double>& parameters,
+                               vector<double>& changes) const {
+    linearOperator.multiply(state.data(), changes.data());
+
+    for (const ExpressionEntry& expressionEntry : expressionFlows) {
+        double flowValue = expressionEntry.expression.evaluate(state.data(), parameters.data());
+        changes[expressionEntry.entry.source] -= flowValue;
+        changes[expressionEntry.entry.destination] += flowValue;
+    }
+
+    accumulateLookups(state, changes);
+
+    for (const FlowEntry& entry : genericFlows) {
+        double flowValue = entry.flow->equation();
+        changes[entry.source] -= flowValue;
+        changes[entry.destination] += flowValue;
+    }
+}
+
+void ExecutionPlan::accumulateLookups(const vector<double>& state, vector<double>& changes) const {
+    // Plans are shared by forks running on several threads, so the gathered inputs are per thread.
+    thread_local vector<double> inputs;
+    thread_local vector<double> outputs;
+    for (const LookupGroup& group : lookupGroups) {
+        size_t count = group.flows.size();
+        inputs.resize(count);
+        outputs.resize(count);
+        for (size_t k = 0; k < count; k++) {
+            inputs[k] = state[group.inputs[k]];
+        }
+        group.table.evaluate(inputs, outputs);
+        for (size_t k = 0; k < count; k++) {
+            changes[group.flows[k].source] -= outputs[k];
+            changes[group.flows[k].destination] += outputs[k];
+        }
+    }
+}
+
+void ExecutionPlan::accumulateTangents(const vector<double>& state, const vector<double>& parameters, uint64_t run,
+                                       int time, const double* stateTangents, const double* parameterTangents,
+                                       const vector<RateSeed>& rateSeeds, size_t directions, double* changes) const {
+    size_t k = directions;
+    std::fill(changes, changes + indices.size() * k, 0.0);
+    auto transfer = [changes, k](const FlowEntry& entry, const double* flowTangent) {
+        double* source = changes + entry.source * k;
+        double* destination = changes + entry.destination * k;
+        for (size_t j = 0; j < k; j++) {
+            source[j] -= flowTangent[j];
+            destination[j] += flowTangent[j];
+        }
+    };
+
+    thread_local vector<double> flowTangent;
+    thread_local vector<double> partials;
+    flowTangent.resize(k);
+
+    for (size_t l = 0; l < linearFlows.size(); l++) {
+        const double* tangent = stateTangents + linearFlows[l].source * k;
+        for (size_t j = 0; j < k; j++) {
+            flowTangent[j] = rates[l] * tangent[j];
+        }
+        transfer(linearFlows[l], flowTangent.data());
+    }
+    for (const RateSeed& seed : rateSeeds) {
+        const FlowEntry& entry = linearFlows[seed.flow];
+        changes[entry.source * k + seed.direction] -= state[entry.source];
+        changes[entry.destination * k + seed.direction] += state[entry.source];
+    }
+
+    for (const ExpressionEntry& expressionEntry : expressionFlows) {
+        // The derivative with respect to each load, chained with the tangents of what it loads.
+        const vector<Expression::Instruction>& code = expressionEntry.expression.getCode();
+        partials.resize(code.size());
+        expressionEntry.expression.differentiate(state.data(), parameters.data(), partials.data());
+        std::fill(flowTangent.begin(), flowTangent.end(), 0.0);
+        for (size_t i = 0; i < code.size(); i++) {
+            if (partials[i] == 0.0 || (code[i].op != Expression::STATE && code[i].op != Expression::PARAMETER)) {
+                continue;
+            }
+            const double* tangent = code[i].op == Expression::STATE ? stateTangents + code[i].a * k
+                                                                    : parameterTangents + code[i].a * k;
+            for (size_t j = 0; j < k; j++) {
+                flowTangent[j] += partials[i] * tangent[j];
+            }
+        }
+        transfer(expressionEntry.entry, flowTangent.data());
+    }
+
+    for (const LookupGroup& group : lookupGroups) {
+        for (size_t f = 0; f < group.flows.size(); f++) {
+            size_t input = group.inputs[f];
+            double slope = group.table.slope(state[input]);
+            const double* tangent = stateTangents + input * k;
+            for (size_t j = 0; j < k; j++) {
+                flowTangent[j] = slope * tangent[j];
+            }
+            transfer(group.flows[f], flowTangent.data());
+        }
+    }
+
+    // With the noise of the step drawn, a proportional flow is linear in its source; the others are constant.
+    for (const StochasticEntry& stochasticEntry : stochasticFlows) {
+        const StochasticFlow* flow = stochasticEntry.flow;
+        if (!flow->isProportional()) {
+            continue;
+        }
+        double rate = flow->value(StochasticFlow::draw(stochasticEntry.stream, run, time, flow->getDistribution()), 1.0);
+        const double* tangent = stateTangents + stochasticEntry.entry.source * k;
+        for (size_t j = 0; j < k; j++) {
+            flowTangent[j] = rate * tangent[j];
+        }
+        transfer(stochasticEntry.entry, flowTangent.data());
+    }
+}
+
+void ExecutionPlan::accumulateAdjoints(const vector<double>& state, const vector<double>& parameters, uint64_t run,
+                                       int time, const double* adjoints, double* stateAdjoints,
+                                       double* parameterAdjoints, double* rateAdjoints) const {
+    auto flowAdjoint = [adjoints](const FlowEntry& entry) {
+        return adjoints[entry.destination] - adjoints[entry.source];
+    };
+
+    for (size_t l = 0; l < linearFlows.size(); l++) {
+        const FlowEntry& entry = linearFlows[l];
+        double adjoint = flowAdjoint(entry);
+        stateAdjoints[entry.source] += rates[l] * adjoint;
+        rateAdjoints[l] += state[entry.source] * adjoint;
+    }
+
+    thread_local vector<double> partials;
+    for (const ExpressionEntry& expressionEntry : expressionFlows) {
+        double adjoint = flowAdjoint(expressionEntry.entry);
+        if (adjoint == 0.0) {
+            continue;
+        }
+        const vector<Expression::Instruction>& code = expressionEntry.expression.getCode();
+        partials.resize(code.size());
+        expressionEntry.expression.differentiate(state.data(), parameters.data(), partials.data());
+        for (size_t i = 0; i < code.size(); i++) {
+            if (code[i].op == Expression::STATE) {
+                stateAdjoints[code[i].a] += partials[i] * adjoint;
+            } else if (code[i].op == Expression::PARAMETER) {
+                parameterAdjoints[code[i].a] += partials[i] * adjoint;
+            }
+        }
+    }
+
+    for (const LookupGroup& group : lookupGroups) {
+        for (size_t f = 0; f < group.flows.size(); f++) {
+            size_t input = group.inputs[f];
+            stateAdjoints[input] += group.table.slope(state[input]) * flowAdjoint(group.flows[f]);
+        }
+    }
+
+    for (const StochasticEntry& stochasticEntry : stochasticFlows) {
+        const StochasticFlow* flow = stochasticEntry.flow;
+        if (flow->isProportional()) {
+            double noise = StochasticFlow::draw(stochasticEntry.stream, run, time, flow->getDistribution());
+            stateAdjoints[stochasticEntry.entry.source] += flow->value(noise, 1.0) * flowAdjoint(stochasticEntry.entry);
+        }
+    }
+}
+
+void ExecutionPlan::loadDelays(DelayState& delays, bool keep) const {
+    DelayState loaded;
+    loaded.flows.reserve(delayFlows.size());
+    loaded.offsets.reserve(delayFlows.size() + 1);
+    loaded.heads.reserve(delayFlows.size());
+
+    std::unordered_map<DelayFlow*, size_t> previous;
+    if (keep) {
+        for (size_t i = 0; i < delays.flows.size(); i++) {
+            previous.emplace(delays.flows[i], i);
+        }
+    }
+
+    for (const DelayEntry& delayEntry : delayFlows) {
+        DelayFlow* delay = delayEntry.delay;
+        const vector<double>& stored = delay->getContents();
+        auto it = previous.find(delay);
+        loaded.flows.push_back(delay);
+        loaded.offsets.push_back(loaded.contents.size());
+        if (it != previous.end() && delays.offsets[it->second + 1] - delays.offsets[it->second] == stored.size()) {
+            auto begin = delays.contents.begin() + delays.offsets[it->second];
+            loaded.contents.insert(loaded.contents.end(), begin, begin + stored.size());
+            loaded.heads.push_back(delays.heads[it->second]);
+        } else {
+            loaded.contents.insert(loaded.contents.end(), stored.begin(), stored.end());
+            loaded.heads.push_back(delay->getHead());
+        }
+    }
+    loaded.offsets.push_back(loaded.contents.size());
+    delays = std::move(loaded);
+}
+
+void ExecutionPlan::storeDelays(const DelayState& delays) const {
+    for (size_t i = 0; i < delays.flows.size(); i++) {
+        DelayFlow* delay = delays.flows[i];
+        size_t size = delays.offsets[i + 1] - delays.offsets[i];
+        if (delay->getContents().size() == size) {
+            delay->setContents(std::span<const double>(delays.contents.data() + delays.offsets[i], size), delays.heads[i]);
+        }
+    }
+}
+
+void ExecutionPlan::advanceDelays(const vector<double>& state, DelayState& delays, vector<double>& changes) const {
+    for (size_t i = 0; i < delayFlows.size(); i++) {
+        const DelayEntry& delayEntry = delayFlows[i];
+        const DelayFlow* delay = delayEntry.delay;
+        double* contents = delays.contents.data() + delays.offsets[i];
+        size_t size = delays.offsets[i + 1] - delays.offsets[i];
+        double inflow = delay->getRate() * state[delayEntry.entry.source];
+        double outflow;
+
+        if (delay->getKind() == DelayFlow::PIPELINE) {
+            // What entered `size` steps ago leaves, and the entry takes its slot.
+            size_t& head = delays.heads[i];
+            outflow = contents[head];
+            contents[head] = inflow;
+            head = head + 1 == size ? 0 : head + 1;
+        } else {
+            double drain = double(size) / double(delay->getDelay());
+            outflow = inflow;
+            for (size_t stage = 0; stage < size; stage++) {
+                double leaving = drain * contents[stage];
+                contents[stage] += outflow - leaving;
+                outflow = leaving;
+            }
+        }
+
+        changes[delayEntry.entry.source] -= inflow;
+        changes[delayEntry.entry.destination] += outflow;
+    }
+}
+
+void ExecutionPlan::accumulateNoise(const vector<double>& state, uint64_t run, int time, vector<double>& changes) const {
+    thread_local vector<double> noise;
+    noise.resize(stochasticFlows.size());
+    for (size_t i = 0; i < stochasticFlows.size(); i++) {
+        const StochasticEntry& stochasticEntry = stochasticFlows[i];
+        noise[i] = StochasticFlow::draw(stochasticEntry.stream, run, time, stochasticEntry.flow->getDistribution());
+    }
+    for (size_t i = 0; i < stochasticFlows.size(); i++) {
+        const FlowEntry& entry = stochasticFlows[i].entry;
+        double value = stochasticFlows[i].flow->value(noise[i], state[entry.source]);
+        changes[entry.source] -= value;
+        changes[entry.destination] += value;
+    }
+}
+
+/// Optimization barrier: the value must be computed before this point and cannot move across it.
+static inline void keep(double value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+void ExecutionPlan::profile(const vector<double>& state, const vector<double>& parameters, uint64_t run, int time,
+                            vector<FlowTiming>& timings) const {
+    // Each value passes a barrier before the second clock reading, so its evaluation stays between them.
+    auto elapsed = [](auto&& evaluate) {
+        auto start = std::chrono::steady_clock::now();
+        keep(evaluate());
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    };
+    // The cost of reading the clock is measured on an empty evaluation and left out of the timings.
+    double overhead = std::numeric_limits<double>::max();
+    for (int i = 0; i < 8; i++) {
+        overhead = std::min(overhead, elapsed([] { return 0.0; }));
+    }
+    auto measure = [&](const Flow* flow, auto&& evaluate) {
+        timings.push_back({flow, std::max(elapsed(evaluate) - overhead, 0.0)});
+    };
+
+    timings.clear();
+    for (size_t l = 0; l < linearFlows.size(); l++) {
+        measure(linearFlows[l].flow, [&] { return rates[l] * state[linearFlows[l].source]; });
+    }
+    for (const ExpressionEntry& expressionEntry : expressionFlows) {
+        measure(expressionEntry.entry.flow, [&] { return expressionEntry.expression.evaluate(state.data(), parameters.data()); });
+    }
+    for (const LookupGroup& group : lookupGroups) {
+        for (size_t f = 0; f < group.flows.size(); f++) {
+            measure(group.flows[f].flow, [&] { return group.table(state[group.inputs[f]]); });
+        }
+    }
+    for (const DelayEntry& delayEntry : delayFlows) {
+        measure(delayEntry.entry.flow, [&] { return delayEntry.delay->getRate() * state[delayEntry.entry.source]; });
+    }
+    for (const StochasticEntry& stochasticEntry : stochasticFlows) {
+        measure(stochasticEntry.entry.flow, [&] {
+            const StochasticFlow* flow = stochasticEntry.flow;
+            double noise = StochasticFlow::draw(stochasticEntry.stream, run, time, flow->getDistribution());
+            return flow->value(noise, state[stochasticEntry.entry.source]);
+        });
+    }
+    for (const FlowEntry& entry : genericFlows) {
+        measure(entry.flow, [&] { return entry.flow->equation(); });
+    }
+}
+
+long ExecutionPlan::indexOf(System* system) const {
+    auto it = indices.find(system);
+    return it == indices.end() ? -1 : long(it->second);
+}
@@ -0,0 +1,332 @@
+#ifndef EXECUTION_PLAN_HPP
+#define EXECUTION_PLAN_HPP
+
+#include "Flow.hpp"
+#include "System.hpp"
+#include "SparseMatrix.hpp"
+#include "Expression.hpp"
+#include "LookupTable.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using std::vector;
+
+class DelayFlow;
+class StochasticFlow;
+
+/**
+ * @class ExecutionPlan
+ * @brief Flattened form of a model's topology used by the step loop.
+ * @details The plan resolves the source and destination of every flow to indices of the state vector once, 
+ * instead of searching the systems at every step. Linear flows (see Flow::isLinear) are lowered into a CSR 
+ * matrix whose product with the state gives their whole contribution to a step. Expression flows are linked 
+ * to the state and parameter vectors and evaluated by the bytecode interpreter. The remaining flows keep 
+ * calling their virtual `equation` on the generic path. Lookup flows (see LookupFlow) are grouped by table 
+ * and each table is evaluated once per step for all its flows. Delay flows (see DelayFlow) take what leaves their 
+ * source from the state and advance their contents, which are held in a DelayState owned by the model 
+ * so that forks sharing the plan keep their own quantities in transit.
+ * 
+ * Flows added to or removed from a built plan only update the part of the plan they belong to: expression 
+ * and generic flows are linked or unlinked on their own, and the linear operator is reassembled once, at 
+ * the next update, when linear flows changed; so are expressions edited after they were linked. Changing 
+ * the systems requires a new build.
+ * 
+ * Flows without a source or a destination, or connected to systems outside the model, do not take part 
+ * in the execution, as before; neither do expression flows referencing such systems.
+ * 
+ * @see ModelBody
+ * @see SparseMatrix
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class ExecutionPlan {
+    public:
+        /**
+         * @struct FlowEntry
+         * @brief A flow together with the state indices of its systems.
+         */
+        struct FlowEntry {
+            Flow* flow;             /**< The flow. */
+            size_t source;          /**< Index of the source system in the state vector. */
+            size_t destination;     /**< Index of the destination system in the state vector. */
+        };
+
+        /**
+         * @struct ExpressionEntry
+         * @brief An expression flow with its expression linked to the state and parameter vectors.
+         */
+        struct ExpressionEntry {
+            FlowEntry entry;            /**< The flow and its systems. */
+            Expression expression;      /**< The linked expression. */
+            unsigned long version;      /**< Version of the expression of the flow when it was linked. */
+        };
+
+        /**
+         * @struct LookupGroup
+         * @brief Lookup flows sharing one table, evaluated together.
+         */
+        struct LookupGroup {
+            LookupTable table;          /**< The shared table. */
+            vector<FlowEntry> flows;    /**< The flows and their systems. */
+            vector<size_t> inputs;      /**< Index of the input of each flow in the state vector. */
+        };
+
+        /**
+         * @struct DelayEntry
+         * @brief A delay flow with the state indices of its systems.
+         */
+        struct DelayEntry {
+            FlowEntry entry;            /**< The flow and its systems. */
+            DelayFlow* delay;           /**< The flow as a DelayFlow. */
+        };
+
+        /**
+         * @struct StochasticEntry
+         * @brief A stochastic flow with the state indices of its systems and the key of its numbers.
+         */
+        struct StochasticEntry {
+            FlowEntry entry;            /**< The flow and its systems. */
+            StochasticFlow* flow;       /**< The flow as a StochasticFlow. */
+            uint64_t stream;            /**< Key of the random numbers of the flow. */
+        };
+
+        /**
+         * @struct FlowTiming
+         * @brief Time taken to evaluate one flow.
+         */
+        struct FlowTiming {
+            const Flow* flow;           /**< The flow. */
+            double nanoseconds;         /**< Time of its evaluation. */
+        };
+
+        /**
+         * @struct RateSeed
+         * @brief A linear flow whose rate is a direction of differentiation.
+         */
+        struct RateSeed {
+            size_t flow;            /**< Index of the flow among the linear flows. */
+            size_t direction;       /**< The direction. */
+        };
+
+        /**
+         * @struct DelayState
+         * @brief Contents of the delay flows of a plan during a run, in the order of the plan.
+         */
+        struct DelayState {
+            vector<DelayFlow*> flows;           /**< Flow owning each block of contents. */
+            vector<size_t> offsets;             /**< Start of the contents of each flow, plus the end of the last one. */
+            vector<double> contents;            /**< Ring buffers and stages of all the delays, one block per flow. */
+            vector<size_t> heads;               /**< Head of the ring buffer of each flow. */
+        };
+
+    private:
+        std::unordered_map<System*, size_t> indices;    /**< Index of each system in the state vector. */
+        vector<FlowEntry> linearFlows;                  /**< Flows lowered into the linear operator. */
+        vector<double> rates;                           /**< Rate of each linear flow. */
+        vector<size_t> ratePositions;                   /**< Two operator positions per linear flow. */
+        SparseMatrix linearOperator;                    /**< Contribution of the linear flows: changes = A x. */
+        vector<ExpressionEntry> expressionFlows;        /**< Flows evaluated by the bytecode interpreter. */
+        vector<LookupGroup> lookupGroups;               /**< Lookup flows, by table. */
+        vector<DelayEntry> delayFlows;                  /**< Flows holding quantities in transit. */
+        vector<StochasticEntry> stochasticFlows;        /**< Flows with random noise. */
+        vector<FlowEntry> genericFlows;                 /**< Flows evaluated through `equation`. */
+        bool operatorOutdated = false;                  /**< Set when linear flows change, until the operator is reassembled. */
+
+        bool linkExpression(const FlowEntry& entry);
+        bool addLookup(const FlowEntry& entry);
+        bool lookupsOutdated() const;
+        bool expressionsOutdated() const;
+        void assembleOperator();
+
+    public:
+        /**
+         * @brief Builds the plan for the given systems and flows.
+         * @param systems The systems of the model, in state vector order.
+         * @param flows The flows of the model.
+         * @return None.
+         */
+        void build(const vector<System*>& systems, const vector<Flow*>& flows);
+
+        /**
+         * @brief Adds a flow to a built plan.
+         * @param flow The flow, whose systems must belong to the plan.
+         * @return True if the flow takes part in the execution, false if it is ignored like in build.
+         * 
+         * @note A linear flow only takes effect after the next call to update.
+         */
+        bool addFlow(Flow* flow);
+
+        /**
+         * @brief Removes a flow from a built plan.
+         * @param flow The flow; nothing happens if it is not part of the plan.
+         * @return None.
+         */
+        void removeFlow(Flow* flow);
+
+        /**
+         * @brief Brings the linear operator up to date with the flows added and removed since the last build or update.
+         * @details Lookup flows whose table or input changed are also regrouped, and expression flows whose 
+         * expression changed (see ExpressionFlow::getVersion) are linked again, or left out if their symbols 
+         * are not bound.
+         * @return True if expressions were linked again, which outdates code generated from the plan.
+         */
+        bool update();
+
+        /**
+         * @brief Re-reads the rates of the linear flows without rebuilding the operator structure.
+         * @return None.
+         */
+        void refreshRates();
+
+        /**
+         * @brief Computes the change of every system in one step.
+         * @param state The current values of the systems.
+         * @param parameters The current values of the model parameters.
+         * @param changes Receives the change of each system; it must have the size of the state.
+         * @return None.
+         * 
+         * @note Generic flows read their systems, which must hold the values in the state.
+         */
+        void accumulate(const vector<double>& state, const vector<double>& parameters, vector<double>& changes) const;
+
+        /**
+         * @brief Adds the contribution of the lookup flows to a step.
+         * @details Called by accumulate; a compiled step, which does not cover lookup flows, is followed by it.
+         * @param state The current values of the systems.
+         * @param changes Receives the change of each system, on top of the other flows.
+         * @return None.
+         */
+        void accumulateLookups(const vector<double>& state, vector<double>& changes) const;
+
+        /**
+         * @brief Brings the contents of the delays of a run in line with the delay flows of the plan.
+         * @param delays The contents to update.
+         * @param keep If true, flows already in `delays` with contents of the same size keep them; the others, 
+         * and every flow if false, start from the contents stored in the flow.
+         * @return None.
+         */
+        void loadDelays(DelayState& delays, bool keep) const;
+
+        /**
+         * @brief Stores the contents of the delays of a run back in their flows.
+         * @param delays The contents, as loaded by loadDelays for this plan.
+         * @return None.
+         */
+        void storeDelays(const DelayState& delays) const;
+
+        /**
+         * @brief Adds the contribution of the delay flows to a step and advances their contents.
+         * @param state The current values of the systems.
+         * @param delays The contents of the delays, as loaded by loadDelays for this plan.
+         * @param changes Receives the change of each system, on top of what accumulate computed.
+         * @return None.
+         * 
+         * @note A pipeline costs O(1) whatever its length; an exponential delay costs O(order).
+         */
+        void advanceDelays(const vector<double>& state, DelayState& delays, vector<double>& changes) const;
+
+        /**
+         * @brief Adds the contribution of the stochastic flows to a step.
+         * @details The numbers of all the flows are drawn first, in one loop without dependencies between 
+         * flows, then applied. They depend only on the run, the flow and the time.
+         * @param state The current values of the systems.
+         * @param run The run of the model.
+         * @param time The time at the start of the step.
+         * @param changes Receives the change of each system, on top of the other flows.
+         * @return None.
+         */
+        void accumulateNoise(const vector<double>& state, uint64_t run, int time, vector<double>& changes) const;
+
+        /**
+         * @brief Times the evaluation of every flow, one at a time.
+         * @details Each flow is evaluated alone, as its kind is evaluated in a step, between two readings of
+         * the clock, whose own cost is left out; nothing is changed. Linear flows cost one product each, their
+         * share of the sparse product; delay flows, what enters them.
+         * @param state The current values of the systems.
+         * @param parameters The current values of the model parameters.
+         * @param run The run of the model.
+         * @param time The time at the start of the step.
+         * @param timings Receives the time of every flow.
+         * @return None.
+         */
+        void profile(const vector<double>& state, const vector<double>& parameters, uint64_t run, int time,
+                     vector<FlowTiming>& timings) const;
+
+        /**
+         * @brief Computes the change of the tangents of every system in one step (forward mode).
+         * @details Tangents are stored system-major, with the `directions` tangents of a system contiguous, 
+         * so each flow updates all directions in one inner loop. The change of the tangents is the Jacobian 
+         * of the step applied to the tangents, plus the direct dependence on the parameters and rates. 
+         * Stochastic flows are differentiated for the noise they draw in the step, which does not depend on 
+         * the values.
+         * @param state The current values of the systems.
+         * @param parameters The current values of the model parameters.
+         * @param run The run of the model.
+         * @param time The time at the start of the step.
+         * @param stateTangents The tangents of the systems, systems x directions.
+         * @param parameterTangents The tangents of the parameters, parameters x directions.
+         * @param rateSeeds The linear flows whose rate is a direction.
+         * @param directions The number of directions.
+         * @param changes Receives the change of the tangents, systems x directions.
+         * @return None.
+         * 
+         * @note Only plans for which isDifferentiable holds can be differentiated.
+         */
+        void accumulateTangents(const vector<double>& state, const vector<double>& parameters, uint64_t run, int time,
+                                const double* stateTangents, const double* parameterTangents,
+                                const vector<RateSeed>& rateSeeds, size_t directions, double* changes) const;
+
+        /**
+         * @brief Propagates the adjoints of the changes of one step back to what the step read (reverse mode).
+         * @details The transpose of accumulateTangents: every flow takes the difference of the adjoints of 
+         * its destination and source, and adds it, weighted by its partial derivatives, to the adjoints of 
+         * the systems and parameters it reads and of its rate.
+         * @param state The values of the systems before the step.
+         * @param parameters The values of the model parameters during the step.
+         * @param run The run of the model.
+         * @param time The time at the start of the step.
+         * @param adjoints The adjoints of the changes of the systems.
+         * @param stateAdjoints Accumulates the adjoints of the systems.
+         * @param parameterAdjoints Accumulates the adjoints of the parameters.
+         * @param rateAdjoints Accumulates the adjoints of the rates, one per linear flow.
+         * @return None.
+         * 
+         * @note Only plans for which isDifferentiable holds can be differentiated.
+         */
+        void accumulateAdjoints(const vector<double>& state, const vector<double>& parameters, uint64_t run, int time,
+                                const double* adjoints, double* stateAdjoints, double* parameterAdjoints,
+                                double* rateAdjoints) const;
+
+        /**
+         * @brief Tells whether the step can be differentiated.
+         * @return True if every flow is linear, an expression, a lookup or stochastic.
+         */
+        bool isDifferentiable() const { return genericFlows.empty() && delayFlows.empty(); }
+
+        /**
+         * @brief Tells whether the step reads the values stored in the System objects.
+         * @details It does when some flow has no symbolic form (linear, expression, lookup, delay or stochastic).
+         * @return True if some flow is evaluated through `equation`.
+         */
+        bool readsSystems() const { return !genericFlows.empty(); }
+
+        /**
+         * @brief Gets the index of a system in the state vector.
+         * @param system The system.
+         * @return Its index, or -1 if the system does not belong to the plan.
+         */
+        long indexOf(System* system) const;
+
+        const SparseMatrix& getLinearOperator() const { return linearOperator; }
+        const vector<FlowEntry>& getLinearFlows() const { return linearFlows; }
+        const vector<double>& getRates() const { return rates; }
+        const vector<ExpressionEntry>& getExpressionFlows() const { return expressionFlows; }
+        const vector<LookupGroup>& getLookupGroups() const { return lookupGroups; }
+        const vector<DelayEntry>& getDelayFlows() const { return delayFlows; }
+        const vector<StochasticEntry>& getStochasticFlows() const { return stochasticFlows; }
+};
+
+#endif
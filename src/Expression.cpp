@@ -0,0 +1,366 @@
+#include "Expression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+/// Recursive descent parser emitting the bytecode of an Expression.
+class Parser {
+    private:
+        const string& text;
+        size_t position = 0;
+        vector<string>& symbols;
+        vector<Expression::Instruction>& code;
+        string error;
+
+        void skipSpaces() {
+            while (position < text.size() && std::isspace((unsigned char) text[position])) {
+                position++;
+            }
+        }
+
+        bool accept(char c) {
+            skipSpaces();
+            if (position < text.size() && text[position] == c) {
+                position++;
+                return true;
+            }
+            return false;
+        }
+
+        bool fail(const string& message) {
+            if (error.empty()) {
+                error = message + " at position " + std::to_string(position);
+            }
+            return false;
+        }
+
+        static bool isConstant(const Expression::Instruction& instruction) {
+            return instruction.op == Expression::CONSTANT;
+        }
+
+        static double apply(Expression::Opcode op, double a, double b) {
+            switch (op) {
+                case Expression::ADD: return a + b;
+                case Expression::SUB: return a - b;
+                case Expression::MUL: return a * b;
+                case Expression::DIV: return a / b;
+                case Expression::POW: return std::pow(a, b);
+                case Expression::MIN: return std::fmin(a, b);
+                case Expression::MAX: return std::fmax(a, b);
+                case Expression::NEG: return -a;
+                case Expression::EXP: return std::exp(a);
+                case Expression::LOG: return std::log(a);
+                case Expression::SQRT: return std::sqrt(a);
+                case Expression::ABS: return std::fabs(a);
+                default: return 0.0;
+            }
+        }
+
+        uint32_t emitConstant(double value) {
+            code.push_back({Expression::CONSTANT, 0, 0, value});
+            return uint32_t(code.size() - 1);
+        }
+
+        // Operations on constants are folded; their operands are then the last registers and are dropped.
+        uint32_t emit(Expression::Opcode op, uint32_t a, uint32_t b = 0) {
+            bool binary = op < Expression::NEG;
+            if (isConstant(code[a]) && (!binary || isConstant(code[b]))) {
+                double value = apply(op, code[a].value, binary ? code[b].value : 0.0);
+                code.resize(a);
+                return emitConstant(value);
+            }
+            code.push_back({op, a, b, 0.0});
+            return uint32_t(code.size() - 1);
+        }
+
+        bool parseExpression(uint32_t& result) {
+            if (!parseTerm(result)) {
+                return false;
+            }
+            while (true) {
+                Expression::Opcode op;
+                if (accept('+')) {
+                    op = Expression::ADD;
+                } else if (accept('-')) {
+                    op = Expression::SUB;
+                } else {
+                    return true;
+                }
+                uint32_t right;
+                if (!parseTerm(right)) {
+                    return false;
+                }
+                result = emit(op, result, right);
+            }
+        }
+
+        bool parseTerm(uint32_t& result) {
+            if (!parseUnary(result)) {
+                return false;
+            }
+            while (true) {
+                Expression::Opcode op;
+                if (accept('*')) {
+                    op = Expression::MUL;
+                } else if (accept('/')) {
+                    op = Expression::DIV;
+                } else {
+                    return true;
+                }
+                uint32_t right;
+                if (!parseUnary(right)) {
+                    return false;
+                }
+                result = emit(op, result, right);
+            }
+        }
+
+        bool parseUnary(uint32_t& result) {
+            if (accept('-')) {
+                if (!parseUnary(result)) {
+                    return false;
+                }
+                result = emit(Expression::NEG, result);
+                return true;
+            }
+            accept('+');
+            return parsePower(result);
+        }
+
+        bool parsePower(uint32_t& result) {
+            if (!parsePrimary(result)) {
+                return false;
+            }
+            if (accept('^')) {
+                uint32_t exponent;
+                if (!parseUnary(exponent)) {
+                    return false;
+                }
+                result = emit(Expression::POW, result, exponent);
+            }
+            return true;
+        }
+
+        bool parseCall(const string& name, uint32_t& result) {
+            vector<uint32_t> arguments;
+            if (!accept(')')) {
+                do {
+                    uint32_t argument;
+                    if (!parseExpression(argument)) {
+                        return false;
+                    }
+                    arguments.push_back(argument);
+                } while (accept(','));
+                if (!accept(')')) {
+                    return fail("expected ')'");
+                }
+            }
+
+            struct Function { const char* name; Expression::Opcode op; size_t arity; };
+            static const Function functions[] = {
+                {"exp", Expression::EXP, 1}, {"log", Expression::LOG, 1}, {"sqrt", Expression::SQRT, 1},
+                {"abs", Expression::ABS, 1}, {"min", Expression::MIN, 2}, {"max", Expression::MAX, 2},
+                {"pow", Expression::POW, 2}
+            };
+            for (const Function& function : functions) {
+                if (name == function.name) {
+                    if (arguments.size() != function.arity) {
+                        return fail("wrong number of arguments to '" + name + "'");
+                    }
+                    result = emit(function.op, arguments[0], function.arity == 2 ? arguments[1] : 0);
+                    return true;
+                }
+            }
+            return fail("unknown function '" + name + "'");
+        }
+
+        bool parsePrimary(uint32_t& result) {
+            skipSpaces();
+            if (position >= text.size()) {
+                return fail("unexpected end of expression");
+            }
+
+            char c = text[position];
+            if (accept('(')) {
+                if (!parseExpression(result)) {
+                    return false;
+                }
+                return accept(')') || fail("expected ')'");
+            }
+
+            if (std::isdigit((unsigned char) c) || c == '.') {
+                const char* begin = text.c_str() + position;
+                char* end;
+                double value = std::strtod(begin, &end);
+                if (end == begin) {
+                    return fail("invalid number");
+                }
+                position += end - begin;
+                result = emitConstant(value);
+                return true;
+            }
+
+            if (std::isalpha((unsigned char) c) || c == '_') {
+                size_t start = position;
+                while (position < text.size() && (std::isalnum((unsigned char) text[position])
+                       || text[position] == '_' || text[position] == '.')) {
+                    position++;
+                }
+                string name = text.substr(start, position - start);
+                if (accept('(')) {
+                    return parseCall(name, result);
+                }
+
+                size_t symbol = 0;
+                while (symbol < symbols.size() && symbols[symbol] != name) {
+                    symbol++;
+                }
+                if (symbol == symbols.size()) {
+                    symbols.push_back(name);
+                }
+                code.push_back({Expression::STATE, uint32_t(symbol), 0, 0.0});
+                result = uint32_t(code.size() - 1);
+                return true;
+            }
+
+            return fail(string("unexpected character '") + c + "'");
+        }
+
+    public:
+        Parser(const string& text, vector<string>& symbols, vector<Expression::Instruction>& code)
+            : text(text), symbols(symbols), code(code) {}
+
+        bool run(string* message) {
+            uint32_t result;
+            bool parsed = parseExpression(result);
+            skipSpaces();
+            if (parsed && position != text.size()) {
+                parsed = fail("unexpected trailing input");
+            }
+            if (!parsed && message) {
+                *message = error;
+            }
+            return parsed;
+        }
+};
+
+}
+
+bool Expression::parse(const string& text, string* error) {
+    this->text = text;
+    symbols.clear();
+    code.clear();
+
+    Parser parser(text, symbols, code);
+    if (!parser.run(error)) {
+        symbols.clear();
+        code.clear();
+        return false;
+    }
+    return true;
+}
+
+Expression Expression::link(const vector<Binding>& bindings) const {
+    Expression linked = *this;
+    for (Instruction& instruction : linked.code) {
+        if (instruction.op == STATE) {
+            const Binding& binding = bindings[instruction.a];
+            instruction.op = binding.parameter ? PARAMETER : STATE;
+            instruction.a = uint32_t(binding.index);
+        }
+    }
+    return linked;
+}
+
+double Expression::evaluate(const double* state, const double* parameters) const {
+    // Short expressions, by far the common case, use registers on the stack.
+    double stackRegisters[32];
+    vector<double> heapRegisters;
+    double* r = stackRegisters;
+    if (code.size() > 32) {
+        heapRegisters.resize(code.size());
+        r = heapRegisters.data();
+    }
+    run(state, parameters, r);
+    return code.empty() ? 0.0 : r[code.size() - 1];
+}
+
+void Expression::run(const double* state, const double* parameters, double* r) const {
+    const Instruction* instructions = code.data();
+    size_t size = code.size();
+    for (size_t i = 0; i < size; i++) {
+        const Instruction& in = instructions[i];
+        switch (in.op) {
+            case CONSTANT:  r[i] = in.value; break;
+            case STATE:     r[i] = state[in.a]; break;
+            case PARAMETER: r[i] = parameters[in.a]; break;
+            case ADD:       r[i] = r[in.a] + r[in.b]; break;
+            case SUB:       r[i] = r[in.a] - r[in.b]; break;
+            case MUL:       r[i] = r[in.a] * r[in.b]; break;
+            case DIV:       r[i] = r[in.a] / r[in.b]; break;
+            case POW:       r[i] = std::pow(r[in.a], r[in.b]); break;
+            case MIN:       r[i] = std::fmin(r[in.a], r[in.b]); break;
+            case MAX:       r[i] = std::fmax(r[in.a], r[in.b]); break;
+            case NEG:       r[i] = -r[in.a]; break;
+            case EXP:       r[i] = std::exp(r[in.a]); break;
+            case LOG:       r[i] = std::log(r[in.a]); break;
+            case SQRT:      r[i] = std::sqrt(r[in.a]); break;
+            case ABS:       r[i] = std::fabs(r[in.a]); break;
+        }
+    }
+}
+
+double Expression::differentiate(const double* state, const double* parameters, double* partials) const {
+    size_t size = code.size();
+    if (size == 0) {
+        return 0.0;
+    }
+    double stackRegisters[32];
+    vector<double> heapRegisters;
+    double* r = stackRegisters;
+    if (size > 32) {
+        heapRegisters.resize(size);
+        r = heapRegisters.data();
+    }
+    run(state, parameters, r);
+    const Instruction* instructions = code.data();
+
+    // Operands always precede their instruction, so one backward pass propagates every derivative.
+    std::fill(partials, partials + size, 0.0);
+    partials[size - 1] = 1.0;
+    for (size_t i = size; i-- > 0;) {
+        const Instruction& in = instructions[i];
+        double d = partials[i];
+        if (d == 0.0) {
+            continue;
+        }
+        switch (in.op) {
+            case CONSTANT:
+            case STATE:
+            case PARAMETER:
+                break;
+            case ADD:  partials[in.a] += d; partials[in.b] += d; break;
+            case SUB:  partials[in.a] += d; partials[in.b] -= d; break;
+            case MUL:  partials[in.a] += d * r[in.b]; partials[in.b] += d * r[in.a]; break;
+            case DIV:  partials[in.a] += d / r[in.b]; partials[in.b] -= d * r[i] / r[in.b]; break;
+            case POW:
+                partials[in.a] += d * r[in.b] * std::pow(r[in.a], r[in.b] - 1.0);
+                if (r[in.a] > 0.0) {
+                    partials[in.b] += d * r[i] * std::log(r[in.a]);
+                }
+                break;
+            case MIN:  partials[r[in.a] <= r[in.b] ? in.a : in.b] += d; break;
+            case MAX:  partials[r[in.a] >= r[in.b] ? in.a : in.b] += d; break;
+            case NEG:  partials[in.a] -= d; break;
+            case EXP:  partials[in.a] += d * r[i]; break;
+            case LOG:  partials[in.a] += d / r[in.a]; break;
+            case SQRT: partials[in.a] += d * 0.5 / r[i]; break;
+            case ABS:  partials[in.a] += r[in.a] < 0.0 ? -d : d; break;
+        }
+    }
+    return r[size - 1];
+}
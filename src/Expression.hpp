@@ -0,0 +1,120 @@
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @class Expression
+ * @brief Arithmetic expression parsed once into a compact register bytecode.
+ * @details An expression such as `0.01 * dest * (1 - dest / 70)` is parsed into a sequence of instructions
+ * in which instruction i writes register i, so evaluation is a single loop over the instructions with no
+ * recursion, allocation or virtual call. Constant sub-expressions are folded while parsing.
+ *
+ * Grammar (usual precedence, `^` is right associative):
+ * @code
+ * expression := term (('+' | '-') term)*
+ * term       := unary (('*' | '/') unary)*
+ * unary      := '-' unary | power
+ * power      := primary ('^' unary)?
+ * primary    := number | name | name '(' expression (',' expression)* ')' | '(' expression ')'
+ * @endcode
+ * Supported functions are exp, log, sqrt, abs (one argument) and min, max, pow (two arguments).
+ *
+ * Names are collected as symbols, numbered in order of first appearance. A parsed expression loads
+ * symbol k from `values[k]`; link rewrites the loads to read the state vector or the parameter vector
+ * of a model, so that evaluating the linked expression needs no lookup at all.
+ *
+ * @see ExpressionFlow
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class Expression {
+    public:
+        /**
+         * @brief Operation codes of the bytecode.
+         */
+        enum Opcode : uint8_t {
+            CONSTANT,   /**< Loads `value`. */
+            STATE,      /**< Loads `state[a]` (symbol a before linking). */
+            PARAMETER,  /**< Loads `parameters[a]`. */
+            ADD, SUB, MUL, DIV, POW, MIN, MAX,
+            NEG, EXP, LOG, SQRT, ABS
+        };
+
+        /**
+         * @struct Instruction
+         * @brief One instruction, writing the register with its own index.
+         */
+        struct Instruction {
+            Opcode op;          /**< Operation. */
+            uint32_t a;         /**< First operand register, or the index loaded by STATE and PARAMETER. */
+            uint32_t b;         /**< Second operand register of binary operations. */
+            double value;       /**< Constant loaded by CONSTANT. */
+        };
+
+        /**
+         * @struct Binding
+         * @brief Where a symbol is read from once the expression is linked.
+         */
+        struct Binding {
+            bool parameter;     /**< True to read the parameter vector, false to read the state vector. */
+            size_t index;       /**< Index in that vector. */
+        };
+
+    private:
+        string text;                    /**< Source text of the expression. */
+        vector<string> symbols;         /**< Names referenced by the expression. */
+        vector<Instruction> code;       /**< Bytecode; the result is the last register. */
+
+        void run(const double* state, const double* parameters, double* registers) const;
+
+    public:
+        /**
+         * @brief Parses an expression.
+         * @param text The text of the expression.
+         * @param error Receives a description of the problem when parsing fails; may be null.
+         * @return True if the text is a valid expression, false otherwise.
+         */
+        bool parse(const string& text, string* error = nullptr);
+
+        const string& getText() const { return text; }
+        const vector<string>& getSymbols() const { return symbols; }
+        const vector<Instruction>& getCode() const { return code; }
+
+        /**
+         * @brief Produces a copy of the expression whose loads read the state and parameter vectors.
+         * @param bindings The binding of each symbol, in symbol order.
+         * @return The linked expression.
+         */
+        Expression link(const vector<Binding>& bindings) const;
+
+        /**
+         * @brief Evaluates the expression.
+         * @param state The state vector (or, for an expression that was not linked, the symbol values).
+         * @param parameters The parameter vector; unused by an expression that was not linked.
+         * @return The value of the expression.
+         */
+        double evaluate(const double* state, const double* parameters) const;
+
+        /**
+         * @brief Evaluates the expression and its derivative with respect to every register.
+         * @details A reverse sweep over the registers gives, in one pass whatever the number of loads, the 
+         * derivative of the result with respect to each STATE and PARAMETER load, found at the index of the 
+         * load instruction. Non-differentiable points take one side: MIN and MAX the selected operand, ABS 
+         * the sign of its operand, and the exponent of POW has no derivative for non-positive bases.
+         * @param state The state vector (or, for an expression that was not linked, the symbol values).
+         * @param parameters The parameter vector; unused by an expression that was not linked.
+         * @param partials Receives the derivative of the result with respect to each register; must hold 
+         * one element per instruction.
+         * @return The value of the expression.
+         */
+        double differentiate(const double* state, const double* parameters, double* partials) const;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "ExpressionFlow.hpp"
+
+bool ExpressionFlow::setExpression(const string& text, string* error) {
+    symbols.clear();
+    version++;
+    return expression.parse(text, error);
+}
+
+void ExpressionFlow::bind(const vector<Symbol>& symbols, std::shared_ptr<const vector<double>> parameters) {
+    this->symbols = symbols;
+    this->parameters = std::move(parameters);
+}
+
+double ExpressionFlow::equation() const {
+    if (!isBound()) {
+        return 0.0;
+    }
+
+    size_t numSymbols = symbols.size();
+    double stackValues[16] = {};
+    vector<double> heapValues;
+    double* values = stackValues;
+    if (numSymbols > 16) {
+        heapValues.resize(numSymbols);
+        values = heapValues.data();
+    }
+
+    for (size_t i = 0; i < numSymbols; i++) {
+        const Symbol& symbol = symbols[i];
+        switch (symbol.kind) {
+            case SOURCE:
+                values[i] = getSource() ? getSource()->getValue() : 0.0;
+                break;
+            case DESTINATION:
+                values[i] = getDestination() ? getDestination()->getValue() : 0.0;
+                break;
+            case SYSTEM:
+                values[i] = symbol.system->getValue();
+                break;
+            case PARAMETER:
+                values[i] = symbol.parameter < parameters->size() ? (*parameters)[symbol.parameter] : 0.0;
+                break;
+        }
+    }
+    return expression.evaluate(values, nullptr);
+}
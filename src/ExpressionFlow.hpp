@@ -0,0 +1,94 @@
+#ifndef EXPRESSION_FLOW_HPP
+#define EXPRESSION_FLOW_HPP
+
+#include "FlowImpl.hpp"
+#include "Expression.hpp"
+
+#include <memory>
+
+/**
+ * @class ExpressionFlow
+ * @brief Flow whose equation is an Expression given as text at runtime.
+ * @details The expression may reference `source` and `destination` (or `dest`), the systems the flow 
+ * connects, any system of the model by name, and any model parameter by name. It is parsed once when the 
+ * flow is created; the model then links it to its state vector and evaluates the bytecode directly, 
+ * without calling `equation` or reading the System objects.
+ * 
+ * @code
+ * Flow* logistic = model->createFlow("logistic", p1, p2, "0.01 * dest * (1 - dest / capacity)");
+ * @endcode
+ * 
+ * @see Expression
+ * @see Model::createFlow
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class ExpressionFlow : public FlowHandle {
+    public:
+        /**
+         * @brief Kinds of values a symbol of the expression can refer to.
+         */
+        enum SymbolKind { SOURCE, DESTINATION, SYSTEM, PARAMETER };
+
+        /**
+         * @struct Symbol
+         * @brief The value a symbol of the expression refers to.
+         */
+        struct Symbol {
+            SymbolKind kind;        /**< Kind of the value. */
+            System* system;         /**< The system, for SYSTEM symbols. */
+            size_t parameter;       /**< The parameter index, for PARAMETER symbols. */
+        };
+
+    private:
+        Expression expression;                          /**< The parsed expression. */
+        vector<Symbol> symbols;                         /**< Binding of each symbol of the expression. */
+        std::shared_ptr<const vector<double>> parameters;   /**< Parameter values lent by the models holding the flow. */
+        unsigned long version = 0;                      /**< Incremented whenever the expression changes. */
+
+    public:
+        ExpressionFlow(const string& name = "", System* source = nullptr, System* destination = nullptr)
+            : FlowHandle(name, source, destination) {}
+
+        /**
+         * @brief Parses the expression of the flow.
+         * @param text The text of the expression.
+         * @param error Receives a description of the problem when parsing fails; may be null.
+         * @return True if the expression is valid, false otherwise.
+         * 
+         * @note The symbols must be bound again after the expression changes; models holding the flow bind 
+         * them to their systems and parameters before their next run.
+         */
+        bool setExpression(const string& text, string* error = nullptr);
+
+        const Expression& getExpression() const { return expression; }
+
+        /**
+         * @brief Gets the version of the expression, which lets plans tell when their linked copy is outdated.
+         * @return A number incremented by every call to setExpression.
+         */
+        unsigned long getVersion() const { return version; }
+
+        /**
+         * @brief Binds the symbols of the expression.
+         * @param symbols The binding of each symbol, in the order of Expression::getSymbols.
+         * @param parameters The parameter values referenced by PARAMETER symbols, shared by the models that 
+         * hold the flow, so that it never outlives them.
+         * @return None.
+         */
+        void bind(const vector<Symbol>& symbols, std::shared_ptr<const vector<double>> parameters);
+
+        const vector<Symbol>& getBoundSymbols() const { return symbols; }
+
+        bool isBound() const { return symbols.size() == expression.getSymbols().size(); }
+
+        /**
+         * @brief Evaluates the expression with the current values of the systems and parameters.
+         * @details Like the values of the systems, the parameters are those of the model that owns the 
+         * systems, or of a fork while it lends them its values.
+         * @return The value of the expression, or zero if its symbols are not bound.
+         */
+        double equation() const override;
+};
+
+#endif
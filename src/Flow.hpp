@@ -92,6 +92,24 @@ class Flow {
          * @warning The `equation` method must be implemented by all derived classes, otherwise, the simulation will be incomplete.
          */
         virtual double equation() const = 0;
+
+        /**
+         * @brief Tells whether the flow is linear in its source.
+         * @details A linear flow always evaluates to `getRate() * getSource()->getValue()`. The model uses this 
+         * property to replace the step-by-step evaluation of linear flows by matrix operations.
+         * @return True if the flow is linear in its source, false otherwise (the default).
+         * 
+         * @warning Derived classes that return true must keep `equation` consistent with `getRate`.
+         */
+        virtual bool isLinear() const { return false; }
+
+        /**
+         * @brief Gets the rate of a linear flow.
+         * @return The fraction of the source value transferred per time step, or zero for non-linear flows.
+         * 
+         * @see isLinear
+         */
+        virtual double getRate() const { return 0.0; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "FlowRegistry.hpp"
+
+std::unordered_map<string, FlowRegistry::Factory>& FlowRegistry::factories() {
+    static std::unordered_map<string, Factory> factories;
+    return factories;
+}
+
+std::unordered_map<std::type_index, string>& FlowRegistry::types() {
+    static std::unordered_map<std::type_index, string> types;
+    return types;
+}
+
+Flow* FlowRegistry::create(const string& type, Model* model, const string& name, System* source, System* destination) {
+    auto it = factories().find(type);
+    if (it == factories().end()) {
+        return nullptr;
+    }
+    return it->second(model, name, source, destination);
+}
+
+bool FlowRegistry::contains(const string& type) {
+    return factories().count(type) > 0;
+}
+
+string FlowRegistry::getType(const Flow* flow) {
+    auto it = types().find(std::type_index(typeid(*flow)));
+    return it == types().end() ? string() : it->second;
+}
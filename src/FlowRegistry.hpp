@@ -0,0 +1,80 @@
+#ifndef FLOW_REGISTRY_HPP
+#define FLOW_REGISTRY_HPP
+
+#include "Model.hpp"
+
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+using std::string;
+
+/**
+ * @class FlowRegistry
+ * @brief Maps type names to flow classes, so models stored as data can refer to C++ flow types.
+ * @details Applications register their FlowHandle subclasses under a name; model files then create flows 
+ * of these types by name, and models can be saved with the type name of each flow.
+ * 
+ * @code
+ * FlowRegistry::add<ExponentialFlow>("exponential");
+ * Flow* flow = FlowRegistry::create("exponential", model, "f", q1, q2);
+ * @endcode
+ * 
+ * @note Built-in flows (LinearFlow and ExpressionFlow) are handled by the model formats directly and need 
+ * no registration.
+ * @see ModelLoader
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class FlowRegistry {
+    public:
+        /// Creates a flow of a registered type in a model.
+        typedef Flow* (*Factory)(Model* model, const string& name, System* source, System* destination);
+
+    private:
+        static std::unordered_map<string, Factory>& factories();
+        static std::unordered_map<std::type_index, string>& types();
+
+    public:
+        /**
+         * @brief Registers a flow class under a type name.
+         * @tparam FLOW_TEMPLATE The flow class, constructible from (name, source, destination).
+         * @param type The type name.
+         * @return None.
+         */
+        template <typename FLOW_TEMPLATE>
+        static void add(const string& type) {
+            factories()[type] = [](Model* model, const string& name, System* source, System* destination) -> Flow* {
+                return model->createFlow<FLOW_TEMPLATE>(name, source, destination);
+            };
+            types()[std::type_index(typeid(FLOW_TEMPLATE))] = type;
+        }
+
+        /**
+         * @brief Creates a flow of a registered type in a model.
+         * @param type The type name.
+         * @param model The model receiving the flow.
+         * @param name The name of the flow.
+         * @param source The source system of the flow.
+         * @param destination The destination system of the flow.
+         * @return The new flow, or nullptr if no class is registered under that name.
+         */
+        static Flow* create(const string& type, Model* model, const string& name, System* source, System* destination);
+
+        /**
+         * @brief Tells whether a class is registered under a type name.
+         * @param type The type name.
+         * @return True if create would make a flow of that type.
+         */
+        static bool contains(const string& type);
+
+        /**
+         * @brief Gets the type name under which the class of a flow is registered.
+         * @param flow The flow.
+         * @return The type name, or an empty string if its class is not registered.
+         */
+        static string getType(const Flow* flow);
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <ranges>
+#include <utility>
+
+/**
+ * @class Generator
+ * @brief Pull-driven coroutine range that yields references to values produced by a coroutine body.
+ * @details A Generator wraps a C++20 coroutine whose body uses `co_yield`. The coroutine starts suspended
+ * and only runs up to the next `co_yield` when the consumer advances the iterator, so no work is done
+ * beyond what the consumer asks for. Yielded values are exposed by const reference and are never copied.
+ *
+ * Generator is a move-only view and an input range, so it can be used in range-based for loops and
+ * composed with range adaptors and algorithms such as `std::views::take` or `std::ranges::find_if`.
+ *
+ * @tparam T The type of the yielded values.
+ *
+ * @note The reference returned by the iterator is only valid until the iterator is advanced.
+ * @see Model::steps
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+template <typename T>
+class Generator : public std::ranges::view_interface<Generator<T>> {
+    public:
+        /**
+         * @brief Coroutine promise storing the address of the last yielded value.
+         */
+        struct promise_type {
+            const T* current = nullptr;             /**< Address of the value of the last `co_yield`. */
+            bool pending = true;                    /**< Whether the coroutine must resume before the next read. */
+            std::exception_ptr exception;           /**< Exception thrown by the coroutine body, if any. */
+
+            Generator get_return_object() {
+                return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+
+            std::suspend_always yield_value(const T& value) noexcept {
+                current = &value;
+                return {};
+            }
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() { exception = std::current_exception(); }
+
+            /// Coroutines returning a Generator may only yield, never await.
+            template <typename U>
+            std::suspend_never await_transform(U&&) = delete;
+        };
+
+        /**
+         * @brief Input iterator resuming the coroutine on demand.
+         * @details Incrementing only marks the current value as consumed; the coroutine is resumed when the
+         * next value is read or compared against the end. Adaptors such as `std::views::take` increment past
+         * the last element they need, so resuming eagerly would execute one step nobody asked for.
+         */
+        class iterator {
+            public:
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+
+                iterator() = default;
+                explicit iterator(std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine) {}
+
+                const T& operator*() const {
+                    resume();
+                    return *coroutine.promise().current;
+                }
+
+                const T* operator->() const { return &**this; }
+
+                iterator& operator++() {
+                    coroutine.promise().pending = true;
+                    return *this;
+                }
+
+                void operator++(int) { ++*this; }
+
+                friend bool operator==(const iterator& it, std::default_sentinel_t) {
+                    if (!it.coroutine) {
+                        return true;
+                    }
+                    it.resume();
+                    return it.coroutine.done();
+                }
+
+            private:
+                void resume() const {
+                    promise_type& promise = coroutine.promise();
+                    if (promise.pending && !coroutine.done()) {
+                        promise.pending = false;
+                        coroutine.resume();
+                        if (promise.exception) {
+                            std::rethrow_exception(promise.exception);
+                        }
+                    }
+                }
+
+                std::coroutine_handle<promise_type> coroutine;
+        };
+
+        Generator() = default;
+
+        Generator(Generator&& other) noexcept : coroutine(std::exchange(other.coroutine, {})) {}
+
+        Generator& operator=(Generator&& other) noexcept {
+            if (this != &other) {
+                if (coroutine) {
+                    coroutine.destroy();
+                }
+                coroutine = std::exchange(other.coroutine, {});
+            }
+            return *this;
+        }
+
+        Generator(const Generator&) = delete;
+        Generator& operator=(const Generator&) = delete;
+
+        ~Generator() {
+            if (coroutine) {
+                coroutine.destroy();
+            }
+        }
+
+        /**
+         * @brief Returns an iterator to the first value; the coroutine runs when that value is first read.
+         * @note An input range may only be traversed once; begin() must be called a single time.
+         */
+        iterator begin() { return iterator(coroutine); }
+
+        std::default_sentinel_t end() const noexcept { return {}; }
+
+    private:
+        explicit Generator(std::coroutine_handle<promise_type> coroutine) : coroutine(coroutine) {}
+
+        std::coroutine_handle<promise_type> coroutine;
+};
+
+#endif
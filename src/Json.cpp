@@ -0,0 +1,34 @@
+#include "Json.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+string Json::quote(const string& text) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (uint8_t(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
+
+bool Json::write(const string& path, const string& json, string* error) {
+    std::ofstream output(path, std::ios::trunc);
+    output << json;
+    if (!output) {
+        if (error) {
+            *error = "cannot write '" + path + "'";
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,33 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <string>
+
+using std::string;
+
+/**
+ * @class Json
+ * @brief Helpers shared by the JSON exports of the library, such as the profiler report and the trace.
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class Json {
+    public:
+        /**
+         * @brief Formats a text as a JSON string.
+         * @param text The text.
+         * @return The text in double quotes, with quotes, backslashes and control characters escaped.
+         */
+        static string quote(const string& text);
+
+        /**
+         * @brief Writes a JSON document to a file.
+         * @param path The path of the file, which is replaced.
+         * @param json The document.
+         * @param error Receives a description of the problem when writing fails; may be null.
+         * @return True if the file was written.
+         */
+        static bool write(const string& path, const string& json, string* error = nullptr);
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef LINEAR_FLOW_HPP
+#define LINEAR_FLOW_HPP
+
+#include "FlowImpl.hpp"
+
+/**
+ * @class LinearFlow
+ * @brief Flow that transfers a constant fraction of its source per time step.
+ * @details The value of a LinearFlow is \f[ f = rate \times source->getValue() \f]
+ * Since the flow is linear in its source, the model can evaluate it with matrix operations instead 
+ * of calling `equation` for every step.
+ * 
+ * @see Flow::isLinear
+ * @see Model::fastForward
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class LinearFlow : public FlowHandle {
+    private:
+        double rate;    /**< Fraction of the source value transferred per time step. */
+
+    public:
+        /**
+         * @brief Constructs a LinearFlow with a name, optional systems and a rate.
+         * @param name The name of the flow.
+         * @param source The source system from which the flow originates.
+         * @param destination The destination system to which the flow goes.
+         * @param rate The fraction of the source value transferred per time step.
+         */
+        LinearFlow(const string& name = "", System* source = nullptr, System* destination = nullptr, double rate = 0.0)
+            : FlowHandle(name, source, destination), rate(rate) {}
+
+        double equation() const override {
+            if (this->getSource()) {
+                return rate * this->getSource()->getValue();
+            }
+            return 0.0;
+        }
+
+        bool isLinear() const override { return true; }
+
+        double getRate() const override { return rate; }
+
+        /**
+         * @brief Sets the rate of the flow.
+         * @param rate The fraction of the source value transferred per time step.
+         */
+        void setRate(double rate) { this->rate = rate; }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef LOOKUP_FLOW_HPP
+#define LOOKUP_FLOW_HPP
+
+#include "FlowImpl.hpp"
+#include "LookupTable.hpp"
+
+/**
+ * @class LookupFlow
+ * @brief Flow whose value is a lookup table of the value of a system.
+ * @details The value of a LookupFlow is \f[ f = table(input->getValue()) \f] where the input is the
+ * source of the flow unless another system is given. The model evaluates lookup flows from its state
+ * vector, grouping the flows that share a table so that each table is evaluated once per step for all
+ * its flows with LookupTable::evaluate.
+ *
+ * @code
+ * LookupTable effect;
+ * effect.set(std::vector<double>{0, 50, 100}, std::vector<double>{0, 4, 5}, LookupTable::MONOTONE_CUBIC);
+ * LookupFlow* hiring = model->createFlow<LookupFlow>("hiring", pool, staff);
+ * hiring->setTable(effect);
+ * @endcode
+ *
+ * @note The table and input of a flow may be changed between runs; the model picks them up when the next
+ * run starts. Changing the breakpoints of a table changes every flow that shares it.
+ * @see LookupTable
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class LookupFlow : public FlowHandle {
+    private:
+        LookupTable table;          /**< The curve of the flow. */
+        System* input = nullptr;    /**< System read by the table, or null for the source. */
+
+    public:
+        LookupFlow(const string& name = "", System* source = nullptr, System* destination = nullptr)
+            : FlowHandle(name, source, destination) {}
+
+        double equation() const override {
+            System* system = getInput();
+            return system ? table(system->getValue()) : 0.0;
+        }
+
+        /**
+         * @brief Sets the table of the flow, sharing its breakpoints.
+         * @param table The table.
+         */
+        void setTable(const LookupTable& table) { this->table = table; }
+
+        const LookupTable& getTable() const { return table; }
+
+        /**
+         * @brief Sets the system read by the table.
+         * @param input The system, or null to read the source of the flow.
+         */
+        void setInput(System* input) { this->input = input; }
+
+        /**
+         * @brief Gets the system read by the table.
+         * @return The input system, or the source of the flow if none was set.
+         */
+        System* getInput() const { return input ? input : this->getSource(); }
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "LookupTable.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Cubic Hermite interpolation at t in [0, 1] of a segment of width h.
+inline double hermite(double t, double h, double y0, double y1, double m0, double m1) {
+    double s = 1.0 - t;
+    return s * s * ((1.0 + 2.0 * t) * y0 + t * h * m0) + t * t * ((3.0 - 2.0 * t) * y1 - s * h * m1);
+}
+
+}
+
+bool LookupTable::set(std::span<const double> xs, std::span<const double> ys, Interpolation interpolation) {
+    if (xs.size() != ys.size() || xs.empty()) {
+        return false;
+    }
+    for (size_t i = 1; i < xs.size(); i++) {
+        if (!(xs[i] > xs[i - 1])) {
+            return false;
+        }
+    }
+
+    LookupTableBody& table = *pImpl_;
+    size_t n = xs.size();
+    table.xs.assign(xs.begin(), xs.end());
+    table.ys.assign(ys.begin(), ys.end());
+    table.interpolation = interpolation;
+
+    // Evenly spaced breakpoints (up to rounding) are indexed by scaling instead of searching.
+    table.uniform = n >= 2;
+    double step = n >= 2 ? (xs[n - 1] - xs[0]) / double(n - 1) : 0.0;
+    for (size_t i = 1; i < n && table.uniform; i++) {
+        table.uniform = std::fabs((xs[i] - xs[0]) - step * double(i)) <= 1e-9 * step * double(n);
+    }
+    table.inverseStep = table.uniform ? 1.0 / step : 0.0;
+
+    // Fritsch-Carlson tangents: the harmonic mean of the neighbouring secants where they agree in sign,
+    // zero at local extrema, so the curve never overshoots monotone data.
+    table.slopes.assign(n, 0.0);
+    if (interpolation == MONOTONE_CUBIC && n >= 2) {
+        vector<double> secants(n - 1);
+        for (size_t i = 0; i + 1 < n; i++) {
+            secants[i] = (ys[i + 1] - ys[i]) / (xs[i + 1] - xs[i]);
+        }
+        table.slopes[0] = secants[0];
+        table.slopes[n - 1] = secants[n - 2];
+        for (size_t i = 1; i + 1 < n; i++) {
+            double before = secants[i - 1];
+            double after = secants[i];
+            if (before * after > 0.0) {
+                double h0 = xs[i] - xs[i - 1];
+                double h1 = xs[i + 1] - xs[i];
+                table.slopes[i] = 3.0 * (h0 + h1) / ((2.0 * h1 + h0) / before + (h1 + 2.0 * h0) / after);
+            }
+        }
+    }
+    return true;
+}
+
+double LookupTable::operator()(double x) const {
+    const LookupTableBody& table = *pImpl_;
+    size_t n = table.xs.size();
+    if (n < 2) {
+        return n == 0 ? 0.0 : table.ys[0];
+    }
+
+    size_t i;
+    double t;
+    double width;
+    if (table.uniform) {
+        double u = std::clamp((x - table.xs[0]) * table.inverseStep, 0.0, double(n - 1));
+        i = std::min(size_t(u), n - 2);
+        t = u - double(i);
+        width = 1.0 / table.inverseStep;
+    } else {
+        x = std::clamp(x, table.xs[0], table.xs[n - 1]);
+        i = std::upper_bound(table.xs.begin() + 1, table.xs.end() - 1, x) - table.xs.begin() - 1;
+        width = table.xs[i + 1] - table.xs[i];
+        t = (x - table.xs[i]) / width;
+    }
+
+    if (table.interpolation == LINEAR) {
+        return table.ys[i] + t * (table.ys[i + 1] - table.ys[i]);
+    }
+    return hermite(t, width, table.ys[i], table.ys[i + 1], table.slopes[i], table.slopes[i + 1]);
+}
+
+double LookupTable::slope(double x) const {
+    const LookupTableBody& table = *pImpl_;
+    size_t n = table.xs.size();
+    if (n < 2 || x < table.xs[0] || x > table.xs[n - 1]) {
+        return 0.0;
+    }
+
+    size_t i;
+    if (table.uniform) {
+        i = std::min(size_t((x - table.xs[0]) * table.inverseStep), n - 2);
+    } else {
+        i = std::upper_bound(table.xs.begin() + 1, table.xs.end() - 1, x) - table.xs.begin() - 1;
+    }
+    double width = table.uniform ? 1.0 / table.inverseStep : table.xs[i + 1] - table.xs[i];
+    double t = table.uniform ? (x - table.xs[0]) * table.inverseStep - double(i) : (x - table.xs[i]) / width;
+
+    double y0 = table.ys[i];
+    double y1 = table.ys[i + 1];
+    if (table.interpolation == LINEAR) {
+        return (y1 - y0) / width;
+    }
+    // Derivatives of the Hermite basis functions with respect to t.
+    double m0 = table.slopes[i];
+    double m1 = table.slopes[i + 1];
+    double h00 = 6 * t * t - 6 * t;
+    double h10 = 3 * t * t - 4 * t + 1;
+    double h11 = 3 * t * t - 2 * t;
+    return (h00 * (y0 - y1)) / width + h10 * m0 + h11 * m1;
+}
+
+void LookupTable::evaluate(std::span<const double> xs, std::span<double> ys) const {
+    const LookupTableBody& table = *pImpl_;
+    size_t n = table.xs.size();
+    size_t count = std::min(xs.size(), ys.size());
+    if (!table.uniform) {
+        for (size_t k = 0; k < count; k++) {
+            ys[k] = (*this)(xs[k]);
+        }
+        return;
+    }
+
+    // Uniform grids need no search: each input is scaled, clamped and interpolated without branching,
+    // so these loops are vectorized by the compiler (gathers where the target has them).
+    const double* x = table.xs.data();
+    const double* y = table.ys.data();
+    const double* m = table.slopes.data();
+    double origin = x[0];
+    double inverseStep = table.inverseStep;
+    double last = double(n - 1);
+    double width = 1.0 / inverseStep;
+    if (table.interpolation == LINEAR) {
+        for (size_t k = 0; k < count; k++) {
+            double u = std::clamp((xs[k] - origin) * inverseStep, 0.0, last);
+            size_t i = std::min(size_t(u), n - 2);
+            double t = u - double(i);
+            ys[k] = y[i] + t * (y[i + 1] - y[i]);
+        }
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            double u = std::clamp((xs[k] - origin) * inverseStep, 0.0, last);
+            size_t i = std::min(size_t(u), n - 2);
+            double t = u - double(i);
+            ys[k] = hermite(t, width, y[i], y[i + 1], m[i], m[i + 1]);
+        }
+    }
+}
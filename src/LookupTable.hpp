@@ -0,0 +1,113 @@
+#ifndef LOOKUP_TABLE_HPP
+#define LOOKUP_TABLE_HPP
+
+#include "Bridge.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @class LookupTableBody
+ * @brief Breakpoints and interpolation data of a lookup table, shared by all the handles to it.
+ * @details This class is used internally by LookupTable and is not directly exposed to the user.
+ *
+ * @see LookupTable
+ */
+class LookupTableBody : public Body {
+    friend class LookupTable;
+
+    public:
+        /**
+         * @brief Interpolation between the breakpoints.
+         */
+        enum Interpolation {
+            LINEAR,             /**< Piecewise linear. */
+            MONOTONE_CUBIC      /**< Piecewise cubic Hermite, with no overshoot between monotone breakpoints. */
+        };
+
+    private:
+        vector<double> xs;              /**< Abscissas of the breakpoints, strictly increasing. */
+        vector<double> ys;              /**< Values at the breakpoints. */
+        vector<double> slopes;          /**< Tangents at the breakpoints, for MONOTONE_CUBIC. */
+        Interpolation interpolation = LINEAR;
+        bool uniform = false;           /**< Set when the breakpoints are evenly spaced. */
+        double inverseStep = 0.0;       /**< Inverse of the spacing of uniform breakpoints. */
+};
+
+/**
+ * @class LookupTable
+ * @brief Graphical function: a curve given by breakpoints and evaluated by interpolation.
+ * @details Empirical nonlinear relations are given as breakpoints rather than coded as `if` chains. Values
+ * are interpolated between the breakpoints, linearly or with monotone cubic Hermite splines
+ * (Fritsch-Carlson), and held at the first or last value outside them, as graphical functions usually are.
+ *
+ * When the breakpoints are evenly spaced, the segment of an input is found in O(1) by scaling instead of a
+ * binary search, and the batch evaluation runs as one branch-free loop that the compiler can vectorize.
+ *
+ * Tables are handles: copies share the same breakpoints, so thousands of flows using one table hold a
+ * single copy of its data, and setting the breakpoints through any copy changes them for all.
+ *
+ * @code
+ * LookupTable effect;
+ * effect.set(std::vector<double>{0, 0.5, 1, 1.5, 2}, std::vector<double>{0, 0.2, 1, 1.6, 1.8},
+ *            LookupTable::MONOTONE_CUBIC);
+ * double y = effect(0.75);
+ * @endcode
+ *
+ * @see LookupFlow
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class LookupTable : public Handle<LookupTableBody> {
+    public:
+        using Interpolation = LookupTableBody::Interpolation;
+        using enum LookupTableBody::Interpolation;
+
+        /**
+         * @brief Sets the breakpoints of the table.
+         * @param xs The abscissas, strictly increasing.
+         * @param ys The value at each abscissa.
+         * @param interpolation The interpolation between the breakpoints.
+         * @return True if the breakpoints were set, false if the sizes differ, there is no breakpoint or the
+         * abscissas are not strictly increasing; the table is then left unchanged.
+         */
+        bool set(std::span<const double> xs, std::span<const double> ys, Interpolation interpolation = LINEAR);
+
+        /**
+         * @brief Evaluates the table.
+         * @param x The input.
+         * @return The interpolated value, or zero for a table without breakpoints.
+         */
+        double operator()(double x) const;
+
+        /**
+         * @brief Gets the derivative of the table.
+         * @param x The input.
+         * @return The slope of the interpolated curve at x, or zero outside the breakpoints, where the table is held.
+         */
+        double slope(double x) const;
+
+        /**
+         * @brief Evaluates the table for many inputs at once.
+         * @param xs The inputs.
+         * @param ys Receives the value for each input; must have the size of xs.
+         * @return None.
+         */
+        void evaluate(std::span<const double> xs, std::span<double> ys) const;
+
+        size_t size() const { return pImpl_->xs.size(); }
+        bool isUniform() const { return pImpl_->uniform; }
+        Interpolation getInterpolation() const { return pImpl_->interpolation; }
+
+        /**
+         * @brief Tells whether two tables share the same breakpoints.
+         * @param other The other table.
+         * @return True if both are handles to the same data.
+         */
+        bool shares(const LookupTable& other) const { return pImpl_ == other.pImpl_; }
+};
+
+#endif
@@ -2,7 +2,12 @@
 #define MODEL_HPP
 
 #include "Flow.hpp"
+#include "Generator.hpp"
+#include "ThreadPool.hpp"
 
+#include <cstdint>
+#include <functional>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -11,6 +16,105 @@ using std::vector;
 
 class System;
 class Flow;
+class TimeSeries;
+class Aggregator;
+class Profiler;
+
+/**
+ * @struct StepView
+ * @brief Lightweight view of the model state after one execution step.
+ * @details The values are exposed in the same order in which the systems were added to the model.
+ * The span refers to the model's internal state vector, so no values are copied.
+ *
+ * @note The view is only valid until the generator that produced it is advanced.
+ * @see Model::steps
+ */
+struct StepView {
+    int time;                           /**< Simulation time reached by the step. */
+    std::span<const double> values;     /**< Values of the systems at that time. */
+};
+
+/**
+ * @struct SteadyState
+ * @brief Criteria used by the model to detect that a run has reached equilibrium.
+ * @details After each step the model computes the largest change of any system, either in absolute terms 
+ * or relative to the system's previous value. When that change stays below the tolerance for the given 
+ * number of consecutive steps, the run is considered to be in steady state and either stops at that time 
+ * or fast-forwards the clock to the end time, keeping the converged values.
+ *
+ * @note A tolerance of zero (the default) disables the detection.
+ * @see Model::setSteadyState
+ */
+struct SteadyState {
+    double tolerance = 0.0;     /**< Largest change still considered as equilibrium; zero disables detection. */
+    int steps = 1;              /**< Number of consecutive steps the change must stay below the tolerance. */
+    bool relative = false;      /**< Compare changes relative to the previous value instead of in absolute terms. */
+    bool fastForward = false;   /**< Jump the clock to the end time instead of stopping at the detection time. */
+};
+
+/**
+ * @struct Event
+ * @brief Discrete change scheduled at a given time of a run, such as a pulse, a shock or a policy switch.
+ * @details Events are applied when a run reaches their time, after the step to that time and before the 
+ * next one, so the values reported for that time already include them. Events of the same time are 
+ * applied in the order they were scheduled. Events before the start of a run are applied when it starts.
+ *
+ * @see Model::schedule
+ */
+struct Event {
+    /**
+     * @brief What an event does.
+     */
+    enum Kind {
+        SET_VALUE,      /**< Sets the value of `system` to `value`. */
+        IMPULSE,        /**< Adds `value` to the value of `system`. */
+        ENABLE_FLOW,    /**< Makes `flow` take part in the execution again. */
+        DISABLE_FLOW,   /**< Excludes `flow` from the execution, without removing it from the model. */
+        SET_PARAMETER   /**< Sets the model parameter named `parameter` to `value`. */
+    };
+
+    int time;                       /**< Time at which the event applies. */
+    Kind kind;                      /**< What the event does. */
+    System* system = nullptr;       /**< System of SET_VALUE and IMPULSE events. */
+    Flow* flow = nullptr;           /**< Flow of ENABLE_FLOW and DISABLE_FLOW events. */
+    string parameter = "";          /**< Parameter of SET_PARAMETER events. */
+    double value = 0.0;             /**< Value or amount of SET_VALUE, IMPULSE and SET_PARAMETER events. */
+};
+
+/**
+ * @struct Sensitivity
+ * @brief Quantity with respect to which the values of a run are differentiated.
+ *
+ * @see Model::computeSensitivities
+ */
+struct Sensitivity {
+    /**
+     * @brief What is differentiated against.
+     */
+    enum Kind {
+        PARAMETER,      /**< The model parameter named `parameter`. */
+        RATE,           /**< The rate of the linear flow `flow` (see Flow::getRate). */
+        INITIAL_VALUE   /**< The value of `system` at the start of the run. */
+    };
+
+    Kind kind;                      /**< What is differentiated against. */
+    string parameter;               /**< Parameter of PARAMETER sensitivities. */
+    Flow* flow = nullptr;           /**< Flow of RATE sensitivities. */
+    System* system = nullptr;       /**< System of INITIAL_VALUE sensitivities. */
+};
+
+/**
+ * @struct Gradient
+ * @brief Gradient of a scalar loss of a run with respect to everything the run depends on.
+ *
+ * @see Model::computeGradient
+ */
+struct Gradient {
+    double loss = 0.0;              /**< Value of the loss. */
+    vector<double> parameters;      /**< Derivative with respect to each model parameter, in the order of getParameterNames. */
+    vector<double> rates;           /**< Derivative with respect to the rate of each flow, in the order of the flows; zero for flows that are not linear. */
+    vector<double> initialValues;   /**< Derivative with respect to the value of each system at the start of the run. */
+};
 
 /**
  * @class Model
@@ -36,6 +140,13 @@ class Model {
 
         typedef vector<System*>::iterator SystemIterator;    /**< Typedef for an iterator for the systems vector. */
         typedef vector<Flow*>::iterator FlowIterator;        /**< Typedef for an iterator for the flows vector. */
+
+        /**
+         * @brief Scalar loss of a run, as a sum of terms over its steps.
+         * @details Called with the time and the values of the systems after each step; returns the term of 
+         * that step and stores its derivative with respect to each value in `seeds`, which comes zeroed.
+         */
+        typedef std::function<double(int time, std::span<const double> values, std::span<double> seeds)> Loss;
         
         /**
          * @brief Virtual destructor for the Model class.
@@ -72,6 +183,23 @@ class Model {
          */
         static bool deleteModel();
 
+        /**
+         * @brief Creates a copy of the model that shares its systems, flows and execution plan.
+         * @details The fork copies the current values, time, parameters and steady-state criteria, so forking 
+         * a warmed-up model mid-run costs one state vector. Forks keep their values to themselves: they are 
+         * read and written with readValues and writeValues, while the shared System objects keep the values 
+         * of the original model. Creating or deleting systems and flows in a fork (or in the original) first 
+         * gives it its own copy of the topology, leaving the others unchanged.
+         * @return The fork, owned by the caller, who deletes it when done.
+         * 
+         * @note Flow objects are shared: changing a flow (for instance the rate of a LinearFlow) affects 
+         * every model that holds it. Use parameters for what-if values.
+         * @warning Forks whose flows are not all linear or expression flows lend their values to the shared 
+         * systems while they run, so such forks must not run concurrently with their relatives. Other 
+         * forks may run concurrently on different threads.
+         */
+        virtual Model* fork() = 0;
+
         /**
          * @brief Creates a new system within the model.
          * @details Creates a new system object with the specified name and value, 
@@ -100,17 +228,300 @@ class Model {
          * @param name The name of the flow to be created.
          * @param source Pointer to the source system of the flow.
          * @param destination Pointer to the destination system of the flow.
-         * @return A pointer to the newly created flow.
+         * @return A pointer to the newly created flow, with its concrete type.
          * 
          * @note The flow is automatically added to the model upon creation.
          */
         template <typename FLOW_TEMPLATE>
-        Flow* createFlow(const string& name, System* source = nullptr, System* destination = nullptr) {
-            Flow* flow = new FLOW_TEMPLATE(name, source, destination);
+        FLOW_TEMPLATE* createFlow(const string& name, System* source = nullptr, System* destination = nullptr) {
+            FLOW_TEMPLATE* flow = new FLOW_TEMPLATE(name, source, destination);
             add(flow);
             return flow;
         }
 
+        static constexpr size_t NO_SYSTEM = size_t(-1); /**< Index of a name that is not a system of the model. */
+        static constexpr size_t BULK_GRAIN = 4096;     /**< Minimum number of objects built by one thread in bulk creation. */
+
+        /**
+         * @brief Reserves storage for systems and flows about to be created.
+         * @param numSystems The number of systems the model will hold.
+         * @param numFlows The number of flows the model will hold.
+         * @return None.
+         */
+        virtual void reserve(size_t numSystems, size_t numFlows) = 0;
+
+        /**
+         * @brief Creates many systems at once.
+         * @details The systems are constructed in parallel, each thread building a contiguous chunk, and 
+         * added to the model together at the end, so building large generated models is not serialized 
+         * on one allocation and insertion per system.
+         * @param names The name of each system.
+         * @param values The initial value of each system.
+         * @return The new systems, in the order of the names, or an empty vector if the sizes differ.
+         * 
+         * @note The systems are added to the model in the order of the names.
+         */
+        virtual vector<System*> createSystems(std::span<const string> names, std::span<const double> values) = 0;
+
+        /**
+         * @brief Creates many flows of the same type at once.
+         * @details Like createSystems, the flows are constructed in parallel chunks and added together.
+         * @tparam FLOW_TEMPLATE The type of flow to be created.
+         * @param names The name of each flow.
+         * @param sources The source system of each flow.
+         * @param destinations The destination system of each flow.
+         * @return The new flows, with their concrete type, or an empty vector if the sizes differ.
+         * 
+         * @note FLOW_TEMPLATE must be constructible from several threads at once.
+         */
+        template <typename FLOW_TEMPLATE>
+        vector<FLOW_TEMPLATE*> createFlows(std::span<const string> names, std::span<System* const> sources,
+                                           std::span<System* const> destinations) {
+            if (sources.size() != names.size() || destinations.size() != names.size()) {
+                return {};
+            }
+            vector<FLOW_TEMPLATE*> flows(names.size());
+            ThreadPool::getInstance().parallelRange(names.size(), BULK_GRAIN, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    flows[i] = new FLOW_TEMPLATE(names[i], sources[i], destinations[i]);
+                }
+            });
+            add(vector<Flow*>(flows.begin(), flows.end()));
+            return flows;
+        }
+
+        /**
+         * @brief Creates a new flow whose equation is given as an expression.
+         * @details The expression is parsed once and may reference `source`, `destination` (or `dest`), 
+         * model parameters and systems of the model by name, in that order of precedence; see Expression 
+         * for the syntax. The model evaluates it with a bytecode interpreter, so new flow laws need neither 
+         * a FlowHandle subclass nor a rebuild of the library.
+         * @param name The name of the flow to be created.
+         * @param source Pointer to the source system of the flow.
+         * @param destination Pointer to the destination system of the flow.
+         * @param expression The equation of the flow, e.g. `0.01 * dest * (1 - dest / 70)`.
+         * @return A pointer to the newly created flow, or nullptr if the expression is invalid or references 
+         * an unknown name.
+         * 
+         * @note Parameters must be set before the flows that reference them are created.
+         */
+        virtual Flow* createFlow(const string& name, System* source, System* destination, const string& expression) = 0;
+
+        /**
+         * @brief Sets the value of a model parameter, creating it if needed.
+         * @param name The name of the parameter.
+         * @param value The new value of the parameter.
+         * @return None.
+         * 
+         * @note Changes take effect at the next step, without rebuilding the flows that reference the parameter.
+         */
+        virtual void setParameter(const string& name, double value) = 0;
+
+        /**
+         * @brief Gets the value of a model parameter.
+         * @param name The name of the parameter.
+         * @return The value of the parameter, or zero if there is no parameter with that name.
+         */
+        virtual double getParameter(const string& name) const = 0;
+
+        /**
+         * @brief Sets the run of the model, which keys the random numbers of its stochastic flows.
+         * @details The noise of a stochastic flow in a step depends only on the run, the flow and the time, so 
+         * runs with the same number repeat the same noise and runs with different numbers draw independent 
+         * noise. Forks start with the run of their model; Monte Carlo replicates give each fork its own.
+         * @param run The run.
+         * @return None.
+         * @see StochasticFlow
+         */
+        virtual void setRun(uint64_t run) = 0;
+
+        /**
+         * @brief Gets the run of the model.
+         * @return The run, 0 unless set.
+         */
+        virtual uint64_t getRun() const = 0;
+
+        /**
+         * @brief Schedules a discrete event, applied when a run reaches its time.
+         * @details Pending events are kept in a priority queue, so scheduling and applying an event costs 
+         * O(log n), and steps without events cost nothing more than an integer comparison. Each event is 
+         * applied once; steady-state detection does not end a run before its pending events.
+         * @param event The event.
+         * @return None.
+         */
+        virtual void schedule(const Event& event) = 0;
+
+        /**
+         * @brief Removes all pending events.
+         * @return None.
+         */
+        virtual void clearEvents() = 0;
+
+        /**
+         * @brief Enables or disables a flow of the model.
+         * @details A disabled flow stays in the model but does not take part in runs until enabled again.
+         * @param flow The flow.
+         * @param enabled Whether the flow takes part in runs.
+         * @return True if the flow belongs to the model, false otherwise.
+         */
+        virtual bool setFlowEnabled(Flow* flow, bool enabled) = 0;
+
+        /**
+         * @brief Drives a system of the model with an input series.
+         * @details At the start of a run and after each step, the value of the system is set to the value of 
+         * the series at the current time, inside the step loop, so the values reported for a time include 
+         * the input. The series is read forward as the runs advance. Events of the same time are applied 
+         * after the inputs.
+         * @param system The system.
+         * @param series The series, which must outlive the binding; null removes the binding of the system.
+         * @return True if the system belongs to the model, false otherwise.
+         * 
+         * @note A run does not end at steady state while inputs are bound, and fastForward steps such runs.
+         */
+        virtual bool bindInput(System* system, const TimeSeries* series) = 0;
+
+        /**
+         * @brief Drives a model parameter with an input series.
+         * @details Like bindInput for systems; the parameter is created if needed.
+         * @param parameter The name of the parameter.
+         * @param series The series, which must outlive the binding; null removes the binding of the parameter.
+         * @return True.
+         */
+        virtual bool bindInput(const string& parameter, const TimeSeries* series) = 0;
+
+        /**
+         * @brief Feeds the values of a system to an aggregator as runs advance.
+         * @details After every step, once the inputs and events of its time are applied, the value of the 
+         * system is added to the aggregator, inside the step loop. A system may feed several aggregators.
+         * @param system The system.
+         * @param aggregator The aggregator, which must outlive the attachment.
+         * @return True if the system belongs to the model, false otherwise.
+         * 
+         * @note Forks do not inherit the aggregators of their model. fastForward steps runs with aggregators.
+         */
+        virtual bool attachAggregator(System* system, Aggregator* aggregator) = 0;
+
+        /**
+         * @brief Stops feeding an aggregator.
+         * @param aggregator The aggregator.
+         * @return True if the aggregator was attached, false otherwise.
+         * 
+         * @note The open window of the aggregator is left open; see Aggregator::flush.
+         */
+        virtual bool detachAggregator(Aggregator* aggregator) = 0;
+
+        /**
+         * @brief Sets the profiler timing the flows of the runs of the model.
+         * @details One step in the period of the profiler is timed, flow by flow; the values of the runs are 
+         * the same with or without profiler.
+         * @param profiler The profiler, which must outlive its use by the model, or null to stop profiling.
+         * @return None.
+         * @see Profiler
+         */
+        virtual void setProfiler(Profiler* profiler) = 0;
+
+        /**
+         * @brief Queues an edit of the model, to be applied between two steps.
+         * @details Systems, flows and parameters must not be changed while a run is in progress, since the 
+         * step loop works on a plan built from them. Staged edits can be queued from any thread at any 
+         * time: a run applies all the edits queued so far, in order and together, before its next step, 
+         * and updates only the part of the execution plan they changed. Edits queued while no run is in 
+         * progress are applied at the start of the next run, or by applyStagedEdits.
+         * 
+         * @code
+         * model->stageEdit([flow](Model* model) { model->deleteFlow(flow); });
+         * @endcode
+         * @param edit The edit, called with this model on the thread running the model.
+         * @return None.
+         * 
+         * @note Queuing is lock-free, and the step loop only checks the queue with an atomic load.
+         * @warning Edits must not run or fork the model.
+         */
+        virtual void stageEdit(std::function<void(Model*)> edit) = 0;
+
+        /**
+         * @brief Applies the staged edits now, from the thread that owns the model, outside a run.
+         * @return The number of edits applied.
+         */
+        virtual size_t applyStagedEdits() = 0;
+
+        /**
+         * @brief Gets the names of the model parameters.
+         * @return The names, in the order in which the parameters were created.
+         */
+        virtual vector<string> getParameterNames() const = 0;
+
+        /**
+         * @brief Gets the number of systems of the model.
+         * @return The number of systems, which is also the size of the buffers of readValues and writeValues.
+         */
+        virtual size_t getNumSystems() const = 0;
+
+        /**
+         * @brief Maps system names to their indices, in the order of beginSystems.
+         * @details Indices stay valid until a system is deleted, so names can be resolved once and the 
+         * indexed readValues and writeValues used at every step.
+         * @param names The names of the systems.
+         * @return The index of each system, or NO_SYSTEM for names of no system of the model.
+         */
+        virtual vector<size_t> getSystemIndices(std::span<const string> names) = 0;
+
+        /**
+         * @brief Copies the values of all systems into a buffer.
+         * @param values The buffer, with one element per system, in the order of beginSystems.
+         * @return True if the values were copied, false if the buffer does not have getNumSystems elements.
+         */
+        virtual bool readValues(std::span<double> values) const = 0;
+
+        /**
+         * @brief Copies the values of some systems into a buffer.
+         * @param indices The indices of the systems, as returned by getSystemIndices.
+         * @param values The buffer receiving the value of each indexed system.
+         * @return True if the values were copied, false if the sizes differ or an index is out of range.
+         */
+        virtual bool readValues(std::span<const size_t> indices, std::span<double> values) const = 0;
+
+        /**
+         * @brief Sets the values of all systems from a buffer, for instance to reset a model between runs.
+         * @param values The new values, with one element per system, in the order of beginSystems.
+         * @return True if the values were set, false if the buffer does not have getNumSystems elements.
+         */
+        virtual bool writeValues(std::span<const double> values) = 0;
+
+        /**
+         * @brief Sets the values of some systems from a buffer.
+         * @param indices The indices of the systems, as returned by getSystemIndices.
+         * @param values The new value of each indexed system.
+         * @return True if the values were set, false if the sizes differ or an index is out of range.
+         * 
+         * @note Nothing is written when false is returned.
+         */
+        virtual bool writeValues(std::span<const size_t> indices, std::span<const double> values) = 0;
+
+        /**
+         * @brief Returns an iterator to the first system of the model.
+         * @return An iterator to the beginning of the systems, in order of creation.
+         */
+        virtual SystemIterator beginSystems() = 0;
+
+        /**
+         * @brief Returns an iterator past the last system of the model.
+         * @return An iterator to the end of the systems.
+         */
+        virtual SystemIterator endSystems() = 0;
+
+        /**
+         * @brief Returns an iterator to the first flow of the model.
+         * @return An iterator to the beginning of the flows, in order of creation.
+         */
+        virtual FlowIterator beginFlows() = 0;
+
+        /**
+         * @brief Returns an iterator past the last flow of the model.
+         * @return An iterator to the end of the flows.
+         */
+        virtual FlowIterator endFlows() = 0;
+
         /**
          * @brief Deletes a flow from the model.
          * @param name The name of the flow to be deleted.
@@ -167,6 +578,123 @@ class Model {
          */
         virtual void execute(int startTime, int endTime, int timeStep) = 0;
 
+        /**
+         * @brief Lazily executes the model simulation, one step per generator increment.
+         * @details Returns a pull-driven generator. Each increment advances the model by one time step 
+         * and yields a StepView of the state after that step, so consumers can stop as soon as they 
+         * have what they need (for instance with `std::views::take` or `std::ranges::find_if`).
+         * @param startTime The time at which the model execution begins.
+         * @param endTime The time at which the model execution ends.
+         * @param timeStep The increment in time between each execution step.
+         * @return A generator of StepView objects, one per executed step.
+         * 
+         * @note No step is executed before the generator is iterated, and the systems hold the values of 
+         * the last step pulled by the consumer.
+         * @warning The generator refers to the model; it must not outlive it, and the model must not be 
+         * modified while the generator is being consumed.
+         */
+        virtual Generator<StepView> steps(int startTime, int endTime, int timeStep) = 0;
+
+        /**
+         * @brief Executes the model simulation, jumping directly to the end time when every flow is linear.
+         * @details When all flows are linear in their sources (see Flow::isLinear), one step is the
+         * multiplication of the state by a fixed matrix, so the whole run is computed by raising that matrix
+         * to the number of steps with repeated squaring. Otherwise, when events are scheduled before the end
+         * time, inputs are bound or aggregators attached, or when stepping is estimated to be cheaper (large
+         * models run for few steps), the model is simply executed step by step.
+         * @param startTime The time at which the model execution begins.
+         * @param endTime The time at which the model execution ends.
+         * @param timeStep The increment in time between each execution step.
+         * @return True if the closed form was used, false if the model was executed step by step.
+         *
+         * @note The closed form differs from step-by-step execution only by floating-point rounding.
+         * Steady-state criteria are not evaluated when the closed form is used.
+         */
+        virtual bool fastForward(int startTime, int endTime, int timeStep) = 0;
+
+        /**
+         * @brief Executes the model and computes the derivatives of the final values (forward mode).
+         * @details The run is that of execute, and every system also carries one tangent per sensitivity 
+         * through the same steps: all derivatives come out of this single run instead of two extra runs per 
+         * parameter with finite differences. The tangents of a system are contiguous, so each flow updates 
+         * all directions in one vectorizable loop; the cost is about (1 + sensitivities) times a run.
+         * Linear, expression and lookup flows are differentiated exactly, and stochastic flows for the noise 
+         * drawn in the run, which does not depend on the values; systems driven by inputs have no derivative. Steady-state criteria do not end the run early, and edits staged during the run are 
+         * applied at the next one.
+         * @param startTime The time at which the model execution begins.
+         * @param endTime The time at which the model execution ends.
+         * @param timeStep The increment in time between each execution step.
+         * @param with The quantities to differentiate against.
+         * @param sensitivities Receives the derivative of the value of system i at the end of the run with 
+         * respect to `with[j]` at `i * with.size() + j`; must hold systems times `with.size()` elements.
+         * @return True if the model was executed, false (with nothing executed) if the size of sensitivities 
+         * is wrong, a sensitivity refers to something outside the model or a flow that is not linear, some 
+         * flow cannot be differentiated (generic and delay flows), or events are scheduled before the end time.
+         */
+        virtual bool computeSensitivities(int startTime, int endTime, int timeStep, std::span<const Sensitivity> with,
+                                          std::span<double> sensitivities) = 0;
+
+        /**
+         * @brief Executes the model and computes the gradient of a loss of the run (reverse mode).
+         * @details The run is that of execute, followed by an adjoint pass that goes back through the steps 
+         * and yields the derivatives of the loss with respect to every parameter, linear flow rate and 
+         * initial value at once, whatever their number. The steps are not all kept for the way back: the 
+         * values are saved every few steps (checkpoints), and the steps between two checkpoints are executed 
+         * again when the adjoint pass reaches them. With c checkpoints over s steps, memory holds about 
+         * c + s / c state vectors and the cost is about three runs; c defaults to the square root of s.
+         * The derivatives and restrictions are those of computeSensitivities.
+         * @param startTime The time at which the model execution begins.
+         * @param endTime The time at which the model execution ends.
+         * @param timeStep The increment in time between each execution step.
+         * @param loss The loss, called with the values after every step of the run.
+         * @param gradient Receives the loss and its gradient.
+         * @param checkpoints The number of checkpoints, or 0 for the square root of the number of steps.
+         * @return True if the model was executed, false (with nothing executed) if some flow cannot be 
+         * differentiated (generic and delay flows) or events are scheduled before the end time.
+         * 
+         * @note The loss is called once per step, when the adjoint pass executes the step again: segments 
+         * come from the end of the run to its start, steps in time order within a segment. It should only 
+         * depend on its arguments. The values left by the run are those of execute. Steps executed again are 
+         * not counted by the profiler of the model.
+         */
+        virtual bool computeGradient(int startTime, int endTime, int timeStep, const Loss& loss, Gradient& gradient,
+                                     size_t checkpoints = 0) = 0;
+
+        /**
+         * @brief Generates, compiles and loads a specialized step function for the current topology.
+         * @details Writes a C++ translation unit in which every flow is inlined into a single step function, 
+         * builds it as a shared library with the local compiler (the CXX environment variable, or g++) and 
+         * loads it with dlopen. Later runs use the compiled function instead of the generic evaluation, 
+         * matching its results within a relative tolerance of 1e-9.
+         * @param directory The directory receiving the generated source and library, which are removed once 
+         * the library is loaded.
+         * @return True if the step function was compiled and loaded, false if some flow has no symbolic form 
+         * (only linear, expression, lookup, delay and stochastic flows do) or the compiler failed.
+         * 
+         * @note Rates and parameters may change freely; adding or removing systems or flows, or changing an 
+         * expression (see ExpressionFlow::setExpression), discards the compiled function and the model goes 
+         * back to the generic evaluation until compiled again.
+         */
+        virtual bool compile(const string& directory) = 0;
+
+        /**
+         * @brief Sets the criteria used to end runs early once they reach equilibrium.
+         * @param criteria The steady-state criteria; a zero tolerance disables the detection.
+         * @return None.
+         * 
+         * @note The criteria apply to every later call of execute and steps.
+         */
+        virtual void setSteadyState(const SteadyState& criteria) = 0;
+
+        /**
+         * @brief Gets the time at which the last run reached steady state.
+         * @return The detection time, or -1 if the last run did not reach steady state.
+         * 
+         * @note When the criteria stop the run, this is also the current time of the model; when they 
+         * fast-forward it, the current time is the end time of the run.
+         */
+        virtual int getSteadyStateTime() const = 0;
+
     protected:
         /**
          * @brief Adds a system to the model.
@@ -185,6 +713,13 @@ class Model {
          * @note The flow is added to the model's collection of flows for simulation.
          */
         virtual void add(Flow* flow) = 0;
+
+        /**
+         * @brief Adds many flows to the model at once.
+         * @param flows The flows to be added, in order.
+         * @return None.
+         */
+        virtual void add(std::span<Flow* const> flows) = 0;
 };
 
 #endif
\ No newline at end of file
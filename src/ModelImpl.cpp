@@ -1,9 +1,18 @@
 #include "ModelImpl.hpp"
 #include "SystemImpl.hpp"
 #include "FlowImpl.hpp"
+#include "DenseMatrix.hpp"
+#include "ExpressionFlow.hpp"
+#include "Trace.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
 
 Model* ModelHandle::_instance = nullptr;
 
@@ -27,12 +36,135 @@ bool Model::deleteModel() {
     return false;
 }
 
+namespace {
+
+// Systems and flows held by more than one topology after a copy-on-write, with the number of holders.
+// Objects absent from the table belong to a single topology, which may delete them.
+std::mutex sharedObjectsMutex;
+std::unordered_map<const void*, size_t> sharedObjects;
+
+void share(const void* object) {
+    auto inserted = sharedObjects.emplace(object, 2);
+    if (!inserted.second) {
+        inserted.first->second++;
+    }
+}
+
+// Drops one holder of an object; returns true if it had no other holder and may be deleted.
+bool release(const void* object) {
+    std::lock_guard<std::mutex> lock(sharedObjectsMutex);
+    auto it = sharedObjects.find(object);
+    if (it == sharedObjects.end()) {
+        return true;
+    }
+    if (--it->second == 1) {
+        sharedObjects.erase(it);
+    }
+    return false;
+}
+
+}
+
+ModelBody::ModelBody() : topology(new ModelTopology) {
+    topology->attach();
+}
+
+ModelBody::~ModelBody() {
+    StagedEdit* edit = stagedEdits.exchange(nullptr);
+    while (edit) {
+        delete std::exchange(edit, edit->next);
+    }
+    topology->detach();
+}
+
+void ModelBody::forkInto(ModelBody& fork) {
+    // Build what forks read before sharing it, so that forks never write to the shared topology.
+    preparePlan();
+    buildSystemIndex();
+    if (!forked) {
+        state.resize(topology->systems.size());
+        readValues(state);
+        topology->plan.loadDelays(delays, false);
+    }
+
+    topology->attach();
+    fork.topology->detach();
+    fork.topology = topology;
+    fork.forked = true;
+    fork.name = name;
+    fork.currentTime = currentTime;
+    fork.state = state;
+    fork.delays = delays;
+    fork.steadyState = steadyState;
+    fork.events = events;
+    fork.inputs = inputs;
+    fork.eventSequence = eventSequence;
+    fork.parameters = parameters;
+    fork.run = run;
+    fork.parameterIndices = parameterIndices;
+    fork.parameterNames = parameterNames;
+}
+
+void ModelBody::detachTopology() {
+    if (topology->refCount() == 1) {
+        return;
+    }
+
+    ModelTopology* copy = new ModelTopology;
+    copy->systems = topology->systems;
+    copy->flows = topology->flows;
+    copy->disabledFlows = topology->disabledFlows;
+    copy->parameters = topology->parameters;
+    {
+        std::lock_guard<std::mutex> lock(sharedObjectsMutex);
+        for (System* system : copy->systems) {
+            share(system);
+        }
+        for (Flow* flow : copy->flows) {
+            share(flow);
+        }
+    }
+    copy->attach();
+    topology->detach();
+    topology = copy;
+}
+
 void ModelBody::add(System* system) {
-    systems.push_back(system);
+    detachTopology();
+    topology->systems.push_back(system);
+    topology->planOutdated = true;
+    if (!topology->namesOutdated) {
+        topology->systemIndices.emplace(system->getName(), topology->systems.size() - 1);
+    }
+    if (forked) {
+        state.push_back(system->getValue());
+    }
 }
 
 void ModelBody::add(Flow* flow) {
-    flows.push_back(flow);
+    detachTopology();
+    topology->flows.push_back(flow);
+    if (!topology->planOutdated) {
+        topology->plan.addFlow(flow);
+        topology->compiledStep.reset();
+    }
+}
+
+void ModelBody::add(std::span<Flow* const> newFlows) {
+    detachTopology();
+    topology->flows.insert(topology->flows.end(), newFlows.begin(), newFlows.end());
+    if (!topology->planOutdated) {
+        for (Flow* flow : newFlows) {
+            topology->plan.addFlow(flow);
+        }
+        topology->compiledStep.reset();
+    }
+}
+
+void ModelBody::reserve(size_t numSystems, size_t numFlows) {
+    detachTopology();
+    topology->systems.reserve(numSystems);
+    topology->flows.reserve(numFlows);
 }
 
 System* ModelBody::createSystem(const string& name, double value) {
@@ -41,24 +173,460 @@ System* ModelBody::createSystem(const string& name, double value) {
     return system;
 }
 
+vector<System*> ModelBody::createSystems(std::span<const string> names, std::span<const double> values) {
+    if (values.size() != names.size()) {
+        return {};
+    }
+
+    // Each thread builds a contiguous chunk in place; the chunks are then appended with a single insertion.
+    vector<System*> created(names.size());
+    ThreadPool::getInstance().parallelRange(names.size(), Model::BULK_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            created[i] = new SystemHandle(names[i], values[i]);
+        }
+    });
+
+    detachTopology();
+    topology->systems.insert(topology->systems.end(), created.begin(), created.end());
+    topology->planOutdated = true;
+    topology->namesOutdated = true;
+    if (forked) {
+        state.insert(state.end(), values.begin(), values.end());
+    }
+    return created;
+}
+
 bool ModelBody::deleteSystem(System* system) {
+    vector<System*>& systems = topology->systems;
     auto it = std::find(systems.begin(), systems.end(), system);
-    if (it != systems.end()) {
-        systems.erase(it);
+    if (it == systems.end()) {
+        return false;
+    }
+
+    size_t index = it - systems.begin();
+    detachTopology();
+    topology->systems.erase(topology->systems.begin() + index);
+    std::erase_if(inputs, [system](const InputBinding& input) { return input.system == system; });
+    std::erase_if(aggregators, [system](const Attachment& attachment) { return attachment.system == system; });
+    if (forked) {
+        state.erase(state.begin() + index);
+    }
+    if (release(system)) {
         delete system;
-        return true;
     }
-    return false;
+    topology->planOutdated = true;
+    topology->namesOutdated = true;
+    return true;
 }
 
 bool ModelBody::deleteFlow(Flow* flow) {
+    vector<Flow*>& flows = topology->flows;
     auto it = std::find(flows.begin(), flows.end(), flow);
-    if (it != flows.end()) {
-        flows.erase(it);
+    if (it == flows.end()) {
+        return false;
+    }
+
+    size_t index = it - flows.begin();
+    detachTopology();
+    topology->flows.erase(topology->flows.begin() + index);
+    topology->disabledFlows.erase(flow);
+    if (!topology->planOutdated) {
+        topology->plan.removeFlow(flow);
+        topology->compiledStep.reset();
+    }
+    if (release(flow)) {
         delete flow;
+    }
+    return true;
+}
+
+Flow* ModelBody::createFlow(const string& name, System* source, System* destination, const string& expression) {
+    ExpressionFlow* flow = new ExpressionFlow(name, source, destination);
+    if (!flow->setExpression(expression) || !bindExpression(flow)) {
+        delete flow;
+        return nullptr;
+    }
+
+    add(flow);
+    return flow;
+}
+
+bool ModelBody::bindExpression(ExpressionFlow* flow) {
+    vector<ExpressionFlow::Symbol> symbols;
+    for (const string& symbol : flow->getExpression().getSymbols()) {
+        auto parameter = parameterIndices.find(symbol);
+        if (symbol == "source") {
+            symbols.push_back({ExpressionFlow::SOURCE, nullptr, 0});
+        } else if (symbol == "destination" || symbol == "dest") {
+            symbols.push_back({ExpressionFlow::DESTINATION, nullptr, 0});
+        } else if (parameter != parameterIndices.end()) {
+            symbols.push_back({ExpressionFlow::PARAMETER, nullptr, parameter->second});
+        } else if (System* system = findSystem(symbol)) {
+            symbols.push_back({ExpressionFlow::SYSTEM, system, 0});
+        } else {
+            return false;
+        }
+    }
+    flow->bind(symbols, topology->parameters);
+    return true;
+}
+
+System* ModelBody::findSystem(const string& name) {
+    size_t index = findSystemIndex(name);
+    return index == Model::NO_SYSTEM ? nullptr : topology->systems[index];
+}
+
+void ModelBody::buildSystemIndex() {
+    if (!topology->namesOutdated) {
+        return;
+    }
+    topology->systemIndices.clear();
+    for (size_t i = 0; i < topology->systems.size(); i++) {
+        topology->systemIndices.emplace(topology->systems[i]->getName(), i);
+    }
+    topology->namesOutdated = false;
+}
+
+size_t ModelBody::findSystemIndex(const string& name) {
+    buildSystemIndex();
+    auto it = topology->systemIndices.find(name);
+    return it == topology->systemIndices.end() ? Model::NO_SYSTEM : it->second;
+}
+
+size_t ModelBody::getNumSystems() const {
+    return topology->systems.size();
+}
+
+vector<size_t> ModelBody::getSystemIndices(std::span<const string> names) {
+    vector<size_t> indices(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        indices[i] = findSystemIndex(names[i]);
+    }
+    return indices;
+}
+
+bool ModelBody::readValues(std::span<double> values) const {
+    const vector<System*>& systems = topology->systems;
+    if (values.size() != systems.size()) {
+        return false;
+    }
+    if (forked) {
+        std::copy(state.begin(), state.end(), values.begin());
         return true;
     }
-    return false;
+    ThreadPool::getInstance().parallelRange(systems.size(), Model::BULK_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            values[i] = systems[i]->getValue();
+        }
+    });
+    return true;
+}
+
+bool ModelBody::readValues(std::span<const size_t> indices, std::span<double> values) const {
+    const vector<System*>& systems = topology->systems;
+    if (values.size() != indices.size()) {
+        return false;
+    }
+    for (size_t index : indices) {
+        if (index >= systems.size()) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < indices.size(); i++) {
+        values[i] = forked ? state[indices[i]] : systems[indices[i]]->getValue();
+    }
+    return true;
+}
+
+bool ModelBody::writeValues(std::span<const double> values) {
+    const vector<System*>& systems = topology->systems;
+    if (values.size() != systems.size()) {
+        return false;
+    }
+    if (forked) {
+        std::copy(values.begin(), values.end(), state.begin());
+        return true;
+    }
+    ThreadPool::getInstance().parallelRange(systems.size(), Model::BULK_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            systems[i]->setValue(values[i]);
+        }
+    });
+    return true;
+}
+
+bool ModelBody::writeValues(std::span<const size_t> indices, std::span<const double> values) {
+    const vector<System*>& systems = topology->systems;
+    if (values.size() != indices.size()) {
+        return false;
+    }
+    for (size_t index : indices) {
+        if (index >= systems.size()) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < indices.size(); i++) {
+        if (forked) {
+            state[indices[i]] = values[i];
+        } else {
+            systems[indices[i]]->setValue(values[i]);
+        }
+    }
+    return true;
+}
+
+void ModelBody::setParameter(const string& name, double value) {
+    auto it = parameterIndices.find(name);
+    if (it == parameterIndices.end()) {
+        parameterIndices.emplace(name, parameters.size());
+        parameterNames.push_back(name);
+        parameters.push_back(value);
+    } else {
+        parameters[it->second] = value;
+    }
+    // Forks only lend their parameters to the flows while they lend their values to the systems.
+    if (!forked) {
+        *topology->parameters = parameters;
+    }
+}
+
+void ModelBody::setRun(uint64_t run) {
+    this->run = run;
+}
+
+uint64_t ModelBody::getRun() const {
+    return run;
+}
+
+double ModelBody::getParameter(const string& name) const {
+    auto it = parameterIndices.find(name);
+    return it == parameterIndices.end() ? 0.0 : parameters[it->second];
+}
+
+void ModelBody::schedule(const Event& event) {
+    events.push({event, eventSequence++});
+}
+
+void ModelBody::clearEvents() {
+    events = {};
+}
+
+bool ModelBody::setFlowEnabled(Flow* flow, bool enabled) {
+    const vector<Flow*>& flows = topology->flows;
+    if (std::find(flows.begin(), flows.end(), flow) == flows.end()) {
+        return false;
+    }
+    if ((topology->disabledFlows.count(flow) == 0) == enabled) {
+        return true;
+    }
+
+    detachTopology();
+    if (enabled) {
+        topology->disabledFlows.erase(flow);
+    } else {
+        topology->disabledFlows.insert(flow);
+    }
+    if (!topology->planOutdated) {
+        if (enabled) {
+            topology->plan.addFlow(flow);
+        } else {
+            topology->plan.removeFlow(flow);
+        }
+        topology->compiledStep.reset();
+    }
+    return true;
+}
+
+bool ModelBody::bindInput(System* system, const TimeSeries* series) {
+    const vector<System*>& systems = topology->systems;
+    if (!system || std::find(systems.begin(), systems.end(), system) == systems.end()) {
+        return false;
+    }
+    std::erase_if(inputs, [system](const InputBinding& input) { return input.system == system; });
+    if (series) {
+        inputs.push_back({series, system, 0, topology->plan.indexOf(system), {}});
+    }
+    return true;
+}
+
+bool ModelBody::bindInput(const string& parameter, const TimeSeries* series) {
+    if (parameterIndices.count(parameter) == 0) {
+        setParameter(parameter, 0.0);
+    }
+    size_t index = parameterIndices[parameter];
+    std::erase_if(inputs, [index](const InputBinding& input) { return !input.system && input.parameter == index; });
+    if (series) {
+        inputs.push_back({series, nullptr, index, -1, {}});
+    }
+    return true;
+}
+
+void ModelBody::applyInputs(int time) {
+    if (inputs.empty()) {
+        return;
+    }
+    Trace::Scope trace("inputs", "model");
+    bool readsSystems = topology->plan.readsSystems();
+    for (InputBinding& input : inputs) {
+        double value = input.series->valueAt(input.cursor, time);
+        if (!input.system) {
+            parameters[input.parameter] = value;
+        } else if (input.index >= 0) {
+            state[input.index] = value;
+            // Generic flows read the systems, which already hold the values of this step.
+            if (readsSystems) {
+                input.system->setValue(value);
+            }
+        }
+    }
+}
+
+bool ModelBody::attachAggregator(System* system, Aggregator* aggregator) {
+    const vector<System*>& systems = topology->systems;
+    if (!system || !aggregator || std::find(systems.begin(), systems.end(), system) == systems.end()) {
+        return false;
+    }
+    aggregators.push_back({aggregator, system, topology->plan.indexOf(system)});
+    return true;
+}
+
+bool ModelBody::detachAggregator(Aggregator* aggregator) {
+    return std::erase_if(aggregators, [aggregator](const Attachment& attachment) {
+        return attachment.aggregator == aggregator;
+    }) > 0;
+}
+
+void ModelBody::setProfiler(Profiler* profiler) {
+    this->profiler = profiler;
+}
+
+void ModelBody::aggregate(int time) {
+    if (aggregators.empty()) {
+        return;
+    }
+    Trace::Scope trace("record", "model");
+    for (const Attachment& attachment : aggregators) {
+        if (attachment.index >= 0) {
+            attachment.aggregator->add(time, state[attachment.index]);
+        }
+    }
+}
+
+int ModelBody::nextEventTime() const {
+    return events.empty() ? std::numeric_limits<int>::max() : events.top().event.time;
+}
+
+void ModelBody::applyEvents(int time) {
+    Trace::Scope trace("events", "model");
+    // Events may move the model away from equilibrium, so detection starts over.
+    steadySteps = 0;
+    bool valuesChanged = false;
+    bool flowsChanged = false;
+    while (!events.empty() && events.top().event.time <= time) {
+        Event event = events.top().event;
+        events.pop();
+
+        switch (event.kind) {
+            case Event::SET_VALUE:
+            case Event::IMPULSE: {
+                long index = topology->plan.indexOf(event.system);
+                if (index >= 0) {
+                    state[index] = event.kind == Event::SET_VALUE ? event.value : state[index] + event.value;
+                    valuesChanged = true;
+                }
+                break;
+            }
+            case Event::ENABLE_FLOW:
+            case Event::DISABLE_FLOW:
+                // The plan is brought up to date at once, so that later events of the batch can use it.
+                if (setFlowEnabled(event.flow, event.kind == Event::ENABLE_FLOW)) {
+                    preparePlan();
+                    flowsChanged = true;
+                }
+                break;
+            case Event::SET_PARAMETER:
+                setParameter(event.parameter, event.value);
+                break;
+        }
+    }
+
+    // Generic flows read the systems: give them the new values, and lend or return the shared
+    // systems of a fork when generic flows were enabled or disabled.
+    bool readsSystems = topology->plan.readsSystems();
+    if (forked && flowsChanged && !readsSystems) {
+        restoreSystems();
+    } else if (forked && readsSystems && savedValues.empty()) {
+        saveSystems();
+    }
+    if (readsSystems && (valuesChanged || flowsChanged)) {
+        storeState();
+    }
+    if (flowsChanged) {
+        if (!forked) {
+            topology->plan.storeDelays(delays);
+        }
+        topology->plan.loadDelays(delays, true);
+    }
+}
+
+void ModelBody::stageEdit(std::function<void()> edit) {
+    StagedEdit* staged = new StagedEdit{std::move(edit), stagedEdits.load(std::memory_order_relaxed)};
+    while (!stagedEdits.compare_exchange_weak(staged->next, staged, std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+    }
+}
+
+size_t ModelBody::applyStagedEdits() {
+    // The queue is taken whole, so the edits queued so far are applied together; it is pushed at the
+    // front, so it is reversed to apply them in the order they were queued.
+    StagedEdit* edit = stagedEdits.exchange(nullptr, std::memory_order_acquire);
+    StagedEdit* ordered = nullptr;
+    while (edit) {
+        edit = std::exchange(edit->next, std::exchange(ordered, edit));
+    }
+
+    size_t count = 0;
+    while (ordered) {
+        ordered->apply();
+        delete std::exchange(ordered, ordered->next);
+        count++;
+    }
+    return count;
+}
+
+void ModelBody::pollEdits() {
+    if (stagedEdits.load(std::memory_order_acquire) == nullptr) {
+        return;
+    }
+
+    // Edits see the model as between two runs, with the current values in the systems.
+    if (!forked) {
+        storeState();
+    }
+    endRun();
+    applyStagedEdits();
+    resumeState();
+    steadySteps = 0;
+}
+
+vector<string> ModelBody::getParameterNames() const {
+    return parameterNames;
+}
+
+Model::SystemIterator ModelBody::beginSystems() {
+    return topology->systems.begin();
+}
+
+Model::SystemIterator ModelBody::endSystems() {
+    return topology->systems.end();
+}
+
+Model::FlowIterator ModelBody::beginFlows() {
+    return topology->flows.begin();
+}
+
+Model::FlowIterator ModelBody::endFlows() {
+    return topology->flows.end();
 }
 
 // Métodos de acesso
@@ -78,35 +646,491 @@ void ModelBody::setCurrentTime(int time) {
     currentTime = time;
 }
 
+void ModelBody::setSteadyState(const SteadyState& criteria) {
+    steadyState = criteria;
+}
+
+int ModelBody::getSteadyStateTime() const {
+    return steadyStateTime;
+}
+
+void ModelBody::preparePlan() {
+    Trace::Scope trace("plan", "model");
+    // Expressions edited since they were bound are bound again, by name; the plan links them once bound.
+    if (topology->planOutdated) {
+        for (Flow* flow : topology->flows) {
+            ExpressionFlow* expressionFlow = dynamic_cast<ExpressionFlow*>(flow);
+            if (expressionFlow && !expressionFlow->isBound()) {
+                bindExpression(expressionFlow);
+            }
+        }
+        if (topology->disabledFlows.empty()) {
+            topology->plan.build(topology->systems, topology->flows);
+        } else {
+            vector<Flow*> enabledFlows;
+            for (Flow* flow : topology->flows) {
+                if (topology->disabledFlows.count(flow) == 0) {
+                    enabledFlows.push_back(flow);
+                }
+            }
+            topology->plan.build(topology->systems, enabledFlows);
+        }
+        topology->compiledStep.reset();
+        topology->planOutdated = false;
+    } else {
+        for (const ExecutionPlan::ExpressionEntry& expressionEntry : topology->plan.getExpressionFlows()) {
+            ExpressionFlow* expressionFlow = static_cast<ExpressionFlow*>(expressionEntry.entry.flow);
+            if (!expressionFlow->isBound()) {
+                bindExpression(expressionFlow);
+            }
+        }
+        // The compiled step embeds the expressions, so it is discarded when one of them changed.
+        if (topology->plan.update()) {
+            topology->compiledStep.reset();
+        }
+        topology->plan.refreshRates();
+    }
+}
+
+void ModelBody::loadState() {
+    applyStagedEdits();
+    resumeState();
+    steadyStateTime = -1;
+    steadySteps = 0;
+}
+
+void ModelBody::resumeState() {
+    preparePlan();
+
+    // Models that own their flows resume the delays from the flows; forks keep their own contents.
+    topology->plan.loadDelays(delays, forked);
+    for (InputBinding& input : inputs) {
+        if (input.system) {
+            input.index = topology->plan.indexOf(input.system);
+        }
+    }
+    for (Attachment& attachment : aggregators) {
+        attachment.index = topology->plan.indexOf(attachment.system);
+    }
+
+    const vector<System*>& systems = topology->systems;
+    state.resize(systems.size());
+    changes.resize(systems.size());
+    if (!forked) {
+        for (size_t i = 0; i < systems.size(); i++) {
+            state[i] = systems[i]->getValue();
+        }
+    } else if (topology->plan.readsSystems()) {
+        // Generic flows read the shared systems: lend them the values of this fork for the run.
+        saveSystems();
+        storeState();
+    }
+}
+
+void ModelBody::storeState() {
+    Trace::Scope trace("store", "model");
+    const vector<System*>& systems = topology->systems;
+    for (size_t i = 0; i < systems.size(); i++) {
+        systems[i]->setValue(state[i]);
+    }
+    *topology->parameters = parameters;
+}
+
+void ModelBody::saveSystems() {
+    const vector<System*>& systems = topology->systems;
+    savedValues.resize(systems.size());
+    for (size_t i = 0; i < systems.size(); i++) {
+        savedValues[i] = systems[i]->getValue();
+    }
+    savedParameters = *topology->parameters;
+}
+
+void ModelBody::restoreSystems() {
+    if (savedValues.empty()) {
+        return;
+    }
+    const vector<System*>& systems = topology->systems;
+    for (size_t i = 0; i < savedValues.size(); i++) {
+        systems[i]->setValue(savedValues[i]);
+    }
+    *topology->parameters = savedParameters;
+    savedValues.clear();
+}
+
+void ModelBody::endRun() {
+    if (forked) {
+        restoreSystems();
+    } else {
+        topology->plan.storeDelays(delays);
+    }
+}
+
+double ModelBody::step() {
+    Trace::Scope stepTrace("step", "model");
+    const ExecutionPlan& plan = topology->plan;
+    bool timed = profiler && profiler->sampleStep();
+    std::chrono::steady_clock::time_point start;
+    if (timed) {
+        start = std::chrono::steady_clock::now();
+    }
+
+    {
+        Trace::Scope trace("flows", "model");
+        if (topology->compiledStep) {
+            topology->compiledStep->run(state.data(), parameters.data(), plan.getRates().data(), changes.data());
+            plan.accumulateLookups(state, changes);
+        } else {
+            plan.accumulate(state, parameters, changes);
+        }
+        plan.advanceDelays(state, delays, changes);
+        plan.accumulateNoise(state, run, currentTime, changes);
+    }
+
+    // Timed steps are followed by a separate evaluation of every flow, which changes nothing.
+    if (timed) {
+        profiler->recordStep(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+        plan.profile(state, parameters, run, currentTime, timings);
+        for (const ExecutionPlan::FlowTiming& timing : timings) {
+            profiler->record(timing.flow, currentTime, timing.nanoseconds);
+        }
+    }
+
+    // The largest change is only reduced when steady-state detection is enabled.
+    Trace::Scope trace("update", "model");
+    double maxChange = 0.0;
+    size_t numSystems = state.size();
+    if (steadyState.tolerance <= 0.0) {
+        for (size_t i = 0; i < numSystems; i++) {
+            state[i] += changes[i];
+        }
+    } else if (steadyState.relative) {
+        for (size_t i = 0; i < numSystems; i++) {
+            double scale = std::max(std::fabs(state[i]), std::numeric_limits<double>::min());
+            maxChange = std::max(maxChange, std::fabs(changes[i]) / scale);
+            state[i] += changes[i];
+        }
+    } else {
+        for (size_t i = 0; i < numSystems; i++) {
+            maxChange = std::max(maxChange, std::fabs(changes[i]));
+            state[i] += changes[i];
+        }
+    }
+
+    // Generic flows read the System objects, so they must see every step; otherwise the
+    // values are only stored when the run ends or yields.
+    if (plan.readsSystems()) {
+        storeState();
+    }
+    return maxChange;
+}
+
+bool ModelBody::isSteady(double change) {
+    if (steadyState.tolerance <= 0.0) {
+        return false;
+    }
+    steadySteps = change < steadyState.tolerance ? steadySteps + 1 : 0;
+    return steadySteps >= steadyState.steps;
+}
+
 void ModelBody::execute(int startTime, int endTime, int timeStep) {
     setCurrentTime(startTime);
+    loadState();
+    applyInputs(startTime);
+    if (nextEventTime() <= startTime) {
+        applyEvents(startTime);
+    }
+    for (int currentTime = startTime + timeStep; currentTime <= endTime; currentTime += timeStep) {
+        pollEdits();
+        double change = step();
+        setCurrentTime(currentTime);
+        applyInputs(currentTime);
+        if (nextEventTime() <= currentTime) {
+            applyEvents(currentTime);
+        }
+        aggregate(currentTime);
+
+        if (isSteady(change) && nextEventTime() > endTime && inputs.empty()) {
+            steadyStateTime = currentTime;
+            if (steadyState.fastForward) {
+                setCurrentTime(currentTime + (endTime - currentTime) / timeStep * timeStep);
+            }
+            break;
+        }
+    }
+    if (!forked) {
+        storeState();
+    }
+    endRun();
+}
+
+Generator<StepView> ModelBody::steps(int startTime, int endTime, int timeStep) {
+    setCurrentTime(startTime);
+    loadState();
+    RunGuard guard{forked || !topology->plan.getDelayFlows().empty() ? this : nullptr};
+    applyInputs(startTime);
+    if (nextEventTime() <= startTime) {
+        applyEvents(startTime);
+    }
     for (int currentTime = startTime + timeStep; currentTime <= endTime; currentTime += timeStep) {
-        vector<double> systemValueChanges(systems.size(), 0.0);
+        pollEdits();
+        double change = step();
+        setCurrentTime(currentTime);
+        applyInputs(currentTime);
+        if (nextEventTime() <= currentTime) {
+            applyEvents(currentTime);
+        }
+        aggregate(currentTime);
+        if (!forked && !topology->plan.readsSystems()) {
+            storeState();
+        }
+        co_yield StepView{currentTime, std::span<const double>(state)};
 
-        for (Flow* currentFlow : flows) {
-            if (currentFlow->getSource() && currentFlow->getDestination()) {
-                double flowValue = currentFlow->equation();
+        if (isSteady(change) && nextEventTime() > endTime && inputs.empty()) {
+            steadyStateTime = currentTime;
+            break;
+        }
+    }
+}
+
+bool ModelBody::fastForward(int startTime, int endTime, int timeStep) {
+    long long numSteps = (timeStep > 0 && endTime > startTime) ? (endTime - startTime) / timeStep : 0;
+    size_t order = topology->systems.size();
 
-                auto sourceIt = std::find(systems.begin(), systems.end(), currentFlow->getSource());
-                auto destinationIt = std::find(systems.begin(), systems.end(), currentFlow->getDestination());
+    loadState();
+    const ExecutionPlan& plan = topology->plan;
+
+    // Repeated squaring costs about order^3 per bit of numSteps, stepping about (flows + systems) per step.
+    double closedFormCost = std::pow(double(order), 3) * std::log2(double(numSteps) + 1);
+    double steppingCost = double(numSteps) * double(topology->flows.size() + order);
+    // Only linear flows are part of the step matrix; events, inputs and aggregators need every step.
+    bool linear = !plan.readsSystems() && plan.getExpressionFlows().empty() && plan.getLookupGroups().empty()
+        && plan.getDelayFlows().empty() && plan.getStochasticFlows().empty();
+    bool driven = nextEventTime() <= endTime || !inputs.empty() || !aggregators.empty();
+    if (!linear || driven || numSteps == 0 || closedFormCost > steppingCost) {
+        restoreSystems();
+        execute(startTime, endTime, timeStep);
+        return false;
+    }
 
-                int sourceIndex = std::distance(systems.begin(), sourceIt);
-                int destinationIndex = std::distance(systems.begin(), destinationIt);
+    DenseMatrix stepMatrix = DenseMatrix::identity(order);
+    plan.getLinearOperator().addTo(stepMatrix);
+    stepMatrix.applyPower(state, numSteps);
+    if (!forked) {
+        storeState();
+    }
+    setCurrentTime(startTime + int(numSteps) * timeStep);
+    return true;
+}
+
+bool ModelBody::computeSensitivities(int startTime, int endTime, int timeStep, std::span<const Sensitivity> with,
+                                     std::span<double> sensitivities) {
+    applyStagedEdits();
+    preparePlan();
+    const ExecutionPlan& plan = topology->plan;
+    size_t numSystems = topology->systems.size();
+    size_t k = with.size();
+    if (sensitivities.size() != numSystems * k || !plan.isDifferentiable() || nextEventTime() <= endTime) {
+        return false;
+    }
 
-                systemValueChanges[sourceIndex] -= flowValue;
-                systemValueChanges[destinationIndex] += flowValue;
+    // Seeds: the derivative of each quantity with respect to its own direction is one.
+    vector<double> stateTangents(numSystems * k, 0.0);
+    vector<double> parameterTangents(parameters.size() * k, 0.0);
+    vector<ExecutionPlan::RateSeed> rateSeeds;
+    const vector<ExecutionPlan::FlowEntry>& linearFlows = plan.getLinearFlows();
+    for (size_t j = 0; j < k; j++) {
+        const Sensitivity& sensitivity = with[j];
+        if (sensitivity.kind == Sensitivity::PARAMETER) {
+            auto it = parameterIndices.find(sensitivity.parameter);
+            if (it == parameterIndices.end()) {
+                return false;
             }
+            parameterTangents[it->second * k + j] = 1.0;
+        } else if (sensitivity.kind == Sensitivity::RATE) {
+            auto it = std::find_if(linearFlows.begin(), linearFlows.end(), [&sensitivity](const ExecutionPlan::FlowEntry& entry) {
+                return entry.flow == sensitivity.flow;
+            });
+            if (it == linearFlows.end()) {
+                return false;
+            }
+            rateSeeds.push_back({size_t(it - linearFlows.begin()), j});
+        } else {
+            long index = plan.indexOf(sensitivity.system);
+            if (index < 0) {
+                return false;
+            }
+            stateTangents[index * k + j] = 1.0;
         }
+    }
 
-        auto systemIt = systems.begin();
-        auto valueChangeIt = systemValueChanges.begin();
+    // Values set by inputs do not depend on anything the run is differentiated against.
+    auto clearInputs = [&] {
+        for (const InputBinding& input : inputs) {
+            double* tangent = input.system ? (input.index >= 0 ? &stateTangents[input.index * k] : nullptr)
+                                           : &parameterTangents[input.parameter * k];
+            if (tangent) {
+                std::fill(tangent, tangent + k, 0.0);
+            }
+        }
+    };
 
-        while (systemIt != systems.end() && valueChangeIt != systemValueChanges.end()) {
-            (*systemIt)->setValue((*systemIt)->getValue() + *valueChangeIt);
-            ++systemIt;
-            ++valueChangeIt;
+    setCurrentTime(startTime);
+    loadState();
+    applyInputs(startTime);
+    clearInputs();
+    vector<double> tangentChanges(numSystems * k);
+    for (int currentTime = startTime + timeStep; currentTime <= endTime; currentTime += timeStep) {
+        plan.accumulateTangents(state, parameters, run, currentTime - timeStep, stateTangents.data(),
+                                parameterTangents.data(), rateSeeds, k, tangentChanges.data());
+        step();
+        for (size_t i = 0; i < stateTangents.size(); i++) {
+            stateTangents[i] += tangentChanges[i];
         }
+        setCurrentTime(currentTime);
+        applyInputs(currentTime);
+        clearInputs();
+        aggregate(currentTime);
+    }
+    if (!forked) {
+        storeState();
+    }
+    endRun();
 
+    std::copy(stateTangents.begin(), stateTangents.end(), sensitivities.begin());
+    return true;
+}
+
+bool ModelBody::computeGradient(int startTime, int endTime, int timeStep, const Model::Loss& loss, Gradient& gradient,
+                                size_t checkpoints) {
+    applyStagedEdits();
+    preparePlan();
+    const ExecutionPlan& plan = topology->plan;
+    if (!plan.isDifferentiable() || nextEventTime() <= endTime) {
+        return false;
+    }
+
+    size_t numSystems = topology->systems.size();
+    size_t numParameters = parameters.size();
+    size_t numSteps = timeStep > 0 && endTime >= startTime ? size_t((endTime - startTime) / timeStep) : 0;
+    if (checkpoints == 0) {
+        checkpoints = size_t(std::ceil(std::sqrt(double(numSteps))));
+    }
+    size_t stride = std::max<size_t>((numSteps + checkpoints - 1) / std::max<size_t>(checkpoints, 1), 1);
+
+    // A snapshot holds what a step reads: the values of the systems, then the parameters.
+    auto save = [this](vector<double>& snapshots) {
+        snapshots.insert(snapshots.end(), state.begin(), state.end());
+        snapshots.insert(snapshots.end(), parameters.begin(), parameters.end());
+    };
+    auto restore = [this, numSystems, numParameters](const vector<double>& snapshots, size_t index) {
+        auto snapshot = snapshots.begin() + index * (numSystems + numParameters);
+        std::copy(snapshot, snapshot + numSystems, state.begin());
+        std::copy(snapshot + numSystems, snapshot + numSystems + numParameters, parameters.begin());
+    };
+
+    // Forward run, keeping the snapshot before every stride-th step.
+    setCurrentTime(startTime);
+    loadState();
+    applyInputs(startTime);
+    vector<double> saved;
+    for (size_t n = 0; n < numSteps; n++) {
+        if (n % stride == 0) {
+            save(saved);
+        }
+        step();
+        int currentTime = startTime + int(n + 1) * timeStep;
         setCurrentTime(currentTime);
+        applyInputs(currentTime);
+        aggregate(currentTime);
     }
+    vector<double> finalValues = state;
+    vector<double> finalParameters = parameters;
+
+    // Values set by inputs do not depend on what came before them.
+    auto clearInputs = [this](vector<double>& adjoints) {
+        for (const InputBinding& input : inputs) {
+            if (input.system && input.index >= 0) {
+                adjoints[input.index] = 0.0;
+            }
+        }
+    };
+
+    // Adjoint pass, segment by segment from the end: each segment is executed again from its snapshot 
+    // with every step kept, then gone through backwards. Steps run again at their own time, so that 
+    // stochastic flows draw the noise of the forward run, and are left out of the profile.
+    Profiler* suspended = std::exchange(profiler, nullptr);
+    vector<double> adjoints(numSystems, 0.0);
+    vector<double> previous(numSystems);
+    vector<double> parameterAdjoints(numParameters, 0.0);
+    vector<double> rateAdjoints(plan.getLinearFlows().size(), 0.0);
+    vector<double> segment;
+    vector<double> seeds;
+    gradient.loss = 0.0;
+    for (size_t first = (numSteps == 0 ? 0 : (numSteps - 1) / stride * stride); first < numSteps; first -= stride) {
+        size_t last = std::min(first + stride, numSteps);
+        restore(saved, first / stride);
+        segment.clear();
+        seeds.assign((last - first) * numSystems, 0.0);
+        for (size_t n = first; n < last; n++) {
+            save(segment);
+            setCurrentTime(startTime + int(n) * timeStep);
+            step();
+            int currentTime = startTime + int(n + 1) * timeStep;
+            applyInputs(currentTime);
+            gradient.loss += loss(currentTime, state, std::span<double>(seeds.data() + (n - first) * numSystems, numSystems));
+        }
+        for (size_t n = last; n-- > first;) {
+            const double* seed = seeds.data() + (n - first) * numSystems;
+            for (size_t i = 0; i < numSystems; i++) {
+                adjoints[i] += seed[i];
+            }
+            clearInputs(adjoints);
+            restore(segment, n - first);
+            previous = adjoints;
+            plan.accumulateAdjoints(state, parameters, run, startTime + int(n) * timeStep, adjoints.data(),
+                                    previous.data(), parameterAdjoints.data(), rateAdjoints.data());
+            adjoints.swap(previous);
+        }
+        if (first == 0) {
+            break;
+        }
+    }
+    clearInputs(adjoints);
+    for (const InputBinding& input : inputs) {
+        if (!input.system) {
+            parameterAdjoints[input.parameter] = 0.0;
+        }
+    }
+
+    profiler = suspended;
+    setCurrentTime(startTime + int(numSteps) * timeStep);
+    state = std::move(finalValues);
+    parameters = std::move(finalParameters);
+    if (!forked) {
+        storeState();
+    }
+    endRun();
+
+    gradient.initialValues = std::move(adjoints);
+    gradient.parameters = std::move(parameterAdjoints);
+    gradient.rates.assign(topology->flows.size(), 0.0);
+    std::unordered_map<Flow*, size_t> rateIndices;
+    const vector<ExecutionPlan::FlowEntry>& linearFlows = plan.getLinearFlows();
+    for (size_t l = 0; l < linearFlows.size(); l++) {
+        rateIndices.emplace(linearFlows[l].flow, l);
+    }
+    for (size_t f = 0; f < topology->flows.size(); f++) {
+        auto it = rateIndices.find(topology->flows[f]);
+        if (it != rateIndices.end()) {
+            gradient.rates[f] = rateAdjoints[it->second];
+        }
+    }
+    return true;
+}
+
+bool ModelBody::compile(const string& directory) {
+    detachTopology();
+    preparePlan();
+    topology->compiledStep.reset(CompiledStep::compile(topology->plan, directory, "model_step"));
+    return topology->compiledStep != nullptr;
 }
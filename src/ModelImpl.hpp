@@ -5,12 +5,51 @@
 #include "System.hpp"
 #include "Bridge.hpp"
 #include "Flow.hpp"
+#include "ExecutionPlan.hpp"
+#include "CompiledStep.hpp"
+#include "TimeSeries.hpp"
+#include "Aggregator.hpp"
+#include "Profiler.hpp"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 using std::vector;
 using std::string;
 
+class ExpressionFlow;
+
 using namespace std;
 
+/**
+ * @class ModelTopology
+ * @brief Systems, flows and execution plan of a model, shared by the model and its forks.
+ * @details A topology is reference counted like any Body. Models that share it copy it before changing 
+ * their systems or flows, so a fork costs one reference and a state vector until it edits its structure.
+ * 
+ * @see ModelBody
+ */
+class ModelTopology : public Body {
+    friend class ModelBody;
+
+    private:
+        vector<System*> systems;     /**< Vector storing pointers to the systems within the model.*/
+        vector<Flow*> flows;         /**< Vector storing pointers to the flows within the model.*/
+        ExecutionPlan plan;          /**< Flattened topology used by the step loop.*/
+        bool planOutdated = true;    /**< Set when systems or flows change, so the plan is rebuilt before the next run.*/
+        std::unique_ptr<CompiledStep> compiledStep;             /**< Compiled step function of the current plan, if any.*/
+        std::unordered_map<string, size_t> systemIndices;       /**< Index of each system by name, built on demand.*/
+        bool namesOutdated = true;   /**< Set when systems change, so the name index is rebuilt before use.*/
+        std::unordered_set<Flow*> disabledFlows;                /**< Flows left out of the plan.*/
+        /// Parameter values read by ExpressionFlow::equation: those of the model owning the systems, or of
+        /// a fork while it lends its values to the systems. Kept by the copies of the topology, like the flows.
+        std::shared_ptr<vector<double>> parameters = std::make_shared<vector<double>>();
+};
+
 /**
  * @class ModelBody
  * @brief Implementation class for managing the internal state of the model.
@@ -30,15 +69,104 @@ class ModelBody : public Body {
 
     private:
         string name;                 /**< Name of the model.*/
-        vector<System*> systems;     /**< Vector storing pointers to the systems within the model.*/
-        vector<Flow*> flows;         /**< Vector storing pointers to the flows within the model.*/
+        ModelTopology* topology;     /**< Systems, flows and plan, possibly shared with forks.*/
+        bool forked = false;         /**< Set for forks, whose values live in the state vector rather than in the systems.*/
+        vector<double> savedValues;  /**< Values of the shared systems while a fork runs generic flows on them.*/
+        vector<double> savedParameters;                         /**< Parameters lent to the flows before the fork lent its own.*/
         int currentTime;             /**< Current time in the simulation.*/
+        uint64_t run = 0;            /**< Run keying the random numbers of the stochastic flows.*/
+        vector<double> state;        /**< Values of the systems, in the same order as the systems vector.*/
+        vector<double> changes;      /**< Per-step accumulation of the flow values into each system.*/
+        ExecutionPlan::DelayState delays;                       /**< Contents of the delay flows, kept apart from the shared flows during a run.*/
+        SteadyState steadyState;     /**< Criteria used to end runs early at equilibrium.*/
+        int steadyStateTime = -1;    /**< Time at which the last run reached steady state, or -1.*/
+        int steadySteps = 0;         /**< Consecutive steps the last run has stayed below the tolerance.*/
+        vector<double> parameters;   /**< Values of the model parameters.*/
+        std::unordered_map<string, size_t> parameterIndices;    /**< Index of each parameter by name.*/
+        vector<string> parameterNames;                          /**< Name of each parameter, by index.*/
+
+        /// Scheduled event with its scheduling order, which breaks ties between events of the same time.
+        struct PendingEvent {
+            Event event;
+            unsigned long sequence;
+        };
+        struct LaterEvent {
+            bool operator()(const PendingEvent& a, const PendingEvent& b) const {
+                return a.event.time != b.event.time ? a.event.time > b.event.time : a.sequence > b.sequence;
+            }
+        };
+        std::priority_queue<PendingEvent, vector<PendingEvent>, LaterEvent> events;   /**< Pending events, earliest first.*/
+        unsigned long eventSequence = 0;                        /**< Scheduling order of the next event.*/
+
+        /// Input series driving a system or a parameter, with the read position of this model.
+        struct InputBinding {
+            const TimeSeries* series;
+            System* system;                 /**< The driven system, or null for a parameter. */
+            size_t parameter;               /**< Index of the driven parameter. */
+            long index;                     /**< Index of the system in the state vector, resolved for each run. */
+            TimeSeries::Cursor cursor;
+        };
+        vector<InputBinding> inputs;                            /**< Bound input series.*/
+
+        /// Aggregator fed with the values of a system.
+        struct Attachment {
+            Aggregator* aggregator;
+            System* system;
+            long index;                     /**< Index of the system in the state vector, resolved for each run. */
+        };
+        vector<Attachment> aggregators;                         /**< Attached aggregators.*/
+        Profiler* profiler = nullptr;                           /**< Profiler timing the steps, or null.*/
+        vector<ExecutionPlan::FlowTiming> timings;              /**< Flow timings of the last timed step.*/
+
+        /// Edit queued by stageEdit, in a lock-free list pushed from any thread.
+        struct StagedEdit {
+            std::function<void()> apply;
+            StagedEdit* next;
+        };
+        std::atomic<StagedEdit*> stagedEdits{nullptr};      /**< Pending edits, most recent first.*/
+
+        /// Ends a run of steps, even if its generator is destroyed mid-run: restores the shared systems of
+        /// a fork, or stores the contents of the delays of a model that owns its flows.
+        struct RunGuard {
+            ModelBody* body;   /**< The model that is running, or null if there is nothing to do at the end.*/
+            ~RunGuard() {
+                if (body) {
+                    body->endRun();
+                }
+            }
+        };
+
+        void detachTopology();
+        System* findSystem(const string& name);
+        void buildSystemIndex();
+        size_t findSystemIndex(const string& name);
+        bool bindExpression(ExpressionFlow* flow);
+
+        void preparePlan();
+        void loadState();
+        void resumeState();
+        void storeState();
+        void pollEdits();
+        int nextEventTime() const;
+        void applyEvents(int time);
+        void applyInputs(int time);
+        void aggregate(int time);
+        void saveSystems();
+        void restoreSystems();
+        void endRun();
+        double step();
+        bool isSteady(double change);
 
     public:
         
-        virtual ~ModelBody(){};
+        ModelBody();
+        virtual ~ModelBody();
+
+        void forkInto(ModelBody& fork);
         void add(System* system);
         void add(Flow* flow);
+        void add(std::span<Flow* const> flows);
+        void reserve(size_t numSystems, size_t numFlows);
 
         void setName(const string& modelName);
         string getName() const;
@@ -47,10 +175,52 @@ class ModelBody : public Body {
         void setCurrentTime(int time);
 
         void execute(int startTime, int endTime, int timeStep);
+        Generator<StepView> steps(int startTime, int endTime, int timeStep);
+        bool fastForward(int startTime, int endTime, int timeStep);
+        bool computeSensitivities(int startTime, int endTime, int timeStep, std::span<const Sensitivity> with,
+                                  std::span<double> sensitivities);
+        bool computeGradient(int startTime, int endTime, int timeStep, const Model::Loss& loss, Gradient& gradient,
+                             size_t checkpoints);
+        bool compile(const string& directory);
+
+        void setSteadyState(const SteadyState& criteria);
+        int getSteadyStateTime() const;
 
-        System* createSystem(const string& name, double value);;   
+        System* createSystem(const string& name, double value);
+        vector<System*> createSystems(std::span<const string> names, std::span<const double> values);
         bool deleteSystem(System* system);
         bool deleteFlow(Flow* flow);  
+        Flow* createFlow(const string& name, System* source, System* destination, const string& expression);
+
+        void setParameter(const string& name, double value);
+        double getParameter(const string& name) const;
+        void setRun(uint64_t run);
+        uint64_t getRun() const;
+
+        void schedule(const Event& event);
+        void clearEvents();
+        bool setFlowEnabled(Flow* flow, bool enabled);
+        bool bindInput(System* system, const TimeSeries* series);
+        bool bindInput(const string& parameter, const TimeSeries* series);
+        bool attachAggregator(System* system, Aggregator* aggregator);
+        bool detachAggregator(Aggregator* aggregator);
+        void setProfiler(Profiler* profiler);
+
+        void stageEdit(std::function<void()> edit);
+        size_t applyStagedEdits();
+        vector<string> getParameterNames() const;
+
+        size_t getNumSystems() const;
+        vector<size_t> getSystemIndices(std::span<const string> names);
+        bool readValues(std::span<double> values) const;
+        bool readValues(std::span<const size_t> indices, std::span<double> values) const;
+        bool writeValues(std::span<const double> values);
+        bool writeValues(std::span<const size_t> indices, std::span<const double> values);
+
+        Model::SystemIterator beginSystems();
+        Model::SystemIterator endSystems();
+        Model::FlowIterator beginFlows();
+        Model::FlowIterator endFlows();
 };
 
 /**
@@ -91,19 +261,97 @@ class ModelHandle : public Model, public Handle<ModelBody> {
                 _instance = nullptr;
             }
         }
+
+        Model* fork() {
+            ModelHandle* fork = new ModelHandle();
+            pImpl_->forkInto(*fork->pImpl_);
+            return fork;
+        }
         
         void add(System* system) { pImpl_->add(system); }
 
         void add(Flow* flow) { pImpl_->add(flow); }
 
+        void add(std::span<Flow* const> flows) { pImpl_->add(flows); }
+
+        void reserve(size_t numSystems, size_t numFlows) { pImpl_->reserve(numSystems, numFlows); }
+
         System* createSystem(const string& name, double value) {
             return pImpl_->createSystem(name, value);
         }
 
+        vector<System*> createSystems(std::span<const string> names, std::span<const double> values) {
+            return pImpl_->createSystems(names, values);
+        }
+
         bool deleteSystem(System* system) { return pImpl_->deleteSystem(system); }
 
         bool deleteFlow(Flow* flow) { return pImpl_->deleteFlow(flow); }
 
+        using Model::createFlow;
+
+        Flow* createFlow(const string& name, System* source, System* destination, const string& expression) {
+            return pImpl_->createFlow(name, source, destination, expression);
+        }
+
+        void setParameter(const string& name, double value) { pImpl_->setParameter(name, value); }
+
+        void schedule(const Event& event) { pImpl_->schedule(event); }
+
+        void clearEvents() { pImpl_->clearEvents(); }
+
+        bool setFlowEnabled(Flow* flow, bool enabled) { return pImpl_->setFlowEnabled(flow, enabled); }
+
+        bool bindInput(System* system, const TimeSeries* series) { return pImpl_->bindInput(system, series); }
+
+        bool bindInput(const string& parameter, const TimeSeries* series) { return pImpl_->bindInput(parameter, series); }
+
+        bool attachAggregator(System* system, Aggregator* aggregator) {
+            return pImpl_->attachAggregator(system, aggregator);
+        }
+
+        bool detachAggregator(Aggregator* aggregator) { return pImpl_->detachAggregator(aggregator); }
+
+        void setProfiler(Profiler* profiler) { pImpl_->setProfiler(profiler); }
+
+        void stageEdit(std::function<void(Model*)> edit) {
+            pImpl_->stageEdit([this, edit = std::move(edit)] { edit(this); });
+        }
+
+        size_t applyStagedEdits() { return pImpl_->applyStagedEdits(); }
+
+        double getParameter(const string& name) const { return pImpl_->getParameter(name); }
+
+        void setRun(uint64_t run) { pImpl_->setRun(run); }
+
+        uint64_t getRun() const { return pImpl_->getRun(); }
+
+        vector<string> getParameterNames() const { return pImpl_->getParameterNames(); }
+
+        size_t getNumSystems() const { return pImpl_->getNumSystems(); }
+
+        vector<size_t> getSystemIndices(std::span<const string> names) { return pImpl_->getSystemIndices(names); }
+
+        bool readValues(std::span<double> values) const { return pImpl_->readValues(values); }
+
+        bool readValues(std::span<const size_t> indices, std::span<double> values) const {
+            return pImpl_->readValues(indices, values);
+        }
+
+        bool writeValues(std::span<const double> values) { return pImpl_->writeValues(values); }
+
+        bool writeValues(std::span<const size_t> indices, std::span<const double> values) {
+            return pImpl_->writeValues(indices, values);
+        }
+
+        SystemIterator beginSystems() { return pImpl_->beginSystems(); }
+
+        SystemIterator endSystems() { return pImpl_->endSystems(); }
+
+        FlowIterator beginFlows() { return pImpl_->beginFlows(); }
+
+        FlowIterator endFlows() { return pImpl_->endFlows(); }
+
         void setName(const string& name) { pImpl_->setName(name); }
 
         string getName() const { return pImpl_->getName(); }
@@ -115,6 +363,30 @@ class ModelHandle : public Model, public Handle<ModelBody> {
         void execute(int startTime, int endTime, int timeStep) {
             pImpl_->execute(startTime, endTime, timeStep);
         }
+
+        Generator<StepView> steps(int startTime, int endTime, int timeStep) {
+            return pImpl_->steps(startTime, endTime, timeStep);
+        }
+
+        bool fastForward(int startTime, int endTime, int timeStep) {
+            return pImpl_->fastForward(startTime, endTime, timeStep);
+        }
+
+        bool computeSensitivities(int startTime, int endTime, int timeStep, std::span<const Sensitivity> with,
+                                  std::span<double> sensitivities) {
+            return pImpl_->computeSensitivities(startTime, endTime, timeStep, with, sensitivities);
+        }
+
+        bool computeGradient(int startTime, int endTime, int timeStep, const Loss& loss, Gradient& gradient,
+                             size_t checkpoints = 0) {
+            return pImpl_->computeGradient(startTime, endTime, timeStep, loss, gradient, checkpoints);
+        }
+
+        bool compile(const string& directory) { return pImpl_->compile(directory); }
+
+        void setSteadyState(const SteadyState& criteria) { pImpl_->setSteadyState(criteria); }
+
+        int getSteadyStateTime() const { return pImpl_->getSteadyStateTime(); }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include "ModelLoader.hpp"
+#include "FlowRegistry.hpp"
+#include "LinearFlow.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string_view;
+using std::vector;
+
+namespace {
+
+/// Splits one line of a model file into tokens.
+class LineReader {
+    private:
+        string_view rest;
+        bool unterminated = false;      /**< Set when a quoted token has no closing quote. */
+
+        void skipBlanks() {
+            size_t start = rest.find_first_not_of(" \t\r");
+            rest.remove_prefix(start == string_view::npos ? rest.size() : start);
+        }
+
+    public:
+        explicit LineReader(string_view line) : rest(line) {}
+
+        bool next(string_view& token) {
+            skipBlanks();
+            if (rest.empty()) {
+                return false;
+            }
+            if (rest[0] == '"') {
+                size_t end = rest.find('"', 1);
+                if (end == string_view::npos) {
+                    unterminated = true;
+                    return false;
+                }
+                token = rest.substr(1, end - 1);
+                rest.remove_prefix(end + 1);
+                return true;
+            }
+            size_t end = rest.find_first_of(" \t\r");
+            token = rest.substr(0, end);
+            rest.remove_prefix(token.size());
+            return true;
+        }
+
+        bool nextNumber(double& value) {
+            string_view token;
+            if (!next(token)) {
+                return false;
+            }
+            auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+            return result.ec == std::errc() && result.ptr == token.data() + token.size();
+        }
+
+        bool isUnterminated() const { return unterminated; }
+
+        string_view remainder() {
+            skipBlanks();
+            size_t end = rest.find_last_not_of(" \t\r");
+            return end == string_view::npos ? string_view() : rest.substr(0, end + 1);
+        }
+};
+
+/// Open-addressing table from system names (views into the model text) to systems; no allocation per entry.
+class NameTable {
+    private:
+        struct Entry {
+            string_view name;
+            System* system = nullptr;
+        };
+        vector<Entry> entries;
+        size_t mask;
+
+        static size_t hash(string_view name) {
+            size_t hash = 14695981039346656037ULL;
+            for (char c : name) {
+                hash = (hash ^ (unsigned char) c) * 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        Entry& slot(string_view name) {
+            size_t i = hash(name) & mask;
+            while (entries[i].system && entries[i].name != name) {
+                i = (i + 1) & mask;
+            }
+            return entries[i];
+        }
+
+    public:
+        /// Sizes the table for up to capacity names at a load factor of at most one half.
+        explicit NameTable(size_t capacity) {
+            size_t size = 16;
+            while (size < 2 * capacity) {
+                size *= 2;
+            }
+            entries.resize(size);
+            mask = size - 1;
+        }
+
+        bool insert(string_view name, System* system) {
+            Entry& entry = slot(name);
+            if (entry.system) {
+                return false;
+            }
+            entry.name = name;
+            entry.system = system;
+            return true;
+        }
+
+        bool contains(string_view name) { return slot(name).system != nullptr; }
+
+        System* find(string_view name) { return slot(name).system; }
+};
+
+}
+
+bool ModelLoader::parse(Model* model, string_view text, string* error) {
+    // One entry per line is an upper bound of the number of systems, so the table never grows.
+    NameTable systems(std::count(text.begin(), text.end(), '\n') + 1);
+    size_t lineNumber = 0;
+
+    auto fail = [&](const string& message) {
+        if (error) {
+            *error = "line " + std::to_string(lineNumber) + ": " + message;
+        }
+        return false;
+    };
+
+    auto findSystem = [&](string_view name, System*& system) {
+        if (name == "-") {
+            system = nullptr;
+            return true;
+        }
+        system = systems.find(name);
+        return system != nullptr;
+    };
+
+    while (!text.empty()) {
+        size_t end = text.find('\n');
+        string_view line = text.substr(0, end);
+        text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+        lineNumber++;
+
+        LineReader reader(line);
+        // A token that cannot be read because of an open quote is reported as such, whatever was expected.
+        auto failToken = [&](const string& message) {
+            return fail(reader.isUnterminated() ? "unterminated quote" : message);
+        };
+        string_view keyword;
+        if (!reader.next(keyword)) {
+            if (reader.isUnterminated()) {
+                return fail("unterminated quote");
+            }
+            continue;
+        }
+        if (keyword.starts_with('#')) {
+            continue;
+        }
+
+        string_view name;
+        if (!reader.next(name)) {
+            return failToken("missing name");
+        }
+
+        if (keyword == "system") {
+            double value;
+            if (!reader.nextNumber(value)) {
+                return failToken("invalid value of system '" + string(name) + "'");
+            }
+            if (systems.contains(name)) {
+                return fail("duplicated system '" + string(name) + "'");
+            }
+            systems.insert(name, model->createSystem(string(name), value));
+        } else if (keyword == "parameter") {
+            double value;
+            if (!reader.nextNumber(value)) {
+                return failToken("invalid value of parameter '" + string(name) + "'");
+            }
+            model->setParameter(string(name), value);
+        } else if (keyword == "flow") {
+            string_view sourceName, destinationName, type;
+            System* source;
+            System* destination;
+            if (!reader.next(sourceName) || !reader.next(destinationName) || !reader.next(type)) {
+                return failToken("incomplete flow '" + string(name) + "'");
+            }
+            if (!findSystem(sourceName, source) || !findSystem(destinationName, destination)) {
+                return fail("flow '" + string(name) + "' references an unknown system");
+            }
+
+            if (type == "linear") {
+                double rate;
+                if (!reader.nextNumber(rate)) {
+                    return failToken("invalid rate of flow '" + string(name) + "'");
+                }
+                model->createFlow<LinearFlow>(string(name), source, destination)->setRate(rate);
+            } else if (type == "expression") {
+                if (!model->createFlow(string(name), source, destination, string(reader.remainder()))) {
+                    return fail("invalid expression of flow '" + string(name) + "'");
+                }
+            } else if (!FlowRegistry::create(string(type), model, string(name), source, destination)) {
+                return fail("unknown flow type '" + string(type) + "'");
+            }
+        } else if (keyword == "model") {
+            model->setName(string(name));
+        } else {
+            return fail("unknown declaration '" + string(keyword) + "'");
+        }
+    }
+    return true;
+}
+
+bool ModelLoader::load(Model* model, const string& path, string* error) {
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        if (error) {
+            *error = "cannot open '" + path + "'";
+        }
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        close(file);
+        if (error) {
+            *error = "cannot read '" + path + "'";
+        }
+        return false;
+    }
+    if (status.st_size == 0) {
+        close(file);
+        return true;
+    }
+
+    void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        if (error) {
+            *error = "cannot map '" + path + "'";
+        }
+        return false;
+    }
+    madvise(data, status.st_size, MADV_SEQUENTIAL);
+
+    bool loaded = parse(model, string_view((const char*) data, status.st_size), error);
+    munmap(data, status.st_size);
+    return loaded;
+}
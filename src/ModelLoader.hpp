@@ -0,0 +1,68 @@
+#ifndef MODEL_LOADER_HPP
+#define MODEL_LOADER_HPP
+
+#include "Model.hpp"
+
+#include <string>
+#include <string_view>
+
+using std::string;
+
+/**
+ * @class ModelLoader
+ * @brief Single-pass loader of the text model format.
+ * @details A model file is a sequence of lines, each one a declaration. Tokens are separated by blanks; 
+ * names containing blanks are written between double quotes, and a quote left open is an error. Empty 
+ * lines and lines starting with `#` are ignored.
+ * 
+ * @code
+ * # Complex flow scenario
+ * model "Complex Flow"
+ * parameter capacity 70
+ * system Q1 100
+ * system Q2 0
+ * flow f Q1 Q2 linear 0.01
+ * flow g Q1 Q2 expression 0.01 * dest * (1 - dest / capacity)
+ * flow h Q2 Q1 exponential
+ * @endcode
+ * 
+ * - `model <name>` sets the name of the model.
+ * - `parameter <name> <value>` sets a model parameter (see Model::setParameter).
+ * - `system <name> <value>` creates a system with its initial value. System names must be unique.
+ * - `flow <name> <source> <destination> <type> [arguments]` creates a flow between two systems declared 
+ *   on earlier lines; `-` stands for no system. The type is one of:
+ *   - `linear <rate>`: a LinearFlow with the given rate;
+ *   - `expression <text>`: an expression flow whose equation is the rest of the line (see Expression);
+ *   - any name registered in the FlowRegistry, with no arguments.
+ * 
+ * Systems, parameters and flows must be declared before they are referenced. The file is mapped in 
+ * memory and parsed in one pass without copying it; names are only copied into the objects that keep them.
+ * 
+ * @see FlowRegistry
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class ModelLoader {
+    public:
+        /**
+         * @brief Loads a model file into a model.
+         * @param model The model receiving the declarations.
+         * @param path The path of the model file.
+         * @param error Receives a description of the problem, with its line number, when loading fails; may be null.
+         * @return True if the whole file was loaded, false otherwise.
+         * 
+         * @note On failure, the declarations before the faulty line remain in the model.
+         */
+        static bool load(Model* model, const string& path, string* error = nullptr);
+
+        /**
+         * @brief Loads model declarations from text.
+         * @param model The model receiving the declarations.
+         * @param text The declarations, in the model file format.
+         * @param error Receives a description of the problem, with its line number, when loading fails; may be null.
+         * @return True if the whole text was loaded, false otherwise.
+         */
+        static bool parse(Model* model, std::string_view text, string* error = nullptr);
+};
+
+#endif
@@ -0,0 +1,373 @@
+#include "ModelSnapshot.hpp"
+#include "Expression.hpp"
+#include "ExpressionFlow.hpp"
+#include "FlowRegistry.hpp"
+#include "LinearFlow.hpp"
+#include "DelayFlow.hpp"
+#include "LookupFlow.hpp"
+#include "StochasticFlow.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string_view;
+using std::vector;
+
+namespace {
+
+const char MAGIC[8] = {'M', 'V', 'S', 'N', 'A', 'P', '\0', '\0'};
+const uint32_t NO_SYSTEM = UINT32_MAX;
+
+enum FlowKind : uint32_t { LINEAR, EXPRESSION, REGISTERED };
+
+/// Slice of the string pool.
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t numSystems;
+    uint32_t numParameters;
+    uint32_t numFlows;
+    int32_t currentTime;
+    uint32_t reserved;
+    StringRef name;
+    uint64_t size;          // Size of the whole file.
+    uint64_t checksum;      // Checksum of the whole file, this field read as zero.
+    uint64_t values;        // Offsets of the sections from the start of the file.
+    uint64_t parameters;
+    uint64_t flows;
+    uint64_t names;
+    uint64_t strings;
+};
+
+struct FlowRecord {
+    uint32_t kind;
+    uint32_t source;
+    uint32_t destination;
+    uint32_t reserved;
+    StringRef name;
+    StringRef text;         // Expression of EXPRESSION flows, type name of REGISTERED flows.
+    double rate;            // Rate of LINEAR flows and of REGISTERED flows deriving from LinearFlow.
+};
+
+static_assert(sizeof(Header) % 8 == 0 && sizeof(FlowRecord) % 8 == 0, "sections must stay 8-byte aligned");
+
+uint64_t mix(uint64_t hash, const char* data, size_t size) {
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * 0x100000001B3ULL;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ (unsigned char) data[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/// Checksum of the whole file, with the checksum field of the header read as zero.
+uint64_t checksum(const Header& header, const char* body, size_t bodySize) {
+    // Word-at-a-time multiplicative hash: cheap enough to verify gigabyte snapshots at memory speed.
+    Header zeroed = header;
+    zeroed.checksum = 0;
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ (sizeof(Header) + bodySize);
+    hash = mix(hash, (const char*) &zeroed, sizeof(Header));
+    return mix(hash, body, bodySize);
+}
+
+size_t align(size_t offset) {
+    return (offset + 7) & ~size_t(7);
+}
+
+/// Accumulates the string pool of a snapshot being written.
+class StringPool {
+    private:
+        string pool;
+
+    public:
+        StringRef add(const string& text) {
+            StringRef ref{uint32_t(pool.size()), uint32_t(text.size())};
+            pool += text;
+            return ref;
+        }
+
+        const string& data() const { return pool; }
+};
+
+bool fail(string* error, const string& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+}
+
+bool ModelSnapshot::save(Model* model, const string& path, string* error) {
+    vector<System*> systems(model->beginSystems(), model->endSystems());
+    vector<Flow*> flows(model->beginFlows(), model->endFlows());
+    vector<string> parameterNames = model->getParameterNames();
+
+    std::unordered_map<const System*, uint32_t> indices;
+    indices.reserve(systems.size());
+    for (size_t i = 0; i < systems.size(); i++) {
+        indices.emplace(systems[i], uint32_t(i));
+    }
+    auto indexOf = [&indices](const System* system) {
+        auto it = system ? indices.find(system) : indices.end();
+        return it == indices.end() ? NO_SYSTEM : it->second;
+    };
+
+    StringPool strings;
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.numSystems = uint32_t(systems.size());
+    header.numParameters = uint32_t(parameterNames.size());
+    header.numFlows = uint32_t(flows.size());
+    header.currentTime = model->getCurrentTime();
+    header.name = strings.add(model->getName());
+
+    // Forks keep their values apart from the shared systems, so they are read through the model.
+    vector<double> values(systems.size());
+    if (!model->readValues(values)) {
+        for (size_t i = 0; i < systems.size(); i++) {
+            values[i] = systems[i]->getValue();
+        }
+    }
+    vector<StringRef> names;
+    names.reserve(systems.size() + parameterNames.size());
+    for (size_t i = 0; i < systems.size(); i++) {
+        names.push_back(strings.add(systems[i]->getName()));
+    }
+
+    vector<double> parameters(parameterNames.size());
+    for (size_t i = 0; i < parameterNames.size(); i++) {
+        parameters[i] = model->getParameter(parameterNames[i]);
+        names.push_back(strings.add(parameterNames[i]));
+    }
+
+    vector<FlowRecord> records(flows.size());
+    for (size_t i = 0; i < flows.size(); i++) {
+        Flow* flow = flows[i];
+        FlowRecord& record = records[i];
+        record.source = indexOf(flow->getSource());
+        record.destination = indexOf(flow->getDestination());
+        record.name = strings.add(flow->getName());
+
+        string type = FlowRegistry::getType(flow);
+        if (ExpressionFlow* expressionFlow = dynamic_cast<ExpressionFlow*>(flow)) {
+            record.kind = EXPRESSION;
+            record.text = strings.add(expressionFlow->getExpression().getText());
+        } else if (!type.empty()) {
+            // Registered flows are rebuilt from their type name; the rate is the only state restored with them.
+            LinearFlow* linearFlow = dynamic_cast<LinearFlow*>(flow);
+            if ((flow->isLinear() && !linearFlow) || dynamic_cast<DelayFlow*>(flow) || dynamic_cast<LookupFlow*>(flow)
+                || dynamic_cast<StochasticFlow*>(flow)) {
+                return fail(error, "the state of flow '" + flow->getName() + "' cannot be saved");
+            }
+            record.kind = REGISTERED;
+            record.text = strings.add(type);
+            record.rate = linearFlow ? linearFlow->getRate() : 0.0;
+        } else if (flow->isLinear()) {
+            record.kind = LINEAR;
+            record.rate = flow->getRate();
+        } else {
+            return fail(error, "flow '" + flow->getName() + "' is of an unregistered type");
+        }
+    }
+
+    header.values = sizeof(Header);
+    header.parameters = header.values + values.size() * sizeof(double);
+    header.flows = header.parameters + parameters.size() * sizeof(double);
+    header.names = header.flows + records.size() * sizeof(FlowRecord);
+    header.strings = align(header.names + names.size() * sizeof(StringRef));
+    header.size = header.strings + strings.data().size();
+
+    vector<char> file(header.size, 0);
+    std::memcpy(file.data() + header.values, values.data(), values.size() * sizeof(double));
+    std::memcpy(file.data() + header.parameters, parameters.data(), parameters.size() * sizeof(double));
+    std::memcpy(file.data() + header.flows, records.data(), records.size() * sizeof(FlowRecord));
+    std::memcpy(file.data() + header.names, names.data(), names.size() * sizeof(StringRef));
+    std::memcpy(file.data() + header.strings, strings.data().data(), strings.data().size());
+    header.checksum = checksum(header, file.data() + sizeof(Header), file.size() - sizeof(Header));
+    std::memcpy(file.data(), &header, sizeof(Header));
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    if (!output.write(file.data(), file.size())) {
+        return fail(error, "cannot write '" + path + "'");
+    }
+    return true;
+}
+
+bool ModelSnapshot::load(Model* model, const string& path, string* error) {
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return fail(error, "cannot open '" + path + "'");
+    }
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || size_t(status.st_size) < sizeof(Header)) {
+        close(file);
+        return fail(error, "'" + path + "' is not a model snapshot");
+    }
+
+    size_t size = status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED) {
+        return fail(error, "cannot map '" + path + "'");
+    }
+    const char* data = (const char*) mapping;
+
+    auto release = [&](const string& message) {
+        munmap(mapping, size);
+        return fail(error, message);
+    };
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return release("'" + path + "' is not a model snapshot");
+    }
+    if (header.version != VERSION) {
+        return release("unsupported snapshot version " + std::to_string(header.version));
+    }
+
+    uint64_t numNames = uint64_t(header.numSystems) + header.numParameters;
+    bool consistent = header.size == size
+        && header.values == sizeof(Header)
+        && header.parameters == header.values + header.numSystems * sizeof(double)
+        && header.flows == header.parameters + header.numParameters * sizeof(double)
+        && header.names == header.flows + header.numFlows * sizeof(FlowRecord)
+        && header.strings == align(header.names + numNames * sizeof(StringRef))
+        && header.strings <= size;
+    if (!consistent) {
+        return release("'" + path + "' is truncated or corrupted");
+    }
+    if (checksum(header, data + sizeof(Header), size - sizeof(Header)) != header.checksum) {
+        return release("checksum mismatch in '" + path + "'");
+    }
+
+    const double* values = (const double*) (data + header.values);
+    const double* parameters = (const double*) (data + header.parameters);
+    const FlowRecord* flows = (const FlowRecord*) (data + header.flows);
+    const StringRef* names = (const StringRef*) (data + header.names);
+    string_view pool(data + header.strings, size - header.strings);
+    auto fits = [&pool](StringRef ref) {
+        return uint64_t(ref.offset) + ref.length <= pool.size();
+    };
+    auto text = [&pool](StringRef ref) {
+        return string(pool.substr(ref.offset, ref.length));
+    };
+
+    // Every reference is checked before anything is created, so a rejected snapshot leaves the model as it was.
+    bool valid = fits(header.name);
+    for (uint64_t i = 0; i < numNames && valid; i++) {
+        valid = fits(names[i]);
+    }
+    for (uint32_t i = 0; i < header.numFlows && valid; i++) {
+        valid = fits(flows[i].name) && (flows[i].kind == LINEAR || fits(flows[i].text));
+    }
+    if (!valid) {
+        return release("string out of range in '" + path + "'");
+    }
+
+    // Expressions may refer to the parameters and systems of the snapshot and to those already in the model.
+    std::unordered_set<string> symbols;
+    for (uint32_t i = 0; i < header.numFlows; i++) {
+        const FlowRecord& record = flows[i];
+        if ((record.source != NO_SYSTEM && record.source >= header.numSystems)
+            || (record.destination != NO_SYSTEM && record.destination >= header.numSystems)) {
+            return release("flow " + std::to_string(i) + " refers to a system out of range");
+        }
+        string name = text(record.name);
+        switch (record.kind) {
+            case LINEAR:
+                break;
+            case EXPRESSION: {
+                if (symbols.empty()) {
+                    symbols = {"source", "destination", "dest"};
+                    for (uint64_t k = 0; k < numNames; k++) {
+                        symbols.insert(text(names[k]));
+                    }
+                    for (const string& parameter : model->getParameterNames()) {
+                        symbols.insert(parameter);
+                    }
+                    for (auto it = model->beginSystems(); it != model->endSystems(); ++it) {
+                        symbols.insert((*it)->getName());
+                    }
+                }
+                Expression expression;
+                bool bound = expression.parse(text(record.text));
+                for (const string& symbol : expression.getSymbols()) {
+                    bound = bound && symbols.count(symbol) > 0;
+                }
+                if (!bound) {
+                    return release("invalid expression in flow '" + name + "'");
+                }
+                break;
+            }
+            case REGISTERED:
+                if (!FlowRegistry::contains(text(record.text))) {
+                    return release("flow '" + name + "' is of unregistered type '" + text(record.text) + "'");
+                }
+                break;
+            default:
+                return release("flow '" + name + "' is of unknown kind " + std::to_string(record.kind));
+        }
+    }
+
+    model->setName(text(header.name));
+    model->setCurrentTime(header.currentTime);
+
+    // Parameters first, since expressions are bound to them when their flows are created.
+    for (uint32_t i = 0; i < header.numParameters; i++) {
+        model->setParameter(text(names[header.numSystems + i]), parameters[i]);
+    }
+
+    // The systems are built in parallel chunks, each copying its value from the mapping.
+    vector<string> systemNames(header.numSystems);
+    for (uint32_t i = 0; i < header.numSystems; i++) {
+        systemNames[i] = text(names[i]);
+    }
+    size_t numSystems = std::distance(model->beginSystems(), model->endSystems());
+    size_t numFlows = std::distance(model->beginFlows(), model->endFlows());
+    model->reserve(numSystems + header.numSystems, numFlows + header.numFlows);
+    vector<System*> systems = model->createSystems(systemNames, std::span<const double>(values, header.numSystems));
+
+    for (uint32_t i = 0; i < header.numFlows; i++) {
+        const FlowRecord& record = flows[i];
+        System* source = record.source == NO_SYSTEM ? nullptr : systems[record.source];
+        System* destination = record.destination == NO_SYSTEM ? nullptr : systems[record.destination];
+        string name = text(record.name);
+        if (record.kind == LINEAR) {
+            model->createFlow<LinearFlow>(name, source, destination)->setRate(record.rate);
+        } else if (record.kind == EXPRESSION) {
+            model->createFlow(name, source, destination, text(record.text));
+        } else {
+            Flow* flow = FlowRegistry::create(text(record.text), model, name, source, destination);
+            if (LinearFlow* linearFlow = dynamic_cast<LinearFlow*>(flow)) {
+                linearFlow->setRate(record.rate);
+            }
+        }
+    }
+
+    munmap(mapping, size);
+    return true;
+}
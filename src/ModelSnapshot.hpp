@@ -0,0 +1,74 @@
+#ifndef MODEL_SNAPSHOT_HPP
+#define MODEL_SNAPSHOT_HPP
+
+#include "Model.hpp"
+
+#include <cstdint>
+#include <string>
+
+using std::string;
+
+/**
+ * @class ModelSnapshot
+ * @brief Binary snapshot of a built model, mapped in memory to restart without parsing.
+ * @details A snapshot holds the topology, the values, the flow kinds and the parameters of a model in
+ * fixed-size, pointer-free sections, so loading reads the mapped file with no tokenizing, number parsing
+ * or name lookup: flows refer to their systems by index, and names and expressions are length-prefixed
+ * slices of a string pool. Loading checks the mapped file, then copies its values, names and flows into
+ * new systems and flows of the model.
+ *
+ * @code
+ * offset 0      Header        magic, version, checksum, counts and section offsets
+ *               values        double[systems], in the order of the systems of the model
+ *               parameters    double[parameters], in order of creation
+ *               flows         FlowRecord[flows]: kind, source, destination, name, type or expression, rate
+ *               names         StringRef[systems + parameters]
+ *               strings       pool of the names, types and expressions referenced above
+ * @endcode
+ *
+ * Flows are stored as one of three kinds: expression flows keep their expression, flows of a class
+ * registered in the FlowRegistry keep their type name, and the rate of those deriving from LinearFlow,
+ * and other linear flows (such as LinearFlow) keep their rate and are restored as LinearFlow. Other flows
+ * cannot be saved, and neither can registered flows with state that a type name and a rate do not hold:
+ * linear flows not deriving from LinearFlow, and delay, lookup and stochastic flows.
+ *
+ * The checksum covers the whole file, header included, and is verified before anything is created.
+ * Snapshots use the byte order of the machine that wrote them and are meant to be reloaded on the same
+ * platform.
+ *
+ * @see ModelLoader
+ * @see FlowRegistry
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class ModelSnapshot {
+    public:
+        static constexpr uint32_t VERSION = 2;      /**< Format version written and accepted by this library. */
+
+        /**
+         * @brief Writes a snapshot of a model.
+         * @param model The model to save.
+         * @param path The path of the snapshot file.
+         * @param error Receives a description of the problem when saving fails; may be null.
+         * @return True if the snapshot was written, false if a flow or its state cannot be saved or the file
+         * cannot be written.
+         */
+        static bool save(Model* model, const string& path, string* error = nullptr);
+
+        /**
+         * @brief Loads a snapshot into a model.
+         * @details The name, current time, parameters, systems and flows of the snapshot are added to the model.
+         * @param model The model receiving the snapshot, normally empty.
+         * @param path The path of the snapshot file.
+         * @param error Receives a description of the problem when loading fails; may be null.
+         * @return True if the snapshot was loaded, false if the file is missing, of another version,
+         * corrupted, or refers to an unregistered flow type.
+         *
+         * @note Nothing is added to the model unless the header, the checksum and every reference of the
+         * snapshot are valid: systems, strings, flow kinds, registered types and the expressions and the
+         * names they use are all checked before the first object is created.
+         */
+        static bool load(Model* model, const string& path, string* error = nullptr);
+};
+
+#endif
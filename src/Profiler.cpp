@@ -0,0 +1,179 @@
+#include "Profiler.hpp"
+#include "Json.hpp"
+#include "FlowRegistry.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <typeinfo>
+
+namespace {
+
+void keepSlowest(vector<Profiler::Outlier>& slowest, Profiler::Outlier outlier, size_t limit) {
+    if (slowest.size() == limit && (limit == 0 || slowest.back().nanoseconds >= outlier.nanoseconds)) {
+        return;
+    }
+    auto position = std::upper_bound(slowest.begin(), slowest.end(), outlier, [](const Profiler::Outlier& a, const Profiler::Outlier& b) {
+        return a.nanoseconds > b.nanoseconds;
+    });
+    slowest.insert(position, outlier);
+    if (slowest.size() > limit) {
+        slowest.pop_back();
+    }
+}
+
+void sortByTime(vector<Profiler::Entry>& entries) {
+    std::stable_sort(entries.begin(), entries.end(), [](const Profiler::Entry& a, const Profiler::Entry& b) {
+        return a.nanoseconds > b.nanoseconds;
+    });
+}
+
+void writeEntries(std::ostream& out, const vector<Profiler::Entry>& entries) {
+    out << '[';
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Profiler::Entry& entry = entries[i];
+        out << (i ? ",\n    " : "\n    ") << "{\"name\": " << Json::quote(entry.name) << ", \"type\": " << Json::quote(entry.type)
+            << ", \"calls\": " << entry.calls << ", \"nanoseconds\": " << entry.nanoseconds
+            << ", \"meanNanoseconds\": " << entry.getMean() << ", \"maxNanoseconds\": " << entry.maxNanoseconds
+            << ", \"slowest\": [";
+        for (size_t k = 0; k < entry.slowest.size(); k++) {
+            out << (k ? ", " : "") << "{\"time\": " << entry.slowest[k].time << ", \"nanoseconds\": "
+                << entry.slowest[k].nanoseconds << '}';
+        }
+        out << "]}";
+    }
+    out << (entries.empty() ? "]" : "\n  ]");
+}
+
+}
+
+Profiler::Profiler(size_t period, size_t outliers) : period(std::max<size_t>(period, 1)), numOutliers(outliers) {}
+
+string Profiler::typeOf(const Flow* flow) {
+    string type = FlowRegistry::getType(flow);
+    if (!type.empty()) {
+        return type;
+    }
+    const char* mangled = typeid(*flow).name();
+    int status = 0;
+    std::unique_ptr<char, void (*)(void*)> demangled(abi::__cxa_demangle(mangled, nullptr, nullptr, &status), std::free);
+    return status == 0 && demangled ? string(demangled.get()) : string(mangled);
+}
+
+void Profiler::recordStep(double nanoseconds) {
+    numSampled++;
+    stepNanoseconds += nanoseconds;
+}
+
+void Profiler::record(const Flow* flow, int time, double nanoseconds) {
+    auto [it, added] = indices.try_emplace(flow, flows.size());
+    if (added) {
+        Entry entry;
+        entry.name = flow->getName();
+        entry.type = typeOf(flow);
+        flows.push_back(std::move(entry));
+    }
+    Entry& entry = flows[it->second];
+    entry.calls++;
+    entry.nanoseconds += nanoseconds;
+    entry.maxNanoseconds = std::max(entry.maxNanoseconds, nanoseconds);
+    keepSlowest(entry.slowest, {time, nanoseconds}, numOutliers);
+}
+
+vector<Profiler::Entry> Profiler::getFlows() const {
+    vector<Entry> entries = flows;
+    sortByTime(entries);
+    return entries;
+}
+
+vector<Profiler::Entry> Profiler::getTypes() const {
+    vector<Entry> entries;
+    std::unordered_map<string, size_t> types;
+    for (const Entry& flow : flows) {
+        auto [it, added] = types.try_emplace(flow.type, entries.size());
+        if (added) {
+            Entry entry;
+            entry.name = flow.type;
+            entry.type = flow.type;
+            entries.push_back(std::move(entry));
+        }
+        Entry& entry = entries[it->second];
+        entry.calls += flow.calls;
+        entry.nanoseconds += flow.nanoseconds;
+        entry.maxNanoseconds = std::max(entry.maxNanoseconds, flow.maxNanoseconds);
+        for (const Outlier& outlier : flow.slowest) {
+            keepSlowest(entry.slowest, outlier, numOutliers);
+        }
+    }
+    sortByTime(entries);
+    return entries;
+}
+
+string Profiler::report(size_t limit) const {
+    vector<Entry> sortedFlows = getFlows();
+    double total = 0.0;
+    for (const Entry& entry : sortedFlows) {
+        total += entry.nanoseconds;
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "Profile of " << numSteps << " steps, " << numSampled << " timed (one in " << period << ")";
+    if (numSampled > 0) {
+        out << ", " << stepNanoseconds / double(numSampled) << " ns per step";
+    }
+    out << '\n';
+
+    auto table = [&out, total](const string& title, const vector<Entry>& entries, size_t count, bool withType) {
+        out << '\n' << std::left << std::setw(24) << title;
+        if (withType) {
+            out << std::setw(20) << "type";
+        }
+        out << std::right << std::setw(10) << "calls" << std::setw(14) << "total (us)" << std::setw(12) << "mean (ns)"
+            << std::setw(12) << "max (ns)" << std::setw(8) << "share" << '\n';
+        for (size_t i = 0; i < std::min(count, entries.size()); i++) {
+            const Entry& entry = entries[i];
+            out << std::left << std::setw(24) << entry.name;
+            if (withType) {
+                out << std::setw(20) << entry.type;
+            }
+            out << std::right << std::setw(10) << entry.calls << std::setw(14) << entry.nanoseconds / 1000.0
+                << std::setw(12) << entry.getMean() << std::setw(12) << entry.maxNanoseconds << std::setw(7)
+                << (total > 0.0 ? 100.0 * entry.nanoseconds / total : 0.0) << "%\n";
+        }
+        if (entries.size() > count) {
+            out << "(" << entries.size() - count << " more)\n";
+        }
+    };
+    table("flow", sortedFlows, limit, true);
+    vector<Entry> types = getTypes();
+    table("type", types, types.size(), false);
+    return out.str();
+}
+
+string Profiler::toJson() const {
+    std::ostringstream out;
+    out << std::setprecision(17);
+    out << "{\n  \"steps\": " << numSteps << ",\n  \"sampledSteps\": " << numSampled << ",\n  \"period\": " << period
+        << ",\n  \"stepNanoseconds\": " << stepNanoseconds << ",\n  \"flows\": ";
+    writeEntries(out, getFlows());
+    out << ",\n  \"types\": ";
+    writeEntries(out, getTypes());
+    out << "\n}\n";
+    return out.str();
+}
+
+bool Profiler::writeJson(const string& path, string* error) const {
+    return Json::write(path, toJson(), error);
+}
+
+void Profiler::reset() {
+    numSteps = 0;
+    numSampled = 0;
+    stepNanoseconds = 0.0;
+    flows.clear();
+    indices.clear();
+}
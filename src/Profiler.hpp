@@ -0,0 +1,157 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include "Flow.hpp"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @class Profiler
+ * @brief Sampled timing of the flows of a model, by flow and by flow type.
+ * @details A profiler set on a model (see Model::setProfiler) times one step out of every `period`: in
+ * that step, besides the step itself, every flow is evaluated alone between two readings of the clock.
+ * The other steps only increment a counter, so the overhead is bounded by about 1 / period of the cost of
+ * a step, and a model without profiler pays one null test per step.
+ *
+ * For every flow the profiler keeps the number of timed evaluations, their total and largest times and
+ * the slowest few with the time of their step, to tell steady cost from outliers. Flows are also summed by
+ * type: the name registered in FlowRegistry, or the C++ class name. The report lists them by decreasing
+ * total time, and toJson gives the same data for tools.
+ *
+ * @code
+ * Profiler profiler(16);
+ * model->setProfiler(&profiler);
+ * model->execute(0, 10000, 1);
+ * std::cout << profiler.report(10);
+ * profiler.writeJson("profile.json");
+ * @endcode
+ *
+ * @note A profiler is not synchronized: set it on one model at a time. Forks do not inherit it.
+ * @see Model::setProfiler
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class Profiler {
+    public:
+        /**
+         * @struct Outlier
+         * @brief A slow evaluation.
+         */
+        struct Outlier {
+            int time;               /**< Time at the start of the step. */
+            double nanoseconds;
+        };
+
+        /**
+         * @struct Entry
+         * @brief Timings of a flow, or of all the flows of a type.
+         */
+        struct Entry {
+            string name;                /**< Name of the flow, or the type for type entries. */
+            string type;                /**< Type of the flow. */
+            size_t calls = 0;           /**< Timed evaluations. */
+            double nanoseconds = 0.0;   /**< Total time of the timed evaluations. */
+            double maxNanoseconds = 0.0;
+            vector<Outlier> slowest;    /**< Slowest evaluations, slowest first. */
+
+            double getMean() const { return calls > 0 ? nanoseconds / double(calls) : 0.0; }
+        };
+
+    private:
+        size_t period;                  /**< Time one step in period. */
+        size_t numOutliers;             /**< Slowest evaluations kept per flow. */
+        size_t numSteps = 0;            /**< Steps seen. */
+        size_t numSampled = 0;          /**< Steps timed. */
+        double stepNanoseconds = 0.0;   /**< Total time of the timed steps. */
+        vector<Entry> flows;
+        std::unordered_map<const Flow*, size_t> indices;    /**< Entry of each flow. */
+
+        static string typeOf(const Flow* flow);
+
+    public:
+        /**
+         * @brief Constructs a profiler.
+         * @param period Time one step in period; 1 times every step.
+         * @param outliers The number of slowest evaluations kept per flow.
+         */
+        explicit Profiler(size_t period = 64, size_t outliers = 4);
+
+        /**
+         * @brief Counts a step and tells whether to time it.
+         * @return True for one step in period, starting with the first.
+         */
+        bool sampleStep() {
+            return numSteps++ % period == 0;
+        }
+
+        /**
+         * @brief Records the time of a timed step.
+         * @param nanoseconds The time of the step.
+         * @return None.
+         */
+        void recordStep(double nanoseconds);
+
+        /**
+         * @brief Records the time of a flow in a timed step.
+         * @param flow The flow.
+         * @param time The time at the start of the step.
+         * @param nanoseconds The time of its evaluation.
+         * @return None.
+         */
+        void record(const Flow* flow, int time, double nanoseconds);
+
+        /**
+         * @brief Gets the timings of the flows.
+         * @return One entry per flow, by decreasing total time.
+         */
+        vector<Entry> getFlows() const;
+
+        /**
+         * @brief Gets the timings summed by flow type.
+         * @return One entry per type, by decreasing total time; the outliers are the slowest of the type.
+         */
+        vector<Entry> getTypes() const;
+
+        size_t getSteps() const { return numSteps; }
+        size_t getSampledSteps() const { return numSampled; }
+        size_t getPeriod() const { return period; }
+        double getStepNanoseconds() const { return stepNanoseconds; }
+
+        /**
+         * @brief Formats the timings as a table.
+         * @param limit The largest number of flows listed; types are all listed.
+         * @return The report.
+         */
+        string report(size_t limit = 20) const;
+
+        /**
+         * @brief Formats the timings as JSON.
+         * @details An object with `steps`, `sampledSteps`, `period`, `stepNanoseconds`, and `flows` and `types`
+         * arrays of entries with `name`, `type`, `calls`, `nanoseconds`, `meanNanoseconds`,
+         * `maxNanoseconds` and `slowest` (pairs of `time` and `nanoseconds`), sorted as in the report.
+         * @return The JSON text.
+         */
+        string toJson() const;
+
+        /**
+         * @brief Writes the timings as JSON to a file.
+         * @param path The path of the file.
+         * @param error Receives a description of the problem when writing fails; may be null.
+         * @return True if the file was written.
+         */
+        bool writeJson(const string& path, string* error = nullptr) const;
+
+        /**
+         * @brief Removes all timings.
+         * @return None.
+         */
+        void reset();
+};
+
+#endif
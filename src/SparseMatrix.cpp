@@ -0,0 +1,88 @@
+#include "SparseMatrix.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+/// Below this number of non-zeros a product is faster on a single thread than split across the pool.
+static const size_t PARALLEL_NON_ZEROS = 1 << 16;
+
+void SparseMatrix::assemble(size_t order, vector<Triplet> triplets) {
+    std::sort(triplets.begin(), triplets.end(), [](const Triplet& a, const Triplet& b) {
+        return a.row != b.row ? a.row < b.row : a.column < b.column;
+    });
+
+    this->order = order;
+    rowOffsets.assign(order + 1, 0);
+    columns.clear();
+    values.clear();
+    columns.reserve(triplets.size());
+    values.reserve(triplets.size());
+
+    const Triplet* previous = nullptr;
+    for (const Triplet& triplet : triplets) {
+        if (previous && previous->row == triplet.row && previous->column == triplet.column) {
+            values.back() += triplet.value;
+        } else {
+            columns.push_back(triplet.column);
+            values.push_back(triplet.value);
+            rowOffsets[triplet.row + 1]++;
+        }
+        previous = &triplet;
+    }
+    for (size_t row = 0; row < order; row++) {
+        rowOffsets[row + 1] += rowOffsets[row];
+    }
+
+    // Blocks of rows with about the same number of non-zeros, a few per thread to balance the load.
+    blocks.assign(1, 0);
+    size_t numBlocks = values.size() < PARALLEL_NON_ZEROS ? 1 : 4 * ThreadPool::getInstance().getNumThreads();
+    for (size_t block = 1; block < numBlocks; block++) {
+        size_t target = values.size() * block / numBlocks;
+        size_t row = std::upper_bound(rowOffsets.begin(), rowOffsets.end(), target) - rowOffsets.begin() - 1;
+        if (row > blocks.back()) {
+            blocks.push_back(row);
+        }
+    }
+    blocks.push_back(order);
+}
+
+size_t SparseMatrix::find(size_t row, size_t column) const {
+    auto first = columns.begin() + rowOffsets[row];
+    auto last = columns.begin() + rowOffsets[row + 1];
+    auto it = std::lower_bound(first, last, column);
+    if (it != last && *it == column) {
+        return it - columns.begin();
+    }
+    return values.size();
+}
+
+void SparseMatrix::multiplyRows(const double* x, double* y, size_t firstRow, size_t lastRow) const {
+    const size_t* offsets = rowOffsets.data();
+    const size_t* cols = columns.data();
+    const double* vals = values.data();
+    for (size_t row = firstRow; row < lastRow; row++) {
+        double sum = 0.0;
+        for (size_t k = offsets[row]; k < offsets[row + 1]; k++) {
+            sum += vals[k] * x[cols[k]];
+        }
+        y[row] = sum;
+    }
+}
+
+void SparseMatrix::multiply(const double* x, double* y) const {
+    if (blocks.size() <= 2) {
+        multiplyRows(x, y, 0, order);
+        return;
+    }
+    ThreadPool::getInstance().parallelFor(blocks.size() - 1, [&](size_t block) {
+        multiplyRows(x, y, blocks[block], blocks[block + 1]);
+    });
+}
+
+void SparseMatrix::addTo(DenseMatrix& dense) const {
+    for (size_t row = 0; row < order; row++) {
+        for (size_t k = rowOffsets[row]; k < rowOffsets[row + 1]; k++) {
+            dense(row, columns[k]) += values[k];
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef SPARSE_MATRIX_HPP
+#define SPARSE_MATRIX_HPP
+
+#include "DenseMatrix.hpp"
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @class SparseMatrix
+ * @brief Square matrix in compressed sparse row (CSR) format.
+ * @details The model lowers its linear flows into a SparseMatrix A so that the contribution of all of 
+ * them to one step is the sparse matrix-vector product `A x`. Large products are split into row blocks 
+ * of similar number of non-zeros and run on the ThreadPool.
+ * 
+ * The matrix is assembled from (row, column, value) triplets; duplicated positions are summed. 
+ * Values can later be updated in place through the positions returned by find, without changing the 
+ * structure.
+ * 
+ * @see ExecutionPlan
+ * @see ThreadPool
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class SparseMatrix {
+    public:
+        /**
+         * @struct Triplet
+         * @brief One entry used to assemble the matrix.
+         */
+        struct Triplet {
+            size_t row;         /**< Row of the entry. */
+            size_t column;      /**< Column of the entry. */
+            double value;       /**< Value added at that position. */
+        };
+
+    private:
+        size_t order = 0;               /**< Number of rows and columns. */
+        vector<size_t> rowOffsets;      /**< Start of each row in columns/values, plus the total count. */
+        vector<size_t> columns;         /**< Column of each non-zero. */
+        vector<double> values;          /**< Value of each non-zero. */
+        vector<size_t> blocks;          /**< Row boundaries of the blocks used by the parallel product. */
+
+        void multiplyRows(const double* x, double* y, size_t firstRow, size_t lastRow) const;
+
+    public:
+        /**
+         * @brief Assembles the matrix from triplets, summing duplicated positions.
+         * @param order The number of rows and columns.
+         * @param triplets The entries of the matrix, in any order.
+         * @return None.
+         */
+        void assemble(size_t order, vector<Triplet> triplets);
+
+        size_t getOrder() const { return order; }
+        size_t getNumNonZeros() const { return values.size(); }
+
+        /**
+         * @brief Finds the storage position of an entry.
+         * @param row The row of the entry.
+         * @param column The column of the entry.
+         * @return The position in the value array, or getNumNonZeros() if the entry is not stored.
+         */
+        size_t find(size_t row, size_t column) const;
+
+        /// Direct access to the stored values, for in-place updates through positions returned by find.
+        vector<double>& getValues() { return values; }
+
+        /**
+         * @brief Computes `y = A x`.
+         * @param x The input vector, with getOrder() elements.
+         * @param y The output vector, with getOrder() elements; it must not alias x.
+         * @return None.
+         */
+        void multiply(const double* x, double* y) const;
+
+        /**
+         * @brief Adds the matrix to a dense matrix of the same order.
+         * @param dense The dense matrix receiving `dense + A`.
+         * @return None.
+         */
+        void addTo(DenseMatrix& dense) const;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef STATIC_MODEL_HPP
+#define STATIC_MODEL_HPP
+
+#include "Model.hpp"
+#include "FlowImpl.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <string>
+
+using std::string;
+
+/**
+ * @brief Requirements on a flow law usable by StaticModel.
+ * @details A law is a type with a static constexpr `equation(source, destination)` computing the flow from
+ * the values of the two systems it connects. A law may also declare a static constexpr `rate`, meaning that
+ * its equation is `rate * source`; the runtime adapter then reports the flow as linear.
+ */
+template <typename LAW>
+concept FlowLaw = requires(double source, double destination) {
+    { LAW::equation(source, destination) } -> std::convertible_to<double>;
+};
+
+/**
+ * @struct StaticFlow
+ * @brief Flow of a StaticModel: a law and the indices of the systems it connects, all known at compile time.
+ * @tparam LAW The law of the flow.
+ * @tparam SOURCE Index of the source system.
+ * @tparam DESTINATION Index of the destination system.
+ */
+template <FlowLaw LAW, size_t SOURCE, size_t DESTINATION>
+struct StaticFlow {
+    using Law = LAW;
+    static constexpr size_t source = SOURCE;
+    static constexpr size_t destination = DESTINATION;
+};
+
+/**
+ * @class StaticFlowAdapter
+ * @brief Runtime flow evaluating a compile-time law, for use with Model::createFlow.
+ * @details The adapter lets the laws of a StaticModel be used as the FLOW_TEMPLATE of `Model::createFlow`,
+ * so the same model structure can be run by both engines.
+ * @tparam LAW The law of the flow.
+ */
+template <FlowLaw LAW>
+class StaticFlowAdapter : public FlowHandle {
+    public:
+        StaticFlowAdapter(const string& name = "", System* source = nullptr, System* destination = nullptr)
+            : FlowHandle(name, source, destination) {}
+
+        double equation() const override {
+            if (this->getSource() && this->getDestination()) {
+                return LAW::equation(this->getSource()->getValue(), this->getDestination()->getValue());
+            }
+            return 0.0;
+        }
+
+        bool isLinear() const override {
+            return requires { LAW::rate; };
+        }
+
+        double getRate() const override {
+            if constexpr (requires { LAW::rate; }) {
+                return LAW::rate;
+            }
+            return 0.0;
+        }
+};
+
+/**
+ * @class StaticModel
+ * @brief Header-only model whose structure is fixed at compile time.
+ * @details The systems are the N elements of a `std::array<double, N>` and the flows are StaticFlow types,
+ * so the compiler sees the whole step function: there is no heap allocation, virtual call or reference
+ * counting, and the model can even be executed in constant expressions. It integrates with the same Euler
+ * scheme as the runtime engine, so both produce the same values.
+ *
+ * @code
+ * struct Exponential { static constexpr double rate = 0.01;
+ *                      static constexpr double equation(double source, double) { return rate * source; } };
+ * StaticModel<2, StaticFlow<Exponential, 0, 1>> model({100, 0});
+ * model.execute(0, 100, 1);
+ * @endcode
+ *
+ * @tparam N The number of systems.
+ * @tparam FLOWS The StaticFlow types of the model.
+ * @see Model
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+template <size_t N, typename... FLOWS>
+class StaticModel {
+    private:
+        std::array<double, N> values;   /**< Values of the systems. */
+        int currentTime = 0;            /**< Current time in the simulation. */
+
+        template <typename FLOW>
+        constexpr void accumulate(std::array<double, N>& changes) const {
+            static_assert(FLOW::source < N && FLOW::destination < N, "flow connects a system out of range");
+            double flowValue = FLOW::Law::equation(values[FLOW::source], values[FLOW::destination]);
+            changes[FLOW::source] -= flowValue;
+            changes[FLOW::destination] += flowValue;
+        }
+
+    public:
+        /**
+         * @brief Constructs the model with the initial values of its systems.
+         * @param initialValues The initial value of each system.
+         */
+        constexpr explicit StaticModel(const std::array<double, N>& initialValues) : values(initialValues) {}
+
+        constexpr double getValue(size_t system) const { return values[system]; }
+        constexpr void setValue(size_t system, double value) { values[system] = value; }
+        constexpr const std::array<double, N>& getValues() const { return values; }
+        constexpr int getCurrentTime() const { return currentTime; }
+
+        /**
+         * @brief Executes one step of the model.
+         * @return None.
+         */
+        constexpr void step() {
+            std::array<double, N> changes{};
+            (accumulate<FLOWS>(changes), ...);
+            for (size_t i = 0; i < N; i++) {
+                values[i] += changes[i];
+            }
+        }
+
+        /**
+         * @brief Executes the model over a time range, like Model::execute.
+         * @param startTime The time at which the model execution begins.
+         * @param endTime The time at which the model execution ends.
+         * @param timeStep The increment in time between each execution step.
+         * @return None.
+         */
+        constexpr void execute(int startTime, int endTime, int timeStep) {
+            currentTime = startTime;
+            for (int time = startTime + timeStep; time <= endTime; time += timeStep) {
+                step();
+                currentTime = time;
+            }
+        }
+
+        /**
+         * @brief Creates the systems and flows of this model in a runtime Model.
+         * @param model The runtime model receiving the structure and the current values.
+         * @param names The name of each system; the flows are named after their systems.
+         * @return The systems created, in the order of this model.
+         */
+        std::array<System*, N> toModel(Model* model, const std::array<string, N>& names) const {
+            std::array<System*, N> systems;
+            for (size_t i = 0; i < N; i++) {
+                systems[i] = model->createSystem(names[i], values[i]);
+            }
+            (model->template createFlow<StaticFlowAdapter<typename FLOWS::Law>>(
+                names[FLOWS::source] + "->" + names[FLOWS::destination],
+                systems[FLOWS::source], systems[FLOWS::destination]), ...);
+            return systems;
+        }
+};
+
+#endif
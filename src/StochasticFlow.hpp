@@ -0,0 +1,124 @@
+#ifndef STOCHASTIC_FLOW_HPP
+#define STOCHASTIC_FLOW_HPP
+
+#include "FlowImpl.hpp"
+#include "Philox.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @class StochasticFlow
+ * @brief Flow with random noise, reproducible whatever the threads and order of evaluation.
+ * @details The value of a StochasticFlow in a step is \f[ f = scale \cdot (mean + deviation \cdot z) \f]
+ * where z is a random number of mean 0 and variance 1 (NORMAL, or UNIFORM over [-sqrt(3), sqrt(3)]) and
+ * the scale is the value of the source for proportional flows, 1 otherwise.
+ *
+ * The number z is drawn by a counter-based generator (see Philox) from the run of the model (see
+ * Model::setRun), the name of the flow and the time of the step. It depends on nothing else: a run gives the
+ * same values sequentially or on any number of threads, forks with the same run draw the same noise, and
+ * forks given different runs draw independent noise, which is what Monte Carlo replicates need. The model
+ * draws the numbers of all the stochastic flows of a step in one batch.
+ *
+ * @code
+ * StochasticFlow* demand = model->createFlow<StochasticFlow>("demand", market, backlog);
+ * demand->setNoise(10.0, 2.5);
+ * model->setRun(replicate);
+ * @endcode
+ *
+ * @note `equation` returns the expected value; the noise is only drawn by the model. Flows with the same
+ * name draw the same numbers.
+ * @see Philox
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class StochasticFlow : public FlowHandle {
+    public:
+        /**
+         * @brief Distribution of the noise.
+         */
+        enum Distribution {
+            NORMAL,     /**< Standard normal. */
+            UNIFORM     /**< Uniform with variance 1. */
+        };
+
+    private:
+        Distribution distribution = NORMAL;
+        double mean = 0.0;
+        double deviation = 0.0;
+        bool proportional = false;      /**< Set when the value is scaled by the value of the source. */
+
+    public:
+        StochasticFlow(const string& name = "", System* source = nullptr, System* destination = nullptr)
+            : FlowHandle(name, source, destination) {}
+
+        double equation() const override {
+            System* source = this->getSource();
+            return proportional && source ? mean * source->getValue() : mean;
+        }
+
+        /**
+         * @brief Sets the mean and standard deviation of the flow.
+         * @param mean The mean, per unit of the source for proportional flows.
+         * @param deviation The standard deviation, in the same unit.
+         * @param distribution The distribution of the noise.
+         * @param proportional If true, the value is scaled by the value of the source.
+         */
+        void setNoise(double mean, double deviation, Distribution distribution = NORMAL, bool proportional = false) {
+            this->mean = mean;
+            this->deviation = deviation;
+            this->distribution = distribution;
+            this->proportional = proportional;
+        }
+
+        double getMean() const { return mean; }
+        double getDeviation() const { return deviation; }
+        Distribution getDistribution() const { return distribution; }
+        bool isProportional() const { return proportional; }
+
+        /**
+         * @brief Gets the key of the random numbers of the flow.
+         * @return The hash of its name.
+         */
+        uint64_t getStream() const { return Philox::hash(this->getName()); }
+
+        /**
+         * @brief Computes the value of the flow in a step.
+         * @param run The run of the model.
+         * @param time The time at the start of the step.
+         * @param source The value of the source.
+         * @return The value.
+         */
+        double sample(uint64_t run, int time, double source) const {
+            return value(draw(getStream(), run, time, distribution), source);
+        }
+
+        /**
+         * @brief Draws the noise of a flow in a step.
+         * @param stream The key of the flow.
+         * @param run The run of the model.
+         * @param time The time at the start of the step.
+         * @param distribution The distribution.
+         * @return A number of mean 0 and variance 1.
+         */
+        static double draw(uint64_t stream, uint64_t run, int time, Distribution distribution = NORMAL) {
+            uint64_t step = uint64_t(int64_t(time));
+            if (distribution == UNIFORM) {
+                return std::sqrt(3.0) * (2.0 * Philox::uniform(stream, run, step) - 1.0);
+            }
+            return Philox::normal(stream, run, step);
+        }
+
+        /**
+         * @brief Computes the value of the flow for a given noise.
+         * @param noise The number drawn, of mean 0 and variance 1.
+         * @param source The value of the source.
+         * @return The value.
+         */
+        double value(double noise, double source) const {
+            double rate = mean + deviation * noise;
+            return proportional ? rate * source : rate;
+        }
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "ThreadPool.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace {
+
+thread_local bool insideJob = false;    // Set while the thread runs chunks of a job.
+
+}
+
+ThreadPool::ThreadPool() {
+    unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 1; i < numThreads; i++) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::getInstance() {
+    static ThreadPool instance;
+    return instance;
+}
+
+void ThreadPool::runChunks() {
+    insideJob = true;
+    for (size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++) {
+        Trace::Scope trace("chunk", "pool");
+        (*job)(chunk);
+    }
+    insideJob = false;
+}
+
+void ThreadPool::work(unsigned index) {
+    Trace::setThreadName("worker " + std::to_string(index));
+    unsigned long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pendingWorkers == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t numChunks, const std::function<void(size_t)>& function) {
+    // Loops nested in a job run inline: the pool is busy with the outer job, and waiting for it would deadlock.
+    if (workers.empty() || numChunks <= 1 || insideJob) {
+        for (size_t chunk = 0; chunk < numChunks; chunk++) {
+            Trace::Scope trace("chunk", "pool");
+            function(chunk);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(submitMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &function;
+        this->numChunks = numChunks;
+        nextChunk = 0;
+        pendingWorkers = workers.size();
+        generation++;
+    }
+    wakeUp.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return pendingWorkers == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::parallelRange(size_t size, size_t grain, const std::function<void(size_t, size_t)>& function) {
+    size_t numChunks = std::min(4 * getNumThreads(), size / std::max<size_t>(grain, 1));
+    if (numChunks <= 1) {
+        if (size > 0) {
+            function(0, size);
+        }
+        return;
+    }
+    parallelFor(numChunks, [&](size_t chunk) {
+        function(size * chunk / numChunks, size * (chunk + 1) / numChunks);
+    });
+}
@@ -0,0 +1,85 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads used to run data-parallel loops of the engine.
+ * @details The workers are created once and sleep between jobs, so splitting a step across threads 
+ * costs a wake-up instead of a thread creation. A job is a number of chunks; the workers and the calling 
+ * thread claim chunks from a shared counter until all of them are done.
+ * 
+ * Like the Model, the pool is a singleton, shared by every part of the library that runs in parallel.
+ * 
+ * Loops started from inside a job, such as the sparse products of models run by parallel calibration
+ * candidates, run their chunks inline on the thread of the enclosing chunk.
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class ThreadPool {
+    private:
+        vector<std::thread> workers;                    /**< Worker threads, one less than the hardware threads. */
+        std::mutex mutex;                               /**< Protects the job fields below. */
+        std::condition_variable wakeUp;                 /**< Signals the workers that a new job is available. */
+        std::condition_variable finished;               /**< Signals the caller that the job is complete. */
+        const std::function<void(size_t)>* job = nullptr;   /**< Current job, called once per chunk. */
+        size_t numChunks = 0;                           /**< Number of chunks of the current job. */
+        std::atomic<size_t> nextChunk{0};               /**< Next chunk to be claimed. */
+        size_t pendingWorkers = 0;                      /**< Workers still running the current job. */
+        unsigned long generation = 0;                   /**< Incremented for every job, so workers run each once. */
+        bool stopping = false;                          /**< Set when the pool is being destroyed. */
+        std::mutex submitMutex;                         /**< Serializes jobs submitted from different threads. */
+
+        ThreadPool();
+        void work(unsigned index);
+        void runChunks();
+
+    public:
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Retrieves the singleton instance of the pool.
+         * @return The pool, created on first use.
+         */
+        static ThreadPool& getInstance();
+
+        /**
+         * @brief Gets the number of threads that run a job, including the caller.
+         * @return The number of workers plus one.
+         */
+        size_t getNumThreads() const { return workers.size() + 1; }
+
+        /**
+         * @brief Runs a function for every chunk index in [0, numChunks) and waits for all of them.
+         * @details Called from inside a job, the chunks run one after the other on the calling thread.
+         * @param numChunks The number of chunks.
+         * @param function The function called with each chunk index, possibly from several threads.
+         * @return None.
+         */
+        void parallelFor(size_t numChunks, const std::function<void(size_t)>& function);
+
+        /**
+         * @brief Splits the range [0, size) into contiguous chunks and runs a function on each of them.
+         * @details Chunks hold at least `grain` elements, so small ranges run on the calling thread alone; 
+         * larger ones are split into a few chunks per thread to balance uneven work.
+         * @param size The size of the range.
+         * @param grain The minimum number of elements of a chunk.
+         * @param function The function called with the bounds [begin, end) of each chunk.
+         * @return None.
+         */
+        void parallelRange(size_t size, size_t grain, const std::function<void(size_t, size_t)>& function);
+};
+
+#endif
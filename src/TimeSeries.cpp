@@ -0,0 +1,276 @@
+#include "TimeSeries.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::string_view;
+
+namespace {
+
+const char MAGIC[8] = {'M', 'V', 'S', 'E', 'R', 'I', 'E', 'S'};
+const size_t HEADER_SIZE = 16;              // Magic and number of samples.
+const size_t READ_AHEAD = size_t(1) << 20;  // Bytes requested ahead of the read position of mapped files.
+
+bool fail(string* error, const string& message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+bool increasing(std::span<const double> times) {
+    for (size_t i = 1; i < times.size(); i++) {
+        if (!(times[i] > times[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Maps a whole file for reading; returns null and fills the error on failure.
+const char* map(const string& path, size_t& size, string* error) {
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        fail(error, "cannot open '" + path + "'");
+        return nullptr;
+    }
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        close(file);
+        fail(error, "'" + path + "' is empty or unreadable");
+        return nullptr;
+    }
+    size = status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapping == MAP_FAILED) {
+        fail(error, "cannot map '" + path + "'");
+        return nullptr;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    return (const char*) mapping;
+}
+
+// Parses a number at the start of a field, after blanks.
+bool parseField(string_view field, double& value) {
+    size_t start = field.find_first_not_of(" \t");
+    if (start == string_view::npos) {
+        return false;
+    }
+    auto result = std::from_chars(field.data() + start, field.data() + field.size(), value);
+    return result.ec == std::errc();
+}
+
+}
+
+TimeSeries::~TimeSeries() {
+    release();
+}
+
+void TimeSeries::release() {
+    if (data) {
+        munmap((void*) data, size);
+    }
+    data = nullptr;
+    size = 0;
+    records = nullptr;
+    count = 0;
+    samples.clear();
+    source = MEMORY;
+}
+
+bool TimeSeries::set(std::span<const double> times, std::span<const double> values) {
+    if (times.size() != values.size() || !increasing(times)) {
+        return false;
+    }
+    release();
+    samples.resize(2 * times.size());
+    for (size_t i = 0; i < times.size(); i++) {
+        samples[2 * i] = times[i];
+        samples[2 * i + 1] = values[i];
+    }
+    records = samples.data();
+    count = times.size();
+    return true;
+}
+
+bool TimeSeries::openBinary(const string& path, string* error) {
+    size_t mappedSize;
+    const char* mapped = map(path, mappedSize, error);
+    if (!mapped) {
+        return false;
+    }
+
+    uint64_t numSamples = 0;
+    if (mappedSize >= HEADER_SIZE) {
+        std::memcpy(&numSamples, mapped + sizeof(MAGIC), sizeof(numSamples));
+    }
+    if (mappedSize < HEADER_SIZE || std::memcmp(mapped, MAGIC, sizeof(MAGIC)) != 0
+        || mappedSize != HEADER_SIZE + numSamples * 2 * sizeof(double)) {
+        munmap((void*) mapped, mappedSize);
+        return fail(error, "'" + path + "' is not a time series or is truncated");
+    }
+
+    release();
+    source = BINARY;
+    data = mapped;
+    size = mappedSize;
+    records = (const double*) (mapped + HEADER_SIZE);
+    count = numSamples;
+    return true;
+}
+
+bool TimeSeries::openCsv(const string& path, size_t column, string* error) {
+    if (column == 0) {
+        return fail(error, "the values cannot be in the time column");
+    }
+    size_t mappedSize;
+    const char* mapped = map(path, mappedSize, error);
+    if (!mapped) {
+        return false;
+    }
+
+    release();
+    source = CSV;
+    data = mapped;
+    size = mappedSize;
+    this->column = column;
+    return true;
+}
+
+bool TimeSeries::writeBinary(const string& path, std::span<const double> times, std::span<const double> values,
+                             string* error) {
+    if (times.size() != values.size() || !increasing(times)) {
+        return fail(error, "the times must be increasing, with one value each");
+    }
+
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    uint64_t numSamples = times.size();
+    output.write(MAGIC, sizeof(MAGIC));
+    output.write((const char*) &numSamples, sizeof(numSamples));
+    for (size_t i = 0; i < times.size(); i++) {
+        output.write((const char*) &times[i], sizeof(double));
+        output.write((const char*) &values[i], sizeof(double));
+    }
+    if (!output) {
+        return fail(error, "cannot write '" + path + "'");
+    }
+    return true;
+}
+
+void TimeSeries::readAhead(size_t offset, size_t previous) const {
+    // Once per window crossed, ask for the next window so that it is read while this one is consumed.
+    if (data && offset / READ_AHEAD != previous / READ_AHEAD) {
+        size_t page = size_t(sysconf(_SC_PAGESIZE));
+        size_t start = (offset + READ_AHEAD) / page * page;
+        if (start < size) {
+            madvise((void*) (data + start), std::min(READ_AHEAD, size - start), MADV_WILLNEED);
+        }
+    }
+}
+
+bool TimeSeries::read(Cursor& cursor) const {
+    if (source == CSV) {
+        return readCsv(cursor);
+    }
+    if (cursor.next >= count) {
+        return false;
+    }
+    if (source == BINARY) {
+        readAhead(HEADER_SIZE + (cursor.next + 1) * 2 * sizeof(double), HEADER_SIZE + cursor.next * 2 * sizeof(double));
+    }
+    cursor.time1 = records[2 * cursor.next];
+    cursor.value1 = records[2 * cursor.next + 1];
+    cursor.next++;
+    return true;
+}
+
+bool TimeSeries::readCsv(Cursor& cursor) const {
+    string_view text(data, size);
+    while (cursor.next < size) {
+        size_t end = text.find('\n', cursor.next);
+        end = end == string_view::npos ? size : end;
+        string_view line = text.substr(cursor.next, end - cursor.next);
+        readAhead(end + 1, cursor.next);
+        cursor.next = end + 1;
+
+        // The time is the first field, the value the field at the chosen column.
+        double time;
+        double value;
+        size_t field = 0;
+        size_t start = 0;
+        bool hasTime = false;
+        while (field <= column && start <= line.size()) {
+            size_t comma = line.find(',', start);
+            string_view cell = line.substr(start, comma == string_view::npos ? string_view::npos : comma - start);
+            if (field == 0) {
+                hasTime = parseField(cell, time);
+            } else if (field == column && hasTime && parseField(cell, value)) {
+                cursor.time1 = time;
+                cursor.value1 = value;
+                return true;
+            }
+            if (comma == string_view::npos || !hasTime) {
+                break;
+            }
+            start = comma + 1;
+            field++;
+        }
+    }
+    return false;
+}
+
+void TimeSeries::rewind(Cursor& cursor, double time) const {
+    cursor = Cursor();
+    if (source != CSV) {
+        // Start from the last sample at or before the time.
+        size_t low = 0;
+        size_t high = count;
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (records[2 * middle] <= time) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        cursor.next = low > 0 ? low - 1 : 0;
+    }
+
+    if (read(cursor)) {
+        cursor.time0 = cursor.time1;
+        cursor.value0 = cursor.value1;
+        cursor.loaded = read(cursor) ? 2 : 1;
+    }
+}
+
+double TimeSeries::valueAt(Cursor& cursor, double time) const {
+    if (cursor.loaded == 0 || time < cursor.time0) {
+        rewind(cursor, time);
+        if (cursor.loaded == 0) {
+            return 0.0;
+        }
+    }
+    while (cursor.loaded == 2 && cursor.time1 <= time) {
+        cursor.time0 = cursor.time1;
+        cursor.value0 = cursor.value1;
+        if (!read(cursor)) {
+            cursor.loaded = 1;
+        }
+    }
+
+    // Before the first sample, after the last, or held until the next one.
+    if (cursor.loaded == 1 || time <= cursor.time0 || interpolation == STEP) {
+        return cursor.value0;
+    }
+    double fraction = (time - cursor.time0) / (cursor.time1 - cursor.time0);
+    return cursor.value0 + fraction * (cursor.value1 - cursor.value0);
+}
@@ -0,0 +1,148 @@
+#ifndef TIME_SERIES_HPP
+#define TIME_SERIES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @class TimeSeries
+ * @brief Exogenous input given as samples over time, such as demand or weather data.
+ * @details A series is a sequence of (time, value) samples with increasing times, interpolated linearly or
+ * held (STEP) between samples, and held at its first or last value outside them. Series bound to systems
+ * or parameters of a model (see Model::bindInput) are read by the engine at every step.
+ *
+ * Samples come from memory, or from a file mapped in memory and read as the runs move forward, so files
+ * larger than RAM can be used; the pages ahead of the read position are requested from the system in
+ * advance. Two file formats are supported:
+ * - binary: an 8-byte magic `MVSERIES`, the number of samples as a 64-bit integer, then the samples as
+ *   pairs of doubles (time, value), in the byte order of the machine (see writeBinary);
+ * - CSV: one sample per line, the time in the first column and the value in a chosen column, separated by
+ *   commas. Lines that do not start with two numbers, such as headers and `#` comments, are skipped.
+ *
+ * A series is not modified by reading it: the read position lives in a Cursor, one per reader, so forked
+ * models may read the same series concurrently. Reads moving forward cost amortized O(1); moving back
+ * costs a binary search in binary files and memory, and a scan from the start in CSV files.
+ *
+ * @code
+ * TimeSeries demand;
+ * demand.openCsv("demand.csv", 1);
+ * model->bindInput(orders, &demand);
+ * model->execute(0, 8760, 1);
+ * @endcode
+ *
+ * @see Model::bindInput
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class TimeSeries {
+    public:
+        /**
+         * @brief Interpolation between samples.
+         */
+        enum Interpolation {
+            STEP,       /**< The value of the last sample at or before the time. */
+            LINEAR      /**< Linear between the samples around the time. */
+        };
+
+        /**
+         * @struct Cursor
+         * @brief Read position of a reader of the series, with the samples around its last time.
+         */
+        struct Cursor {
+            size_t next = 0;        /**< Index (memory, binary) or byte offset (CSV) of the next sample to read. */
+            int loaded = 0;         /**< Number of valid samples among (time0, value0) and (time1, value1). */
+            double time0 = 0.0;
+            double value0 = 0.0;
+            double time1 = 0.0;
+            double value1 = 0.0;
+        };
+
+    private:
+        enum Source { MEMORY, BINARY, CSV };
+
+        Source source = MEMORY;
+        Interpolation interpolation = LINEAR;
+        vector<double> samples;             /**< Interleaved times and values of a series in memory. */
+        const double* records = nullptr;    /**< Interleaved times and values, in memory or in a binary file. */
+        size_t count = 0;                   /**< Number of samples of a series in memory or in a binary file. */
+        const char* data = nullptr;         /**< Mapped file. */
+        size_t size = 0;                    /**< Size of the mapped file. */
+        size_t column = 1;                  /**< Column of the values in a CSV file. */
+
+        void release();
+        bool read(Cursor& cursor) const;
+        bool readCsv(Cursor& cursor) const;
+        void readAhead(size_t offset, size_t previous) const;
+        void rewind(Cursor& cursor, double time) const;
+
+    public:
+        TimeSeries() = default;
+        TimeSeries(const TimeSeries&) = delete;
+        TimeSeries& operator=(const TimeSeries&) = delete;
+        ~TimeSeries();
+
+        /**
+         * @brief Sets the samples of the series from memory.
+         * @param times The times of the samples, increasing.
+         * @param values The value of each sample.
+         * @return True if the samples were set, false if the sizes differ or the times are not increasing.
+         */
+        bool set(std::span<const double> times, std::span<const double> values);
+
+        /**
+         * @brief Maps a binary series file.
+         * @param path The path of the file.
+         * @param error Receives a description of the problem when opening fails; may be null.
+         * @return True if the file was mapped, false if it is missing, truncated or not a series file.
+         */
+        bool openBinary(const string& path, string* error = nullptr);
+
+        /**
+         * @brief Maps a CSV series file.
+         * @param path The path of the file.
+         * @param column The zero-based column of the values; the times are in column 0.
+         * @param error Receives a description of the problem when opening fails; may be null.
+         * @return True if the file was mapped, false if it is missing or the column is 0.
+         */
+        bool openCsv(const string& path, size_t column = 1, string* error = nullptr);
+
+        /**
+         * @brief Writes samples as a binary series file.
+         * @param path The path of the file.
+         * @param times The times of the samples, increasing.
+         * @param values The value of each sample.
+         * @param error Receives a description of the problem when writing fails; may be null.
+         * @return True if the file was written.
+         */
+        static bool writeBinary(const string& path, std::span<const double> times, std::span<const double> values,
+                                string* error = nullptr);
+
+        void setInterpolation(Interpolation interpolation) { this->interpolation = interpolation; }
+        Interpolation getInterpolation() const { return interpolation; }
+
+        /**
+         * @brief Gets the value of the series at a time, moving a cursor.
+         * @param cursor The read position of the caller, updated to the time.
+         * @param time The time.
+         * @return The interpolated value, or zero for a series without samples.
+         */
+        double valueAt(Cursor& cursor, double time) const;
+
+        /**
+         * @brief Gets the value of the series at a time, reading from the start.
+         * @param time The time.
+         * @return The interpolated value, or zero for a series without samples.
+         */
+        double valueAt(double time) const {
+            Cursor cursor;
+            return valueAt(cursor, time);
+        }
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "Trace.hpp"
+#include "Json.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+/// Events of one thread: written by that thread only, read once published by the count.
+struct Trace::Buffer {
+    vector<Event> events;               /**< Preallocated events. */
+    std::atomic<size_t> count{0};       /**< Events written. */
+    std::atomic<size_t> dropped{0};     /**< Events lost because the buffer was full. */
+    std::atomic<uint64_t> generation{0};    /**< Generation of the events; older ones were cleared. */
+    uint32_t thread;                    /**< Index of the thread. */
+    string name;                        /**< Name of the thread, guarded by the registry mutex. */
+};
+
+/// Buffers of all the threads that recorded events.
+struct Trace::Registry {
+    std::mutex mutex;                                   /**< Protects the list of buffers and their names. */
+    vector<std::unique_ptr<Buffer>> buffers;
+    std::atomic<size_t> capacity{size_t(1) << 16};      /**< Capacity of the next buffers. */
+    std::atomic<uint64_t> generation{0};                /**< Incremented by every clear. */
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+namespace {
+
+thread_local string threadName;     // Name given by setThreadName, kept until the thread records.
+
+// Events are written and copied field by field with relaxed atomics: a reader may copy an event while its
+// thread overwrites it after a clear, and then discards the copy (see getEvents), but never races on it.
+void storeEvent(Trace::Event& slot, const Trace::Event& event) {
+    std::atomic_ref<const char*>(slot.name).store(event.name, std::memory_order_relaxed);
+    std::atomic_ref<const char*>(slot.category).store(event.category, std::memory_order_relaxed);
+    std::atomic_ref<uint64_t>(slot.start).store(event.start, std::memory_order_relaxed);
+    std::atomic_ref<uint64_t>(slot.duration).store(event.duration, std::memory_order_relaxed);
+    std::atomic_ref<uint32_t>(slot.thread).store(event.thread, std::memory_order_relaxed);
+}
+
+Trace::Event loadEvent(Trace::Event& slot) {
+    return {std::atomic_ref<const char*>(slot.name).load(std::memory_order_relaxed),
+            std::atomic_ref<const char*>(slot.category).load(std::memory_order_relaxed),
+            std::atomic_ref<uint64_t>(slot.start).load(std::memory_order_relaxed),
+            std::atomic_ref<uint64_t>(slot.duration).load(std::memory_order_relaxed),
+            std::atomic_ref<uint32_t>(slot.thread).load(std::memory_order_relaxed)};
+}
+
+}
+
+Trace::Registry& Trace::registry() {
+    static Registry instance;
+    return instance;
+}
+
+Trace::Buffer*& Trace::current() {
+    static thread_local Buffer* local = nullptr;
+    return local;
+}
+
+Trace::Buffer& Trace::buffer() {
+    Buffer*& local = current();
+    if (!local) {
+        Registry& shared = registry();
+        auto created = std::make_unique<Buffer>();
+        created->events.resize(shared.capacity.load());
+        created->generation = shared.generation.load();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        created->thread = uint32_t(shared.buffers.size());
+        created->name = threadName.empty() ? "thread " + std::to_string(created->thread) : threadName;
+        local = created.get();
+        shared.buffers.push_back(std::move(created));
+    }
+    return *local;
+}
+
+void Trace::enable(size_t capacity) {
+    registry().capacity = capacity;
+    enabled = true;
+}
+
+void Trace::disable() {
+    enabled = false;
+}
+
+uint64_t Trace::now() {
+    auto elapsed = std::chrono::steady_clock::now() - registry().epoch;
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Trace::record(const char* name, const char* category, uint64_t start, uint64_t duration) {
+    Buffer& local = buffer();
+    // Buffers are only reset by their own thread, when it records its first event after a clear.
+    uint64_t generation = registry().generation.load(std::memory_order_relaxed);
+    if (local.generation.load(std::memory_order_relaxed) != generation) {
+        local.count.store(0, std::memory_order_relaxed);
+        local.dropped.store(0, std::memory_order_relaxed);
+        local.generation.store(generation, std::memory_order_relaxed);
+        // The new generation is visible to any reader that sees an event overwritten after this point.
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    size_t count = local.count.load(std::memory_order_relaxed);
+    if (count >= local.events.size()) {
+        local.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    storeEvent(local.events[count], {name, category, start, duration, local.thread});
+    local.count.store(count + 1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const string& name) {
+    threadName = name;
+    // A thread that already recorded is renamed in place; the others get the name with their buffer.
+    if (Buffer* local = current()) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        local->name = name;
+    }
+}
+
+vector<Trace::Event> Trace::getEvents() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    uint64_t generation = shared.generation.load();
+    vector<Event> events;
+    for (const std::unique_ptr<Buffer>& buffer : shared.buffers) {
+        if (buffer->generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        size_t first = events.size();
+        for (size_t i = 0; i < count; i++) {
+            events.push_back(loadEvent(buffer->events[i]));
+        }
+        // A buffer reset by its thread during the copy belongs to a later generation: its copy is dropped.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+            events.resize(first);
+        }
+    }
+    return events;
+}
+
+size_t Trace::getDropped() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    uint64_t generation = shared.generation.load();
+    size_t dropped = 0;
+    for (const std::unique_ptr<Buffer>& buffer : shared.buffers) {
+        if (buffer->generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+string Trace::toJson() {
+    Registry& shared = registry();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    const char* separator = "\n";
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (const std::unique_ptr<Buffer>& buffer : shared.buffers) {
+            out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread
+                << ", \"args\": {\"name\": " << Json::quote(buffer->name) << "}}";
+            separator = ",\n";
+        }
+    }
+    for (const Event& event : getEvents()) {
+        out << separator << "{\"name\": " << Json::quote(event.name) << ", \"cat\": " << Json::quote(event.category)
+            << ", \"ph\": \"X\", \"ts\": " << double(event.start) / 1000.0 << ", \"dur\": " << double(event.duration) / 1000.0
+            << ", \"pid\": 1, \"tid\": " << event.thread << "}";
+        separator = ",\n";
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+bool Trace::writeJson(const string& path, string* error) {
+    return Json::write(path, toJson(), error);
+}
+
+void Trace::clear() {
+    registry().generation++;
+}
@@ -0,0 +1,170 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/**
+ * @class Trace
+ * @brief Timeline of the phases of the engine, exported as Chrome trace JSON for Perfetto.
+ * @details The engine marks its phases with scopes: plan building, the evaluation of the flows, the state
+ * update, inputs, events, recording and storing the values of each step, and every chunk of work run by
+ * the thread pool, such as the blocks of the sparse product. While tracing is enabled, each scope becomes
+ * a complete event on the timeline of the thread that ran it, so the steps of a run and the work of every
+ * pool worker appear side by side.
+ *
+ * Every thread writes its events to its own buffer, preallocated when the thread records its first event:
+ * recording an event takes two clock readings and a store, with no lock and no allocation. When a buffer
+ * is full, further events of its thread are counted as dropped. Disabled tracing costs one relaxed atomic
+ * load per scope.
+ *
+ * @code
+ * Trace::enable();
+ * model->execute(0, 1000, 1);
+ * Trace::disable();
+ * Trace::writeJson("run.json");    // open in ui.perfetto.dev or chrome://tracing
+ * @endcode
+ *
+ * The events can be read and cleared while other threads record: readers only see the events published
+ * by the count of each buffer, and clear starts a new generation of events, which each thread applies to
+ * its own buffer when it records its next event. An event recorded while clear runs may belong to
+ * either generation. A thread may reset its buffer while a reader copies it; the reader then finds the
+ * generation of the buffer changed after the copy and leaves the buffer out, like a seqlock.
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class Trace {
+    public:
+        /**
+         * @struct Event
+         * @brief A phase run by a thread.
+         */
+        struct Event {
+            const char* name;       /**< Name of the phase; a string literal. */
+            const char* category;   /**< Part of the engine; a string literal. */
+            uint64_t start;         /**< Start, in nanoseconds since the first use of the trace. */
+            uint64_t duration;      /**< Duration, in nanoseconds. */
+            uint32_t thread;        /**< Index of the thread, in the order threads first recorded. */
+        };
+
+        /**
+         * @class Scope
+         * @brief Records an event for its lifetime, if tracing is enabled when it is constructed.
+         */
+        class Scope {
+            private:
+                const char* name;
+                const char* category;
+                uint64_t start = 0;
+                bool active;
+
+            public:
+                Scope(const char* name, const char* category) : name(name), category(category), active(isEnabled()) {
+                    if (active) {
+                        start = now();
+                    }
+                }
+
+                ~Scope() {
+                    if (active) {
+                        record(name, category, start, now() - start);
+                    }
+                }
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+        };
+
+    private:
+        struct Buffer;
+        struct Registry;
+
+        static inline std::atomic<bool> enabled{false};
+
+        static Registry& registry();
+        static Buffer*& current();
+        static Buffer& buffer();
+
+    public:
+        /**
+         * @brief Starts recording events.
+         * @param capacity The number of events of the buffer of each thread that records its first event from now.
+         * @return None.
+         */
+        static void enable(size_t capacity = size_t(1) << 16);
+
+        /**
+         * @brief Stops recording events; the recorded ones are kept.
+         * @return None.
+         */
+        static void disable();
+
+        static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Gets the current time of the trace clock.
+         * @return Nanoseconds since the first use of the trace.
+         */
+        static uint64_t now();
+
+        /**
+         * @brief Records a complete event on the timeline of the calling thread.
+         * @param name The name of the phase; a string literal.
+         * @param category The part of the engine; a string literal.
+         * @param start The start, from now.
+         * @param duration The duration, in nanoseconds.
+         * @return None.
+         */
+        static void record(const char* name, const char* category, uint64_t start, uint64_t duration);
+
+        /**
+         * @brief Names the timeline of the calling thread.
+         * @param name The name shown for the thread.
+         * @return None.
+         */
+        static void setThreadName(const string& name);
+
+        /**
+         * @brief Gets the recorded events.
+         * @return The events of every thread, thread by thread in the order they were recorded.
+         */
+        static vector<Event> getEvents();
+
+        /**
+         * @brief Gets the number of events lost because a buffer was full.
+         * @return The number of events dropped since the last clear.
+         */
+        static size_t getDropped();
+
+        /**
+         * @brief Formats the recorded events as Chrome trace JSON.
+         * @details A `traceEvents` array with a thread name event (`"ph": "M"`) per thread, then a complete
+         * event (`"ph": "X"`) per recorded event, with times in microseconds.
+         * @return The JSON text.
+         */
+        static string toJson();
+
+        /**
+         * @brief Writes the recorded events as Chrome trace JSON to a file.
+         * @param path The path of the file.
+         * @param error Receives a description of the problem when writing fails; may be null.
+         * @return True if the file was written.
+         */
+        static bool writeJson(const string& path, string* error = nullptr);
+
+        /**
+         * @brief Removes the recorded events, keeping the buffers.
+         * @details Safe while other threads record: the buffers are not touched here, but reset by their
+         * threads before their next event, and their older events are no longer reported.
+         * @return None.
+         */
+        static void clear();
+};
+
+#endif
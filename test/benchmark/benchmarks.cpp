@@ -0,0 +1,199 @@
+#include "benchmarks.hpp"
+#include "../../src/Json.hpp"
+#include "../../src/Philox.hpp"
+#include "../../src/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+typedef std::pair<size_t, size_t> Edge;
+
+constexpr uint64_t SEED = Philox::hash("benchmark");
+constexpr double EVALUATIONS_PER_RUN = 2e7;     // Flow evaluations aimed at when the steps are not given.
+
+size_t draw(uint64_t stream, uint64_t index, size_t count) {
+    return std::min(size_t(Philox::uniform(SEED, stream, index) * double(count)), count - 1);
+}
+
+// Two flows per system between distinct systems of [first, first + count).
+void randomEdges(size_t first, size_t count, uint64_t stream, vector<Edge>& edges) {
+    for (size_t i = 0; i < 2 * count; i++) {
+        size_t source = draw(stream, 2 * i, count);
+        size_t destination = draw(stream, 2 * i + 1, count);
+        if (destination == source) {
+            destination = (source + 1) % count;
+        }
+        edges.push_back({first + source, first + destination});
+    }
+}
+
+vector<Edge> edgesOf(Topology topology, size_t numSystems) {
+    vector<Edge> edges;
+    switch (topology) {
+        case CHAIN:
+            for (size_t i = 0; i + 1 < numSystems; i++) {
+                edges.push_back({i, i + 1});
+            }
+            break;
+        case STAR:
+            for (size_t i = 1; i < numSystems; i++) {
+                edges.push_back({i, 0});
+            }
+            break;
+        case RANDOM:
+            randomEdges(0, numSystems, numSystems, edges);
+            break;
+        case CLUSTERS:
+            for (size_t first = 0; first < numSystems; first += CLUSTER_SIZE) {
+                size_t count = std::min(CLUSTER_SIZE, numSystems - first);
+                if (count > 1) {
+                    randomEdges(first, count, first, edges);
+                }
+            }
+            break;
+    }
+    return edges;
+}
+
+// Runs in the child process of a case; the peak memory is measured by the parent when the child exits.
+BenchmarkResult measure(Topology topology, size_t numSystems, int steps) {
+    BenchmarkResult result;
+    result.topology = topology;
+    result.systems = numSystems;
+
+    auto start = std::chrono::steady_clock::now();
+    Model* model = Model::createModel("benchmark");
+    result.flows = generateModel(model, topology, numSystems);
+    model->execute(0, 1, 1);
+    auto built = std::chrono::steady_clock::now();
+    result.buildSeconds = std::chrono::duration<double>(built - start).count();
+
+    if (steps <= 0) {
+        steps = int(std::clamp(EVALUATIONS_PER_RUN / double(std::max<size_t>(result.flows, 1)), 10.0, 1000.0));
+    }
+    result.steps = steps;
+    model->execute(1, 1 + steps, 1);
+    result.runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - built).count();
+
+    double evaluations = double(steps) * double(result.flows);
+    result.stepsPerSecond = double(steps) / result.runSeconds;
+    result.flowsPerSecond = evaluations / result.runSeconds;
+    result.nanosecondsPerFlow = evaluations > 0 ? 1e9 * result.runSeconds / evaluations : 0.0;
+    Model::deleteModel();
+    return result;
+}
+
+}
+
+const char* topologyName(Topology topology) {
+    switch (topology) {
+        case CHAIN: return "chain";
+        case STAR: return "star";
+        case RANDOM: return "random";
+        case CLUSTERS: return "clusters";
+    }
+    return "";
+}
+
+size_t generateModel(Model* model, Topology topology, size_t numSystems) {
+    vector<Edge> edges = edgesOf(topology, numSystems);
+    model->reserve(numSystems, edges.size());
+
+    vector<string> names(numSystems);
+    vector<double> values(numSystems);
+    for (size_t i = 0; i < numSystems; i++) {
+        names[i] = "s" + std::to_string(i);
+        values[i] = 10.0 + double(i % 50);
+    }
+    vector<System*> systems = model->createSystems(names, values);
+
+    vector<string> exponentialNames, logisticNames;
+    vector<System*> exponentialSources, exponentialDestinations, logisticSources, logisticDestinations;
+    for (size_t i = 0; i < edges.size(); i++) {
+        System* source = systems[edges[i].first];
+        System* destination = systems[edges[i].second];
+        string name = "f" + std::to_string(i);
+        if (i % 10 < 7) {
+            exponentialNames.push_back(name);
+            exponentialSources.push_back(source);
+            exponentialDestinations.push_back(destination);
+        } else if (i % 10 < 9) {
+            logisticNames.push_back(name);
+            logisticSources.push_back(destination);
+            logisticDestinations.push_back(source);
+        } else {
+            model->createFlow(name, source, destination, "0.001 * source / (1 + destination * destination)");
+        }
+    }
+    model->createFlows<ExponentialFlow>(exponentialNames, exponentialSources, exponentialDestinations);
+    model->createFlows<LogisticFlow>(logisticNames, logisticSources, logisticDestinations);
+    return edges.size();
+}
+
+bool runBenchmark(Topology topology, size_t numSystems, int steps, BenchmarkResult* result, std::string* error) {
+    int channel[2];
+    if (pipe(channel) != 0) {
+        if (error) {
+            *error = std::string("cannot create a pipe: ") + std::strerror(errno);
+        }
+        return false;
+    }
+    pid_t child = fork();
+    if (child < 0) {
+        if (error) {
+            *error = std::string("cannot start a process: ") + std::strerror(errno);
+        }
+        close(channel[0]);
+        close(channel[1]);
+        return false;
+    }
+    if (child == 0) {
+        close(channel[0]);
+        BenchmarkResult measured = measure(topology, numSystems, steps);
+        bool sent = write(channel[1], &measured, sizeof(measured)) == ssize_t(sizeof(measured));
+        _exit(sent ? 0 : 1);
+    }
+
+    close(channel[1]);
+    BenchmarkResult measured;
+    bool received = read(channel[0], &measured, sizeof(measured)) == ssize_t(sizeof(measured));
+    close(channel[0]);
+    int status = 0;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || !received) {
+        if (error) {
+            *error = std::string("the case ") + topologyName(topology) + " " + std::to_string(numSystems) + " failed";
+        }
+        return false;
+    }
+    measured.peakKilobytes = usage.ru_maxrss;
+    *result = measured;
+    return true;
+}
+
+std::string toJson(const std::vector<BenchmarkResult>& results, const std::string& label) {
+    std::ostringstream out;
+    out << std::setprecision(6);
+    out << "{\n  \"label\": " << Json::quote(label) << ",\n  \"threads\": " << ThreadPool::getInstance().getNumThreads()
+        << ",\n  \"cases\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        out << (i ? ",\n    " : "\n    ") << "{\"topology\": " << Json::quote(topologyName(result.topology))
+            << ", \"systems\": " << result.systems << ", \"flows\": " << result.flows << ", \"steps\": " << result.steps
+            << ", \"buildSeconds\": " << result.buildSeconds << ", \"runSeconds\": " << result.runSeconds
+            << ", \"stepsPerSecond\": " << result.stepsPerSecond << ", \"flowsPerSecond\": " << result.flowsPerSecond
+            << ", \"nanosecondsPerFlow\": " << result.nanosecondsPerFlow << ", \"peakKilobytes\": " << result.peakKilobytes << '}';
+    }
+    out << (results.empty() ? "]" : "\n  ]") << "\n}\n";
+    return out.str();
+}
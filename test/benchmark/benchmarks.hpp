@@ -0,0 +1,126 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+#include "../../src/Model.hpp"
+#include "../../src/FlowImpl.hpp"
+#include "../../src/System.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @class ExponentialFlow
+ * @brief Flow proportional to its source, evaluated by the engine as a linear flow.
+ * @details \f[ f = 0.01 \times source \f]
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class ExponentialFlow : public FlowHandle {
+    public:
+        ExponentialFlow(const std::string& name = "", System* source = nullptr, System* destination = nullptr)
+            : FlowHandle(name, source, destination) {}
+
+        double equation() const override {
+            return this->getSource() ? 0.01 * this->getSource()->getValue() : 0.0;
+        }
+
+        bool isLinear() const override { return true; }
+        double getRate() const override { return 0.01; }
+};
+
+/**
+ * @class LogisticFlow
+ * @brief Flow with a logistic law of its destination, evaluated by the engine as a generic flow.
+ * @details \f[ f = 0.01 \times destination \times \left(1 - \frac{destination}{70}\right) \f]
+ * @date 2026-10-18
+ * @version 0.1.0
+ */
+class LogisticFlow : public FlowHandle {
+    public:
+        LogisticFlow(const std::string& name = "", System* source = nullptr, System* destination = nullptr)
+            : FlowHandle(name, source, destination) {}
+
+        double equation() const override {
+            if (!this->getDestination()) {
+                return 0.0;
+            }
+            double destination = this->getDestination()->getValue();
+            return 0.01 * destination * (1 - destination / 70);
+        }
+};
+
+/**
+ * @brief Shape of a generated model.
+ */
+enum Topology {
+    CHAIN,      /**< Each system flows into the next one. */
+    STAR,       /**< Every system is connected to a single hub. */
+    RANDOM,     /**< Two flows per system between systems drawn at random. */
+    CLUSTERS    /**< Random flows inside independent groups of CLUSTER_SIZE systems. */
+};
+
+static constexpr size_t CLUSTER_SIZE = 100;     /**< Systems per group of the CLUSTERS topology. */
+
+/**
+ * @struct BenchmarkResult
+ * @brief Measurements of one generated model.
+ */
+struct BenchmarkResult {
+    Topology topology;
+    size_t systems = 0;
+    size_t flows = 0;
+    int steps = 0;
+    double buildSeconds = 0.0;          /**< Creating the systems and flows, and the first step, which builds the plan. */
+    double runSeconds = 0.0;            /**< Running the timed steps. */
+    double stepsPerSecond = 0.0;
+    double flowsPerSecond = 0.0;        /**< Flow evaluations per second. */
+    double nanosecondsPerFlow = 0.0;    /**< Time of a step divided by the number of flows. */
+    long peakKilobytes = 0;             /**< Peak resident memory of the process that ran this case alone. */
+};
+
+/**
+ * @brief Gets the name of a topology.
+ * @param topology The topology.
+ * @return The lowercase name used in the JSON output, e.g. `chain`.
+ */
+const char* topologyName(Topology topology);
+
+/**
+ * @brief Generates a model of a topology in the current model.
+ * @details The edges of the topology are drawn with Philox, so the same size always gives the same model.
+ * Seven flows in ten are ExponentialFlow, two LogisticFlow and one an expression flow with a custom law;
+ * logistic flows run against their edge, from the hub of the star to its spokes, so that no system
+ * drains exponentially into many others. Systems and the flows of each class are created in bulk.
+ * @param model The empty model to fill.
+ * @param topology The topology.
+ * @param numSystems The number of systems, at least 2.
+ * @return The number of flows created.
+ */
+size_t generateModel(Model* model, Topology topology, size_t numSystems);
+
+/**
+ * @brief Generates a model and measures its build and its steps.
+ * @details The case runs in a child process, so that its peak memory is its own and not the largest of the
+ * cases run before it. The pool of the caller is not used, and should not be started before the last case.
+ * @param topology The topology.
+ * @param numSystems The number of systems.
+ * @param steps The number of timed steps, or 0 to choose it from the number of flows.
+ * @param result Receives the measurements.
+ * @param error Receives a description of the problem when the case cannot run; may be null.
+ * @return True if the case ran.
+ */
+bool runBenchmark(Topology topology, size_t numSystems, int steps, BenchmarkResult* result, std::string* error = nullptr);
+
+/**
+ * @brief Formats measurements as JSON.
+ * @details An object with the `label` of the run, the number of `threads` of the pool and a `cases` array
+ * with `topology`, `systems`, `flows`, `steps`, `buildSeconds`, `runSeconds`, `stepsPerSecond`,
+ * `flowsPerSecond`, `nanosecondsPerFlow` and `peakKilobytes` for each result.
+ * @param results The measurements.
+ * @param label A free text identifying the run, such as a commit.
+ * @return The JSON text.
+ */
+std::string toJson(const std::vector<BenchmarkResult>& results, const std::string& label);
+
+#endif
@@ -0,0 +1,63 @@
+#include "benchmarks.hpp"
+#include "../../src/Json.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+// Usage: benchmarks [--min-systems N] [--max-systems N] [--steps N] [--label TEXT] [--output FILE]
+// Runs every topology at each power of ten of systems in [min, max] and prints the JSON, or writes it to FILE.
+int main(int argc, char* argv[]) {
+    size_t minSystems = 100;
+    size_t maxSystems = 100000;
+    int steps = 0;
+    std::string label;
+    std::string output;
+    for (int i = 1; i < argc; i += 2) {
+        std::string option = argv[i];
+        if (i + 1 == argc) {
+            std::cerr << "Missing value of " << option << std::endl;
+            return 1;
+        }
+        if (option == "--min-systems") {
+            minSystems = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (option == "--max-systems") {
+            maxSystems = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (option == "--steps") {
+            steps = std::atoi(argv[i + 1]);
+        } else if (option == "--label") {
+            label = argv[i + 1];
+        } else if (option == "--output") {
+            output = argv[i + 1];
+        } else {
+            std::cerr << "Unknown option " << option << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (size_t systems = std::max<size_t>(minSystems, 2); systems <= maxSystems; systems *= 10) {
+        for (Topology topology : {CHAIN, STAR, RANDOM, CLUSTERS}) {
+            BenchmarkResult result;
+            std::string error;
+            if (!runBenchmark(topology, systems, steps, &result, &error)) {
+                std::cerr << "Benchmark failed: " << error << std::endl;
+                return 1;
+            }
+            std::cerr << topologyName(topology) << " " << systems << ": " << result.flowsPerSecond << " flows/s, "
+                      << result.nanosecondsPerFlow << " ns/flow, built in " << result.buildSeconds << " s" << std::endl;
+            results.push_back(result);
+        }
+    }
+
+    std::string json = toJson(results, label);
+    if (output.empty()) {
+        std::cout << json;
+        return 0;
+    }
+    std::string error;
+    if (!Json::write(output, json, &error)) {
+        std::cerr << "Benchmark failed: " << error << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -4,6 +4,15 @@
 #include <cassert>
 #include <string>
 #include <cmath>
+#include <ranges>
+#include <algorithm>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 //Tests Implementation.
 void exponentialFlow() {
@@ -71,4 +80,1774 @@ void complexFlow() {
     Model::deleteModel();
 
     std::cout << "Complex Flow Test Passed!" << std::endl;
-}
\ No newline at end of file
+}
+
+void lazySteps() {
+    Model* model = Model::createModel("Lazy Steps");
+
+    System* population1 = model->createSystem("pop1", 100);
+    System* population2 = model->createSystem("pop2", 0);
+
+    model->createFlow<ExponentialFlow>("exponential", population1, population2);
+
+    int pulled = 0;
+    for (const StepView& view : model->steps(0, 100, 1) | std::views::take(10)) {
+        pulled++;
+        assert(view.time == pulled);
+        assert(view.values.size() == 2);
+        assert(view.values[0] == population1->getValue());
+    }
+    assert(pulled == 10);
+    assert(model->getCurrentTime() == 10);
+
+    population1->setValue(100);
+    population2->setValue(0);
+
+    Generator<StepView> steps = model->steps(0, 100, 1);
+    auto crossing = std::ranges::find_if(steps, [](const StepView& view) {
+        return view.values[1] > view.values[0];
+    });
+    assert(crossing != steps.end());
+    assert(crossing->time == 69);
+    assert(model->getCurrentTime() == 69);
+
+    Model::deleteModel();
+
+    std::cout << "Lazy Steps Test Passed!" << std::endl;
+}
+
+void steadyState() {
+    Model* model = Model::createModel("Steady State");
+
+    System* p1 = model->createSystem("p1", 100);
+    System* p2 = model->createSystem("p2", 10);
+
+    model->createFlow<LogisticFlow>("logistic", p1, p2);
+
+    SteadyState criteria;
+    criteria.tolerance = 1e-6;
+    criteria.steps = 5;
+    model->setSteadyState(criteria);
+
+    model->execute(0, 100000, 1);
+
+    int detectionTime = model->getSteadyStateTime();
+    assert(detectionTime > 0 && detectionTime < 100000);
+    assert(model->getCurrentTime() == detectionTime);
+    assert(fabs(p2->getValue() - 70) < 0.001);
+    assert(fabs(p1->getValue() - 40) < 0.001);
+
+    p1->setValue(100);
+    p2->setValue(10);
+    criteria.fastForward = true;
+    model->setSteadyState(criteria);
+
+    model->execute(0, 100000, 1);
+
+    assert(model->getSteadyStateTime() == detectionTime);
+    assert(model->getCurrentTime() == 100000);
+
+    model->setSteadyState(SteadyState());
+    model->execute(0, 100, 1);
+
+    assert(model->getSteadyStateTime() == -1);
+    assert(model->getCurrentTime() == 100);
+
+    Model::deleteModel();
+
+    std::cout << "Steady State Test Passed!" << std::endl;
+}
+
+void linearFastForward() {
+    Model* model = Model::createModel("Linear Fast Forward");
+
+    System* q1 = model->createSystem("Q1", 100);
+    System* q2 = model->createSystem("Q2", 0);
+    System* q3 = model->createSystem("Q3", 100);
+    System* q4 = model->createSystem("Q4", 0);
+    System* q5 = model->createSystem("Q5", 0);
+
+    model->createFlow<LinearFlow>("f", q1, q2)->setRate(0.01);
+    model->createFlow<LinearFlow>("g", q1, q3)->setRate(0.01);
+    model->createFlow<LinearFlow>("r", q2, q5)->setRate(0.01);
+    model->createFlow<LinearFlow>("t", q2, q3)->setRate(0.01);
+    model->createFlow<LinearFlow>("u", q3, q4)->setRate(0.01);
+    model->createFlow<LinearFlow>("v", q4, q1)->setRate(0.01);
+
+    assert(model->fastForward(0, 100, 1));
+    assert(model->getCurrentTime() == 100);
+
+    assert(fabs((round((q1->getValue() * 10000)) - 10000 * 31.8513)) < 0.0001);
+    assert(fabs((round((q2->getValue() * 10000)) - 10000 * 18.4003)) < 0.0001);
+    assert(fabs((round((q3->getValue() * 10000)) - 10000 * 77.1143)) < 0.0001);
+    assert(fabs((round((q4->getValue() * 10000)) - 10000 * 56.1728)) < 0.0001);
+    assert(fabs((round((q5->getValue() * 10000)) - 10000 * 16.4612)) < 0.0001);
+
+    Model::deleteModel();
+
+    model = Model::createModel("Long Linear Run");
+    System* stock = model->createSystem("stock", 100);
+    System* sink = model->createSystem("sink", 0);
+    Flow* decay = model->createFlow<LinearFlow>("decay", stock, sink);
+    ((LinearFlow*) decay)->setRate(1e-6);
+
+    assert(model->fastForward(0, 1000000, 1));
+    assert(fabs(stock->getValue() - 100 * pow(1 - 1e-6, 1000000)) < 1e-9);
+    assert(fabs(stock->getValue() + sink->getValue() - 100) < 1e-6);
+
+    Model::deleteModel();
+
+    model = Model::createModel("Non Linear Run");
+    System* p1 = model->createSystem("p1", 100);
+    System* p2 = model->createSystem("p2", 10);
+    model->createFlow<LogisticFlow>("logistic", p1, p2);
+
+    assert(!model->fastForward(0, 100, 1));
+    assert(fabs((round((p1->getValue() * 10000)) - 10000 * 88.2167)) < 0.0001);
+
+    Model::deleteModel();
+
+    std::cout << "Linear Fast Forward Test Passed!" << std::endl;
+}
+
+void mixedFlows() {
+    Model* model = Model::createModel("Mixed Flows");
+
+    const int numSystems = 40000;
+    std::vector<System*> systems;
+    std::vector<double> reference;
+    for (int i = 0; i < numSystems; i++) {
+        systems.push_back(model->createSystem("s" + std::to_string(i), i % 7));
+        reference.push_back(i % 7);
+    }
+    for (int i = 0; i + 1 < numSystems; i++) {
+        Flow* flow = model->createFlow<LinearFlow>("l" + std::to_string(i), systems[i], systems[i + 1]);
+        ((LinearFlow*) flow)->setRate(0.001 * (i % 5));
+    }
+    for (int i = 0; i + 2 < numSystems; i += 1000) {
+        model->createFlow<LogisticFlow>("g" + std::to_string(i), systems[i + 2], systems[i]);
+    }
+
+    for (int t = 0; t < 10; t++) {
+        std::vector<double> changes(numSystems, 0.0);
+        for (int i = 0; i + 1 < numSystems; i++) {
+            double value = 0.001 * (i % 5) * reference[i];
+            changes[i] -= value;
+            changes[i + 1] += value;
+        }
+        for (int i = 0; i + 2 < numSystems; i += 1000) {
+            double value = 0.01 * reference[i] * (1 - reference[i] / 70);
+            changes[i + 2] -= value;
+            changes[i] += value;
+        }
+        for (int i = 0; i < numSystems; i++) {
+            reference[i] += changes[i];
+        }
+    }
+
+    model->execute(0, 10, 1);
+
+    for (int i = 0; i < numSystems; i++) {
+        assert(fabs(systems[i]->getValue() - reference[i]) < 1e-9);
+    }
+
+    Model::deleteModel();
+
+    std::cout << "Mixed Flows Test Passed!" << std::endl;
+}
+
+void expressionFlow() {
+    Model* model = Model::createModel("Expression Flow");
+
+    System* p1 = model->createSystem("p1", 100);
+    System* p2 = model->createSystem("p2", 10);
+    model->setParameter("capacity", 70);
+
+    Flow* logistic = model->createFlow("logistic", p1, p2, "0.01 * dest * (1 - dest / capacity)");
+    assert(logistic != nullptr);
+    assert(fabs(logistic->equation() - 0.01 * 10 * (1 - 10.0 / 70)) < 1e-12);
+
+    model->execute(0, 100, 1);
+
+    assert(fabs((round((p1->getValue() * 10000)) - 10000 * 88.2167)) < 0.0001);
+    assert(fabs((round((p2->getValue() * 10000)) - 10000 * 21.7833)) < 0.0001);
+
+    // Expression flows are not part of the step matrix, so fastForward must step through them.
+    model->createFlow<LinearFlow>("drain", p1, p2)->setRate(0.01);
+    model->writeValues(std::vector<double>{100, 10});
+    model->execute(0, 100, 1);
+    std::vector<double> stepped(2);
+    model->readValues(stepped);
+    model->writeValues(std::vector<double>{100, 10});
+    assert(!model->fastForward(0, 100, 1));
+    assert(p1->getValue() == stepped[0] && p2->getValue() == stepped[1]);
+
+    Model::deleteModel();
+
+    model = Model::createModel("Expression Exponential Flow");
+    System* population1 = model->createSystem("pop1", 100);
+    System* population2 = model->createSystem("pop2", 0);
+    model->setParameter("rate", 0.01);
+    assert(model->createFlow("exponential", population1, population2, "rate * pop1") != nullptr);
+
+    model->execute(0, 100, 1);
+
+    assert(fabs((round((population1->getValue() * 10000)) - 10000 * 36.6032)) < 0.0001);
+    assert(fabs((round((population2->getValue() * 10000)) - 10000 * 63.3968)) < 0.0001);
+
+    model->setParameter("rate", 0);
+    model->execute(0, 10, 1);
+    assert(fabs((round((population1->getValue() * 10000)) - 10000 * 36.6032)) < 0.0001);
+    assert(model->getParameter("rate") == 0);
+
+    assert(model->createFlow("invalid", population1, population2, "0.01 * (source") == nullptr);
+    assert(model->createFlow("unknown", population1, population2, "0.01 * missing") == nullptr);
+    assert(model->createFlow("function", population1, population2, "min(1, max(source, 0)) ^ 2") != nullptr);
+
+    Model::deleteModel();
+
+    // Expressions edited after the plan linked them are bound and linked again before the next run.
+    model = Model::createModel("Edited Expression Flow");
+    System* a = model->createSystem("a", 100);
+    System* b = model->createSystem("b", 0);
+    ExpressionFlow* drain = static_cast<ExpressionFlow*>(model->createFlow("drain", a, b, "0.1 * source"));
+    model->execute(0, 1, 1);
+    assert(fabs(a->getValue() - 90) < 1e-12);
+    assert(drain->setExpression("0.5 * source"));
+    model->execute(0, 1, 1);
+    assert(fabs(a->getValue() - 45) < 1e-12 && fabs(b->getValue() - 55) < 1e-12);
+    model->setParameter("share", 0.2);
+    assert(drain->setExpression("share * b"));
+    model->execute(0, 1, 1);
+    assert(fabs(a->getValue() - 34) < 1e-12 && fabs(b->getValue() - 66) < 1e-12);
+
+    Model::deleteModel();
+
+    std::cout << "Expression Flow Test Passed!" << std::endl;
+}
+
+/// Builds the complex flow scenario with an additional logistic expression flow.
+static std::vector<System*> buildCompiledScenario(Model* model) {
+    System* q1 = model->createSystem("Q1", 100);
+    System* q2 = model->createSystem("Q2", 0);
+    System* q3 = model->createSystem("Q3", 100);
+    System* q4 = model->createSystem("Q4", 0);
+    System* q5 = model->createSystem("Q5", 10);
+
+    model->setParameter("capacity", 70);
+    model->createFlow<LinearFlow>("f", q1, q2)->setRate(0.01);
+    model->createFlow<LinearFlow>("g", q1, q3)->setRate(0.01);
+    model->createFlow<LinearFlow>("r", q2, q5)->setRate(0.01);
+    model->createFlow<LinearFlow>("t", q2, q3)->setRate(0.01);
+    model->createFlow<LinearFlow>("u", q3, q4)->setRate(0.01);
+    model->createFlow<LinearFlow>("v", q4, q1)->setRate(0.01);
+    model->createFlow("logistic", q4, q5, "0.01 * dest * (1 - dest / capacity) + 0.001 * sqrt(Q1)");
+
+    return {q1, q2, q3, q4, q5};
+}
+
+void compiledStep() {
+    Model* model = Model::createModel("Generic Step");
+    std::vector<System*> generic = buildCompiledScenario(model);
+    model->execute(0, 1000, 1);
+    std::vector<double> expected;
+    for (System* system : generic) {
+        expected.push_back(system->getValue());
+    }
+    Model::deleteModel();
+
+    model = Model::createModel("Compiled Step");
+    std::vector<System*> compiled = buildCompiledScenario(model);
+    // Paths are quoted for the shell, and the generated files are removed once loaded.
+    std::filesystem::path directory = "/tmp/compiled step's";
+    std::filesystem::create_directory(directory);
+    assert(model->compile(directory.string()));
+    assert(std::filesystem::is_empty(directory));
+    std::filesystem::remove(directory);
+    model->execute(0, 1000, 1);
+    for (size_t i = 0; i < compiled.size(); i++) {
+        assert(fabs(compiled[i]->getValue() - expected[i]) <= 1e-9 * fabs(expected[i]));
+    }
+
+    // An edited expression discards the compiled step, whose code still holds the previous one.
+    ExpressionFlow* logistic = nullptr;
+    for (auto it = model->beginFlows(); it != model->endFlows(); ++it) {
+        if ((*it)->getName() == "logistic") {
+            logistic = static_cast<ExpressionFlow*>(*it);
+        }
+    }
+    assert(logistic->setExpression("0.5 * source"));
+    model->writeValues(std::vector<double>{0, 0, 0, 100, 0});
+    model->execute(0, 1, 1);
+    assert(fabs(compiled[3]->getValue() - 49) < 1e-12 && fabs(compiled[4]->getValue() - 50) < 1e-12);
+
+    model->createFlow<LogisticFlow>("logistic C++", compiled[0], compiled[1]);
+    assert(!model->compile("/tmp"));
+
+    Model::deleteModel();
+
+    std::cout << "Compiled Step Test Passed!" << std::endl;
+}
+
+void staticModels() {
+    StaticModel<2, StaticFlow<ExponentialLaw, 0, 1>> exponential({100, 0});
+    exponential.execute(0, 100, 1);
+
+    assert(fabs((round((exponential.getValue(0) * 10000)) - 10000 * 36.6032)) < 0.0001);
+    assert(fabs((round((exponential.getValue(1) * 10000)) - 10000 * 63.3968)) < 0.0001);
+
+    constexpr double afterOneStep = [] {
+        StaticModel<2, StaticFlow<ExponentialLaw, 0, 1>> model({100, 0});
+        model.step();
+        return model.getValue(1);
+    }();
+    static_assert(afterOneStep == 1.0);
+
+    StaticModel<2, StaticFlow<LogisticLaw, 0, 1>> logistic({100, 10});
+    logistic.execute(0, 100, 1);
+
+    assert(fabs((round((logistic.getValue(0) * 10000)) - 10000 * 88.2167)) < 0.0001);
+    assert(fabs((round((logistic.getValue(1) * 10000)) - 10000 * 21.7833)) < 0.0001);
+
+    using ComplexModel = StaticModel<5,
+        StaticFlow<ExponentialLaw, 0, 1>, StaticFlow<ExponentialLaw, 0, 2>, StaticFlow<ExponentialLaw, 1, 4>,
+        StaticFlow<ExponentialLaw, 1, 2>, StaticFlow<ExponentialLaw, 2, 3>, StaticFlow<ExponentialLaw, 3, 0>>;
+    ComplexModel complex({100, 0, 100, 0, 0});
+
+    Model* model = Model::createModel("Static Complex Flow");
+    std::array<System*, 5> systems = complex.toModel(model, {"Q1", "Q2", "Q3", "Q4", "Q5"});
+
+    complex.execute(0, 100, 1);
+    model->execute(0, 100, 1);
+
+    const double expected[] = {31.8513, 18.4003, 77.1143, 56.1728, 16.4612};
+    for (size_t i = 0; i < 5; i++) {
+        assert(fabs((round((complex.getValue(i) * 10000)) - 10000 * expected[i])) < 0.0001);
+        assert(fabs(systems[i]->getValue() - complex.getValue(i)) < 1e-9);
+    }
+
+    Model::deleteModel();
+
+    std::cout << "Static Models Test Passed!" << std::endl;
+}
+
+void modelFile() {
+    FlowRegistry::add<ExponentialFlow>("exponential");
+
+    const char* path = "/tmp/complexFlow.model";
+    std::ofstream file(path);
+    file << "# Complex flow scenario\n"
+         << "model \"Complex Flow\"\n"
+         << "parameter rate 0.01\n"
+         << "system Q1 100\n"
+         << "system Q2 0\n"
+         << "system Q3 100\n"
+         << "system Q4 0\n"
+         << "system Q5 0\n"
+         << "\n"
+         << "flow f Q1 Q2 linear 0.01\n"
+         << "flow g Q1 Q3 exponential\n"
+         << "flow r Q2 Q5 expression rate * source\n"
+         << "flow t Q2 Q3 expression 0.01 * Q2\n"
+         << "flow u Q3 Q4 linear 1e-2\n"
+         << "flow \"v flow\" Q4 Q1 exponential\n";
+    file.close();
+
+    Model* model = Model::createModel("");
+    string error;
+    assert(ModelLoader::load(model, path, &error));
+    assert(model->getName() == "Complex Flow");
+    std::remove(path);
+
+    std::vector<double> values;
+    for (const StepView& view : model->steps(0, 100, 1)) {
+        values.assign(view.values.begin(), view.values.end());
+    }
+
+    const double expected[] = {31.8513, 18.4003, 77.1143, 56.1728, 16.4612};
+    assert(values.size() == 5);
+    for (size_t i = 0; i < 5; i++) {
+        assert(fabs((round((values[i] * 10000)) - 10000 * expected[i])) < 0.0001);
+    }
+
+    Model::deleteModel();
+
+    model = Model::createModel("");
+    assert(!ModelLoader::parse(model, "system A 1\nflow f A B linear 0.1\n", &error));
+    assert(error.find("line 2") == 0);
+    assert(!ModelLoader::parse(model, "system B x\n", &error));
+    assert(!ModelLoader::parse(model, "system C 1\nflow f C C unknownType\n", &error));
+    assert(error.find("unknown flow type") != string::npos);
+    assert(!ModelLoader::parse(model, "stock D 1\n", &error));
+    assert(!ModelLoader::parse(model, "# quoted\n\"system E 1\n", &error));
+    assert(error == "line 2: unterminated quote");
+    assert(!ModelLoader::parse(model, "system \"F 1\n", &error) && error == "line 1: unterminated quote");
+    assert(!ModelLoader::parse(model, "\"\" G 1\n", &error) && error.find("unknown declaration") != string::npos);
+    assert(!ModelLoader::load(model, "/tmp/missing.model", &error));
+    Model::deleteModel();
+
+    std::cout << "Model File Test Passed!" << std::endl;
+}
+void modelSnapshot() {
+    FlowRegistry::add<ExponentialFlow>("exponential");
+    const char* path = "/tmp/complexFlow.snapshot";
+
+    Model* model = Model::createModel("");
+    model->setName("Snapshot");
+    model->setParameter("capacity", 70);
+    System* q1 = model->createSystem("Q1", 100);
+    System* q2 = model->createSystem("Q2", 10);
+    System* q3 = model->createSystem("Q3", 50);
+    model->createFlow<LinearFlow>("f", q1, q2)->setRate(0.02);
+    model->createFlow("g", q2, q3, "0.01 * dest * (1 - dest / capacity)");
+    model->createFlow<ExponentialFlow>("h", q3, q1);
+    model->createFlow<LinearFlow>("sink", q1, nullptr)->setRate(0.001);
+
+    model->execute(0, 50, 1);
+    string error;
+    assert(ModelSnapshot::save(model, path, &error));
+    std::vector<double> saved = {q1->getValue(), q2->getValue(), q3->getValue()};
+    model->execute(50, 100, 1);
+    std::vector<double> expected = {q1->getValue(), q2->getValue(), q3->getValue()};
+    Model::deleteModel();
+
+    model = Model::createModel("");
+    assert(ModelSnapshot::load(model, path, &error));
+    assert(model->getName() == "Snapshot");
+    assert(model->getCurrentTime() == 50);
+    assert(model->getParameter("capacity") == 70);
+    assert(std::distance(model->beginFlows(), model->endFlows()) == 4);
+    std::vector<System*> systems(model->beginSystems(), model->endSystems());
+    assert(systems.size() == 3 && systems[1]->getName() == "Q2");
+    for (size_t i = 0; i < 3; i++) {
+        assert(systems[i]->getValue() == saved[i]);
+    }
+
+    model->execute(50, 100, 1);
+    for (size_t i = 0; i < 3; i++) {
+        assert(systems[i]->getValue() == expected[i]);
+    }
+    Model::deleteModel();
+
+    // Flip one byte of the body, then of the current time in the header: the checksum must catch both
+    // before anything is created.
+    auto flip = [path](std::streamoff offset) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(offset);
+        char byte = char(file.get() ^ 0x20);
+        file.seekp(offset);
+        file.put(byte);
+    };
+    model = Model::createModel("");
+    model->setCurrentTime(0);
+    for (std::streamoff offset : {200, 24}) {
+        flip(offset);
+        assert(!ModelSnapshot::load(model, path, &error));
+        assert(error.find("checksum") != string::npos);
+        assert(model->beginSystems() == model->endSystems() && model->getCurrentTime() == 0);
+        flip(offset);
+    }
+    assert(ModelSnapshot::load(model, path, &error));
+    Model::deleteModel();
+
+    // Registered flows deriving from LinearFlow keep their rate; registered flows with other state are refused.
+    struct RatedFlow : LinearFlow {
+        using LinearFlow::LinearFlow;
+    };
+    struct NoisyFlow : StochasticFlow {
+        using StochasticFlow::StochasticFlow;
+    };
+    FlowRegistry::add<RatedFlow>("rated");
+    FlowRegistry::add<NoisyFlow>("noisy");
+    model = Model::createModel("");
+    System* a = model->createSystem("a", 100);
+    System* b = model->createSystem("b", 0);
+    model->createFlow<RatedFlow>("rated", a, b)->setRate(0.25);
+    assert(ModelSnapshot::save(model, path, &error));
+    Model::deleteModel();
+    model = Model::createModel("");
+    assert(ModelSnapshot::load(model, path, &error));
+    model->execute(0, 1, 1);
+    systems.assign(model->beginSystems(), model->endSystems());
+    assert(systems[0]->getValue() == 75 && systems[1]->getValue() == 25);
+    model->createFlow<NoisyFlow>("noisy", systems[0], systems[1])->setNoise(1.0, 0.5);
+    assert(!ModelSnapshot::save(model, path, &error) && error.find("noisy") != string::npos);
+    Model::deleteModel();
+
+    model = Model::createModel("");
+    std::remove(path);
+
+    std::ofstream(path) << "system A 1\n";
+    assert(!ModelSnapshot::load(model, path, &error));
+    std::remove(path);
+    assert(!ModelSnapshot::load(model, "/tmp/missing.snapshot", &error));
+    Model::deleteModel();
+
+    std::cout << "Model Snapshot Test Passed!" << std::endl;
+}
+
+void bulkCreation() {
+    const size_t numSystems = 20000;
+    std::vector<string> systemNames(numSystems), flowNames(numSystems - 1);
+    std::vector<double> values(numSystems);
+    for (size_t i = 0; i < numSystems; i++) {
+        systemNames[i] = "S" + std::to_string(i);
+        values[i] = double(i % 100);
+    }
+    for (size_t i = 0; i + 1 < numSystems; i++) {
+        flowNames[i] = "F" + std::to_string(i);
+    }
+
+    Model* model = Model::createModel("");
+    model->reserve(numSystems, numSystems - 1);
+    std::vector<System*> systems = model->createSystems(systemNames, values);
+    assert(systems.size() == numSystems);
+    std::vector<System*> sources(systems.begin(), systems.end() - 1), destinations(systems.begin() + 1, systems.end());
+    std::vector<LinearFlow*> flows = model->createFlows<LinearFlow>(flowNames, sources, destinations);
+    assert(flows.size() == numSystems - 1);
+    for (size_t i = 0; i < flows.size(); i++) {
+        assert(flows[i]->getName() == flowNames[i] && flows[i]->getSource() == systems[i]);
+        flows[i]->setRate(0.01 + 0.001 * double(i % 7));
+    }
+    assert(*(model->beginSystems() + 123) == systems[123]);
+    assert(model->createSystems(systemNames, std::span<const double>(values).first(10)).empty());
+    assert(std::distance(model->beginSystems(), model->endSystems()) == std::ptrdiff_t(numSystems));
+
+    model->execute(0, 50, 1);
+    std::vector<double> bulkValues;
+    for (System* system : systems) {
+        bulkValues.push_back(system->getValue());
+    }
+    Model::deleteModel();
+
+    model = Model::createModel("");
+    systems.clear();
+    for (size_t i = 0; i < numSystems; i++) {
+        systems.push_back(model->createSystem(systemNames[i], values[i]));
+    }
+    for (size_t i = 0; i + 1 < numSystems; i++) {
+        model->createFlow<LinearFlow>(flowNames[i], systems[i], systems[i + 1])->setRate(0.01 + 0.001 * double(i % 7));
+    }
+    model->execute(0, 50, 1);
+    for (size_t i = 0; i < numSystems; i++) {
+        assert(systems[i]->getValue() == bulkValues[i]);
+    }
+    Model::deleteModel();
+
+    std::cout << "Bulk Creation Test Passed!" << std::endl;
+}
+
+void bulkValues() {
+    Model* model = Model::createModel("");
+    System* q1 = model->createSystem("Q1", 100);
+    System* q2 = model->createSystem("Q2", 0);
+    System* q3 = model->createSystem("Q3", 100);
+    model->createFlow<ExponentialFlow>("f", q1, q2);
+    model->createFlow<LogisticFlow>("g", q2, q3);
+
+    std::vector<double> initial(model->getNumSystems());
+    assert(model->readValues(initial));
+    assert(initial[0] == 100 && initial[1] == 0 && initial[2] == 100);
+
+    model->execute(0, 100, 1);
+    std::vector<double> first(3);
+    assert(model->readValues(first));
+    assert(first[1] == q2->getValue());
+
+    assert(model->writeValues(initial));
+    assert(q1->getValue() == 100 && q2->getValue() == 0);
+    model->execute(0, 100, 1);
+    std::vector<double> second(3);
+    assert(model->readValues(second));
+    assert(first == second);
+
+    std::vector<string> names = {"Q3", "missing", "Q1"};
+    std::vector<size_t> indices = model->getSystemIndices(names);
+    assert(indices[0] == 2 && indices[1] == Model::NO_SYSTEM && indices[2] == 0);
+    indices.erase(indices.begin() + 1);
+    std::vector<double> some = {1, 2};
+    assert(model->writeValues(indices, some));
+    assert(q3->getValue() == 1 && q1->getValue() == 2);
+    std::vector<double> readBack(2);
+    assert(model->readValues(indices, readBack) && readBack == some);
+
+    std::vector<double> wrongSize(2);
+    assert(!model->readValues(wrongSize));
+    assert(!model->writeValues(wrongSize));
+    std::vector<size_t> outOfRange = {0, 3};
+    assert(!model->writeValues(outOfRange, some));
+    assert(q1->getValue() == 2);
+    Model::deleteModel();
+
+    std::cout << "Bulk Values Test Passed!" << std::endl;
+}
+
+void modelFork() {
+    Model* model = Model::createModel("");
+    model->setParameter("capacity", 70);
+    System* q1 = model->createSystem("Q1", 100);
+    System* q2 = model->createSystem("Q2", 10);
+    System* q3 = model->createSystem("Q3", 0);
+    model->createFlow<LinearFlow>("f", q1, q2)->setRate(0.02);
+    model->createFlow("g", q2, q3, "0.01 * dest * (1 - dest / capacity) + 0.001 * source");
+    model->execute(0, 50, 1);
+
+    std::vector<double> warm(3);
+    assert(model->readValues(warm));
+
+    // What-if variants branched from the warmed-up state, run concurrently.
+    const double capacities[] = {70, 50, 90, 120};
+    std::vector<Model*> forks;
+    for (double capacity : capacities) {
+        Model* fork = model->fork();
+        assert(fork->getCurrentTime() == 50 && fork->getParameter("capacity") == 70);
+        fork->setParameter("capacity", capacity);
+        forks.push_back(fork);
+    }
+    std::vector<std::thread> threads;
+    for (Model* fork : forks) {
+        threads.emplace_back([fork] { fork->execute(50, 100, 1); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    // The original kept its values and parameters, and its systems were never touched by the forks.
+    assert(model->getParameter("capacity") == 70);
+    assert(q1->getValue() == warm[0] && q2->getValue() == warm[1] && q3->getValue() == warm[2]);
+
+    std::vector<std::vector<double>> results(forks.size(), std::vector<double>(3));
+    for (size_t i = 0; i < forks.size(); i++) {
+        assert(forks[i]->readValues(results[i]));
+        assert(forks[i]->getCurrentTime() == 100);
+    }
+    model->execute(50, 100, 1);
+    std::vector<double> original(3);
+    assert(model->readValues(original));
+    assert(results[0] == original);
+    assert(results[1] != original && results[2] != results[1]);
+
+    // A snapshot of a fork holds the values and parameters of the fork, not those of the shared systems.
+    const char* snapshot = "/tmp/fork.snapshot";
+    assert(ModelSnapshot::save(forks[1], snapshot));
+
+    Model* sequential = model->fork();
+    sequential->setCurrentTime(50);
+    assert(sequential->writeValues(warm));
+    sequential->setParameter("capacity", capacities[3]);
+    sequential->execute(50, 100, 1);
+    std::vector<double> sequentialValues(3);
+    assert(sequential->readValues(sequentialValues) && sequentialValues == results[3]);
+    delete sequential;
+
+    // Copy-on-write: topology changes of a fork stay in the fork.
+    Model* edited = forks[0]->fork();
+    System* q4 = edited->createSystem("Q4", 5);
+    edited->createFlow<LinearFlow>("h", q3, q4)->setRate(0.1);
+    Flow* f = *edited->beginFlows();
+    assert(edited->deleteFlow(f));
+    assert(edited->getNumSystems() == 4 && model->getNumSystems() == 3);
+    assert(std::distance(model->beginFlows(), model->endFlows()) == 2);
+    assert(*model->beginFlows() == f && f->getName() == "f");
+    edited->execute(100, 110, 1);
+    std::vector<double> editedValues(4);
+    assert(edited->readValues(editedValues));
+    assert(editedValues[0] == results[0][0] && editedValues[3] > 5);
+    delete edited;
+
+    model->execute(100, 110, 1);
+    assert(q1->getValue() < original[0]);
+
+    // A fork running generic flows lends its values to the shared systems and gives them back.
+    model->createFlow<LogisticFlow>("l", q1, q3);
+    Model* generic = model->fork();
+    std::vector<double> before(3);
+    assert(model->readValues(before));
+    generic->execute(110, 150, 1);
+    std::vector<double> after(3);
+    assert(model->readValues(after) && after == before);
+    std::vector<double> genericValues(3);
+    assert(generic->readValues(genericValues) && genericValues != before);
+    for (const StepView& view : generic->steps(150, 200, 1)) {
+        if (view.time == 160) {
+            break;
+        }
+    }
+    assert(model->readValues(after) && after == before);
+    delete generic;
+
+    for (Model* fork : forks) {
+        delete fork;
+    }
+    Model::deleteModel();
+
+    model = Model::createModel("");
+    assert(ModelSnapshot::load(model, snapshot));
+    std::vector<double> restored(3);
+    assert(model->readValues(restored) && restored == results[1]);
+    assert(model->getCurrentTime() == 100 && model->getParameter("capacity") == capacities[1]);
+    std::remove(snapshot);
+    Model::deleteModel();
+
+    // An expression evaluated by a generic flow reads the parameters of the fork that runs it, and stays 
+    // valid once the model that created it is deleted.
+    struct MirrorFlow : FlowHandle {
+        using FlowHandle::FlowHandle;
+        Flow* mirrored = nullptr;
+        double equation() const override { return mirrored->equation(); }
+    };
+    model = Model::createModel("");
+    model->setParameter("k", 0.1);
+    System* a = model->createSystem("a", 100);
+    System* b = model->createSystem("b", 0);
+    Flow* expression = model->createFlow("expression", a, b, "k * source");
+    model->createFlow<MirrorFlow>("mirror", model->createSystem("c", 100), model->createSystem("d", 0))->mirrored = expression;
+    Model* mirrorFork = model->fork();
+    mirrorFork->setParameter("k", 0.5);
+    mirrorFork->execute(0, 1, 1);
+    std::vector<double> mirrored(4);
+    assert(mirrorFork->readValues(mirrored) && mirrored[0] == 50 && mirrored[2] == 50);
+    assert(expression->equation() == 10);
+    Model::deleteModel();
+    assert(expression->equation() == 10);
+    delete mirrorFork;
+
+    std::cout << "Model Fork Test Passed!" << std::endl;
+}
+
+void stagedEdits() {
+    auto build = [](Model* model) {
+        model->setParameter("rate", 0.01);
+        System* q1 = model->createSystem("Q1", 100);
+        System* q2 = model->createSystem("Q2", 10);
+        System* q3 = model->createSystem("Q3", 0);
+        model->createFlow<LinearFlow>("f", q1, q2)->setRate(0.02);
+        model->createFlow<LinearFlow>("g", q2, q3)->setRate(0.03);
+        model->createFlow<LogisticFlow>("l", q1, q3);
+    };
+    auto edit = [](Model* model) {
+        std::vector<Flow*> flows(model->beginFlows(), model->endFlows());
+        std::vector<System*> systems(model->beginSystems(), model->endSystems());
+        model->deleteFlow(flows[0]);
+        model->createFlow("r", systems[2], systems[0], "rate * source");
+        model->setParameter("rate", 0.05);
+    };
+
+    // Reference: the edits are made between two runs.
+    Model* model = Model::createModel("");
+    build(model);
+    model->execute(0, 50, 1);
+    edit(model);
+    model->execute(50, 100, 1);
+    std::vector<double> expected(3);
+    model->readValues(expected);
+    Model::deleteModel();
+
+    // The same edits, staged by another thread while the run is paused at time 50.
+    model = Model::createModel("");
+    build(model);
+    std::vector<double> values;
+    for (const StepView& view : model->steps(0, 100, 1)) {
+        if (view.time == 50) {
+            std::thread([model, edit] { model->stageEdit(edit); }).join();
+            assert(std::distance(model->beginFlows(), model->endFlows()) == 3);
+        }
+        values.assign(view.values.begin(), view.values.end());
+    }
+    for (size_t i = 0; i < 3; i++) {
+        assert(fabs(values[i] - expected[i]) < 1e-12);
+    }
+    assert(model->getParameter("rate") == 0.05);
+
+    // Edits staged concurrently are all applied, each thread's in order.
+    model->setParameter("counter", 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([model, t] {
+            for (int i = 0; i < 100; i++) {
+                model->stageEdit([t, i](Model* model) {
+                    string name = "last" + std::to_string(t);
+                    assert(model->getParameter(name) == i - 1 || (i == 0 && model->getParameter(name) == 0));
+                    model->setParameter(name, i);
+                    model->setParameter("counter", model->getParameter("counter") + 1);
+                });
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    assert(model->applyStagedEdits() == 400);
+    assert(model->getParameter("counter") == 400);
+    assert(model->applyStagedEdits() == 0);
+    Model::deleteModel();
+
+    std::cout << "Staged Edits Test Passed!" << std::endl;
+}
+
+void scheduledEvents() {
+    struct Scenario { System* q1; System* q2; System* q3; Flow* f; };
+    auto build = [](Model* model) {
+        model->setParameter("rate", 0.05);
+        Scenario scenario;
+        scenario.q1 = model->createSystem("Q1", 100);
+        scenario.q2 = model->createSystem("Q2", 0);
+        scenario.q3 = model->createSystem("Q3", 0);
+        scenario.f = model->createFlow<LinearFlow>("f", scenario.q1, scenario.q2);
+        ((LinearFlow*) scenario.f)->setRate(0.1);
+        model->createFlow("g", scenario.q2, scenario.q3, "rate * source");
+        return scenario;
+    };
+
+    // Reference: the run is split at every event.
+    Model* model = Model::createModel("");
+    Scenario split = build(model);
+    split.q2->setValue(5);
+    model->execute(0, 10, 1);
+    split.q1->setValue(split.q1->getValue() + 50);
+    model->execute(10, 20, 1);
+    model->setFlowEnabled(split.f, false);
+    model->execute(20, 25, 1);
+    model->setParameter("rate", 0.5);
+    model->execute(25, 30, 1);
+    model->setFlowEnabled(split.f, true);
+    model->execute(30, 40, 1);
+    split.q3->setValue(0);
+    model->execute(40, 60, 1);
+    std::vector<double> expected(3);
+    model->readValues(expected);
+    Model::deleteModel();
+
+    // The same changes as events of one run, scheduled out of order.
+    model = Model::createModel("");
+    Scenario scenario = build(model);
+    model->schedule({.time = 40, .kind = Event::SET_VALUE, .system = scenario.q3, .value = 0});
+    model->schedule({.time = 20, .kind = Event::DISABLE_FLOW, .flow = scenario.f});
+    model->schedule({.time = 10, .kind = Event::IMPULSE, .system = scenario.q1, .value = 50});
+    model->schedule({.time = 30, .kind = Event::ENABLE_FLOW, .flow = scenario.f});
+    model->schedule({.time = 25, .kind = Event::SET_PARAMETER, .parameter = "rate", .value = 0.5});
+    model->schedule({.time = -5, .kind = Event::SET_VALUE, .system = scenario.q2, .value = 5});
+    assert(!model->fastForward(0, 60, 1));
+    std::vector<double> values(3);
+    model->readValues(values);
+    assert(values == expected);
+
+    // Values reported for the time of an event include it.
+    model->schedule({.time = 65, .kind = Event::IMPULSE, .system = scenario.q3, .value = 1000});
+    for (const StepView& view : model->steps(60, 70, 1)) {
+        assert((view.time >= 65) == (view.values[2] > 1000));
+    }
+
+    // Steady state does not end a run before its events.
+    model->setSteadyState({1e-3, 2});
+    model->setFlowEnabled(scenario.f, false);
+    model->setParameter("rate", 0);
+    model->schedule({.time = 90, .kind = Event::SET_PARAMETER, .parameter = "rate", .value = 0.1});
+    model->execute(70, 100, 1);
+    assert(model->getParameter("rate") == 0.1);
+    assert(model->getSteadyStateTime() == -1 || model->getSteadyStateTime() > 91);
+    model->clearEvents();
+    model->schedule({.time = 150, .kind = Event::IMPULSE, .system = scenario.q1, .value = 1});
+    model->clearEvents();
+    model->setParameter("rate", 0);
+    model->execute(100, 200, 1);
+    assert(model->getSteadyStateTime() == 102);
+    Model::deleteModel();
+
+    std::cout << "Scheduled Events Test Passed!" << std::endl;
+}
+
+void delayFlows() {
+    Model* model = Model::createModel("");
+    System* orders = model->createSystem("orders", 100);
+    System* received = model->createSystem("received", 0);
+    DelayFlow* shipping = model->createFlow<DelayFlow>("shipping", orders, received);
+    shipping->setRate(0.1);
+    assert(!shipping->setDelay(0));
+    assert(!shipping->setDelay(2, DelayFlow::EXPONENTIAL, 3));
+    assert(shipping->setDelay(5));
+
+    // Nothing arrives before the delay has elapsed, then the first entry arrives whole.
+    model->execute(0, 5, 1);
+    assert(received->getValue() == 0);
+    assert(fabs(orders->getValue() + shipping->getInTransit() - 100) < 1e-9);
+    model->execute(5, 6, 1);
+    assert(fabs(received->getValue() - 10) < 1e-12);
+
+    // Runs split at any time, and forks, end like a single run.
+    for (const StepView& view : model->steps(6, 20, 1)) {
+        assert(view.values[1] > 0);
+    }
+    assert(fabs(orders->getValue() + received->getValue() + shipping->getInTransit() - 100) < 1e-9);
+    Model* fork = model->fork();
+    std::vector<double> inTransit = shipping->getContents();
+    fork->execute(20, 40, 1);
+    assert(shipping->getContents() == inTransit);
+    model->execute(20, 40, 1);
+    std::vector<double> forkValues(2), values(2);
+    fork->readValues(forkValues);
+    model->readValues(values);
+    assert(forkValues == values);
+    delete fork;
+
+    orders->setValue(100);
+    received->setValue(0);
+    shipping->setDelay(5);
+    model->execute(0, 40, 1);
+    model->readValues(forkValues);
+    assert(fabs(forkValues[0] - values[0]) < 1e-12 && fabs(forkValues[1] - values[1]) < 1e-12);
+    Model::deleteModel();
+
+    // A DELAY3 of 6 steps drains each of its three stages at 3 / 6 per step, like a chain of stocks.
+    model = Model::createModel("");
+    System* source = model->createSystem("source", 100);
+    System* destination = model->createSystem("destination", 0);
+    DelayFlow* delay = model->createFlow<DelayFlow>("delay", source, destination);
+    delay->setRate(0.2);
+    assert(delay->setDelay(6, DelayFlow::EXPONENTIAL, 3));
+
+    System* chainSource = model->createSystem("chainSource", 100);
+    System* previous = chainSource;
+    std::vector<System*> stages;
+    for (int i = 0; i < 3; i++) {
+        stages.push_back(model->createSystem("stage" + std::to_string(i), 0));
+        model->createFlow<LinearFlow>("chain" + std::to_string(i), previous, stages.back())->setRate(i == 0 ? 0.2 : 0.5);
+        previous = stages.back();
+    }
+    System* chainDestination = model->createSystem("chainDestination", 0);
+    model->createFlow<LinearFlow>("chainOut", previous, chainDestination)->setRate(0.5);
+
+    model->execute(0, 30, 1);
+    assert(fabs(source->getValue() - chainSource->getValue()) < 1e-9);
+    assert(fabs(destination->getValue() - chainDestination->getValue()) < 1e-9);
+    for (int i = 0; i < 3; i++) {
+        assert(fabs(delay->getContents()[i] - stages[i]->getValue()) < 1e-9);
+    }
+    assert(fabs(source->getValue() + destination->getValue() + delay->getInTransit() - 100) < 1e-9);
+    assert(!model->fastForward(30, 40, 1));
+    Model::deleteModel();
+
+    std::cout << "Delay Flows Test Passed!" << std::endl;
+}
+
+void lookupTables() {
+    std::vector<double> uniformXs = {0, 1, 2, 3, 4};
+    std::vector<double> unevenXs = {0, 0.5, 2, 3.5, 4};
+    std::vector<double> ys = {0, 0.1, 1, 1.8, 2};
+
+    LookupTable empty;
+    assert(empty(1) == 0);
+    assert(!empty.set(uniformXs, std::vector<double>{1, 2}));
+    assert(!empty.set(std::vector<double>{0, 1, 1}, std::vector<double>{0, 1, 2}));
+    assert(empty.size() == 0);
+
+    for (std::vector<double>* xs : {&uniformXs, &unevenXs}) {
+        for (LookupTable::Interpolation interpolation : {LookupTable::LINEAR, LookupTable::MONOTONE_CUBIC}) {
+            LookupTable table;
+            assert(table.set(*xs, ys, interpolation));
+            assert(table.isUniform() == (xs == &uniformXs));
+            for (size_t i = 0; i < xs->size(); i++) {
+                assert(fabs(table((*xs)[i]) - ys[i]) < 1e-12);
+            }
+            assert(table(-10) == 0 && table(10) == 2);
+
+            std::vector<double> inputs, outputs(1001);
+            for (int k = 0; k <= 1000; k++) {
+                inputs.push_back(-0.5 + 5.0 * k / 1000);
+            }
+            table.evaluate(inputs, outputs);
+            for (size_t k = 0; k < inputs.size(); k++) {
+                assert(outputs[k] == table(inputs[k]));
+                assert(k == 0 || outputs[k] >= outputs[k - 1]);
+                assert(outputs[k] >= 0 && outputs[k] <= 2);
+            }
+        }
+    }
+
+    // A straight line through its breakpoints: the lookup flows are linear flows of rate 0.1.
+    LookupTable line;
+    line.set(std::vector<double>{0, 50, 100, 150, 200}, std::vector<double>{0, 5, 10, 15, 20});
+
+    Model* model = Model::createModel("");
+    std::vector<System*> lookupSystems, linearSystems;
+    for (int i = 0; i < 1000; i++) {
+        lookupSystems.push_back(model->createSystem("lookup" + std::to_string(i), 100 + i % 50));
+        linearSystems.push_back(model->createSystem("linear" + std::to_string(i), 100 + i % 50));
+    }
+    System* lookupSink = model->createSystem("lookupSink", 0);
+    System* linearSink = model->createSystem("linearSink", 0);
+    for (int i = 0; i < 1000; i++) {
+        LookupFlow* flow = model->createFlow<LookupFlow>("l" + std::to_string(i), lookupSystems[i], lookupSink);
+        flow->setTable(line);
+        assert(flow->getTable().shares(line));
+        model->createFlow<LinearFlow>("f" + std::to_string(i), linearSystems[i], linearSink)->setRate(0.1);
+    }
+    model->execute(0, 50, 1);
+    assert(fabs(lookupSink->getValue() - linearSink->getValue()) < 1e-6);
+    for (int i = 0; i < 1000; i += 97) {
+        assert(fabs(lookupSystems[i]->getValue() - linearSystems[i]->getValue()) < 1e-9);
+    }
+
+    // Changing the shared breakpoints changes every flow; the model picks them up at the next run.
+    line.set(std::vector<double>{0, 200}, std::vector<double>{0, 0});
+    double sink = lookupSink->getValue();
+    model->execute(50, 60, 1);
+    assert(lookupSink->getValue() == sink);
+    Model::deleteModel();
+
+    std::cout << "Lookup Tables Test Passed!" << std::endl;
+}
+
+void timeSeriesInputs() {
+    std::vector<double> times, values;
+    for (int i = 0; i <= 100; i++) {
+        times.push_back(2.5 * i);
+        values.push_back(50 + 40 * std::sin(0.3 * i));
+    }
+    const string binaryPath = "/tmp/time_series_test.bin";
+    const string csvPath = "/tmp/time_series_test.csv";
+    assert(TimeSeries::writeBinary(binaryPath, times, values));
+    {
+        std::ofstream csv(csvPath);
+        csv.precision(17);
+        csv << "time,label,demand\n# comment\n";
+        for (size_t i = 0; i < times.size(); i++) {
+            csv << times[i] << ",x," << values[i] << "\n";
+        }
+    }
+
+    TimeSeries memory, binary, text;
+    assert(memory.valueAt(1) == 0);
+    assert(!memory.set(std::vector<double>{0, 0}, std::vector<double>{1, 2}));
+    assert(memory.set(times, values));
+    assert(binary.openBinary(binaryPath));
+    assert(!text.openBinary(csvPath));
+    assert(text.openCsv(csvPath, 2));
+
+    assert(memory.valueAt(-10) == values.front() && memory.valueAt(1000) == values.back());
+    assert(fabs(memory.valueAt(3.75) - (values[1] + values[2]) / 2) < 1e-12);
+    for (TimeSeries::Interpolation interpolation : {TimeSeries::LINEAR, TimeSeries::STEP}) {
+        memory.setInterpolation(interpolation);
+        binary.setInterpolation(interpolation);
+        text.setInterpolation(interpolation);
+        TimeSeries::Cursor memoryCursor, binaryCursor, textCursor;
+        for (double time : {-1.0, 0.0, 1.0, 7.5, 8.0, 120.3, 60.0, 249.0, 250.0, 300.0, 3.0}) {
+            double expected = memory.valueAt(time);
+            assert(memory.valueAt(memoryCursor, time) == expected);
+            assert(binary.valueAt(binaryCursor, time) == expected);
+            assert(text.valueAt(textCursor, time) == expected);
+        }
+    }
+    assert(memory.valueAt(8.0) == values[3]);
+    memory.setInterpolation(TimeSeries::LINEAR);
+
+    // Reference: values set by hand between single-step executions.
+    auto build = [](Model* model) {
+        System* demand = model->createSystem("demand", 0);
+        System* backlog = model->createSystem("backlog", 0);
+        model->setParameter("rate", 0);
+        assert(model->createFlow("orders", demand, backlog, "rate * source"));
+        return std::make_pair(demand, backlog);
+    };
+    Model* model = Model::createModel("");
+    auto [demand, backlog] = build(model);
+    for (int time = 0; time < 200; time++) {
+        demand->setValue(memory.valueAt(time));
+        model->setParameter("rate", 0.01 * text.valueAt(time));
+        model->execute(time, time + 1, 1);
+    }
+    double expected = backlog->getValue();
+    Model::deleteModel();
+
+    TimeSeries rate;
+    std::vector<double> rates(values.size());
+    std::transform(values.begin(), values.end(), rates.begin(), [](double value) { return 0.01 * value; });
+    rate.set(times, rates);
+
+    model = Model::createModel("");
+    auto [boundDemand, boundBacklog] = build(model);
+    assert(model->bindInput(boundDemand, &binary));
+    assert(!model->bindInput(nullptr, &binary));
+    assert(model->bindInput("rate", &rate));
+    model->execute(0, 120, 1);
+    assert(!model->fastForward(120, 200, 1));
+    assert(fabs(boundBacklog->getValue() - expected) < 1e-9 * expected);
+    assert(boundDemand->getValue() == binary.valueAt(200));
+
+    model->bindInput(boundDemand, nullptr);
+    boundDemand->setValue(0);
+    model->execute(200, 210, 1);
+    assert(boundDemand->getValue() == 0);
+    Model::deleteModel();
+
+    std::remove(binaryPath.c_str());
+    std::remove(csvPath.c_str());
+    std::cout << "Time Series Inputs Test Passed!" << std::endl;
+}
+
+void aggregators() {
+    // Windows of ten consecutive integers.
+    Aggregator windows(10, std::vector<double>{0.5}, 7);
+    for (int time = 0; time < 100; time++) {
+        windows.add(time, time + 1);
+    }
+    assert(windows.getWindows().size() == 9 && windows.getCurrent().count == 10);
+    windows.flush();
+    assert(windows.getWindows().size() == 10);
+    for (size_t k = 0; k < 10; k++) {
+        const Aggregator::Window& window = windows.getWindows()[k];
+        assert(window.index == long(k) && window.start == int(10 * k) && window.end == int(10 * k + 9));
+        assert(window.count == 10 && window.min == 10 * k + 1 && window.max == 10 * k + 10);
+        assert(fabs(window.mean - (10 * k + 5.5)) < 1e-12 && fabs(window.variance - 110.0 / 12) < 1e-9);
+        assert(window.percentiles[0] > window.min && window.percentiles[0] < window.max);
+    }
+    assert(windows.getSamples().size() == 14 && windows.getSamples()[0].time == 6 && windows.getSamples()[0].value == 7);
+
+    // Percentile sketches of a long uniform sequence, in a single window.
+    Aggregator sketch(0, std::vector<double>{0.05, 0.5, 0.95});
+    unsigned long long seed = 42;
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+    const int count = 100000;
+    for (int i = 0; i < count; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        double value = double(seed >> 11) / double(1ULL << 53);
+        sum += value;
+        sumOfSquares += value * value;
+        sketch.add(i, value);
+    }
+    Aggregator::Window all = sketch.getCurrent();
+    double mean = sum / count;
+    assert(fabs(all.mean - mean) < 1e-12);
+    assert(fabs(all.variance - (sumOfSquares - count * mean * mean) / (count - 1)) < 1e-9);
+    assert(fabs(all.percentiles[0] - 0.05) < 0.01 && fabs(all.percentiles[1] - 0.5) < 0.01 && fabs(all.percentiles[2] - 0.95) < 0.01);
+
+    // Attached aggregators see the values reported by the steps of the run.
+    Model* model = Model::createModel("");
+    System* stock = model->createSystem("stock", 100);
+    System* sink = model->createSystem("sink", 0);
+    model->createFlow<ExponentialFlow>("outflow", stock, sink);
+    Aggregator attached(20, std::vector<double>{0.5}, 10);
+    Aggregator expected(20, std::vector<double>{0.5}, 10);
+    assert(model->attachAggregator(stock, &attached));
+    assert(!model->attachAggregator(nullptr, &attached));
+
+    Model* twin = model->fork();
+    for (const StepView& view : twin->steps(0, 100, 1)) {
+        expected.add(view.time, view.values[0]);
+    }
+    delete twin;
+    assert(!model->fastForward(0, 100, 1));
+    attached.flush();
+    expected.flush();
+    assert(attached.getWindows().size() == 6 && attached.getSamples().size() == 10);
+    for (size_t k = 0; k < expected.getWindows().size(); k++) {
+        const Aggregator::Window& a = attached.getWindows()[k];
+        const Aggregator::Window& b = expected.getWindows()[k];
+        assert(a.start == b.start && a.end == b.end && a.count == b.count && a.mean == b.mean);
+        assert(a.min == b.min && a.max == b.max && a.percentiles == b.percentiles);
+    }
+    assert(attached.getWindows().back().last == stock->getValue());
+
+    assert(model->detachAggregator(&attached));
+    assert(!model->detachAggregator(&attached));
+    model->execute(100, 110, 1);
+    assert(attached.getCurrent().count == 0);
+    Model::deleteModel();
+
+    std::cout << "Aggregators Test Passed!" << std::endl;
+}
+
+void sensitivities() {
+    LookupTable feedback;
+    feedback.set(std::vector<double>{0, 100, 200, 300, 400}, std::vector<double>{0, 1, 5, 6, 6.5}, LookupTable::MONOTONE_CUBIC);
+
+    struct Scenario { System* a; System* b; System* c; LinearFlow* f; };
+    auto build = [&feedback](Model* model, double k, double rate, double a, double c) {
+        Scenario scenario;
+        model->setParameter("k", k);
+        scenario.a = model->createSystem("A", a);
+        scenario.b = model->createSystem("B", 0);
+        scenario.c = model->createSystem("C", c);
+        scenario.f = model->createFlow<LinearFlow>("f", scenario.a, scenario.b);
+        scenario.f->setRate(rate);
+        assert(model->createFlow("g", scenario.b, scenario.c, "k * source * dest / (1 + 0.01 * dest) + 0.001 * exp(0.01 * source)"));
+        model->createFlow<LookupFlow>("h", scenario.c, scenario.a)->setTable(feedback);
+        return scenario;
+    };
+    auto run = [&build](double k, double rate, double a, double c) {
+        Model* model = Model::createModel("");
+        build(model, k, rate, a, c);
+        model->execute(0, 50, 1);
+        std::vector<double> values(3);
+        model->readValues(values);
+        Model::deleteModel();
+        return values;
+    };
+
+    const double k = 0.002, rate = 0.05, a = 100, c = 10;
+    Model* model = Model::createModel("");
+    Scenario scenario = build(model, k, rate, a, c);
+    std::vector<Sensitivity> with = {
+        {Sensitivity::PARAMETER, "k"},
+        {Sensitivity::RATE, "", scenario.f},
+        {Sensitivity::INITIAL_VALUE, "", nullptr, scenario.a},
+        {Sensitivity::INITIAL_VALUE, "", nullptr, scenario.c},
+    };
+    std::vector<double> tangents(3 * with.size());
+    std::vector<double> wrong(3);
+    assert(!model->computeSensitivities(0, 50, 1, with, wrong));
+    std::vector<Sensitivity> unknown = {{Sensitivity::PARAMETER, "missing"}};
+    assert(!model->computeSensitivities(0, 50, 1, unknown, wrong));
+    assert(model->computeSensitivities(0, 50, 1, with, tangents));
+
+    std::vector<double> values(3);
+    model->readValues(values);
+    Model::deleteModel();
+    assert(values == run(k, rate, a, c));
+
+    double parameters[4] = {k, rate, a, c};
+    for (size_t j = 0; j < 4; j++) {
+        double h = 1e-5 * parameters[j];
+        double plus[4] = {k, rate, a, c};
+        double minus[4] = {k, rate, a, c};
+        plus[j] += h;
+        minus[j] -= h;
+        std::vector<double> up = run(plus[0], plus[1], plus[2], plus[3]);
+        std::vector<double> down = run(minus[0], minus[1], minus[2], minus[3]);
+        for (size_t i = 0; i < 3; i++) {
+            double difference = (up[i] - down[i]) / (2 * h);
+            assert(fabs(tangents[i * 4 + j] - difference) <= 1e-5 * (fabs(difference) + 1e-3));
+        }
+    }
+
+    model = Model::createModel("");
+    System* p1 = model->createSystem("p1", 100);
+    System* p2 = model->createSystem("p2", 10);
+    model->createFlow<LogisticFlow>("logistic", p1, p2);
+    std::vector<Sensitivity> initial = {{Sensitivity::INITIAL_VALUE, "", nullptr, p1}};
+    std::vector<double> partials(2);
+    assert(!model->computeSensitivities(0, 10, 1, initial, partials));
+    assert(p1->getValue() == 100);
+    Model::deleteModel();
+
+    std::cout << "Sensitivities Test Passed!" << std::endl;
+}
+
+void adjointGradients() {
+    LookupTable feedback;
+    feedback.set(std::vector<double>{0, 100, 200, 300, 400}, std::vector<double>{0, 1, 5, 6, 6.5}, LookupTable::MONOTONE_CUBIC);
+
+    struct Scenario { System* a; System* b; System* c; LinearFlow* f; };
+    auto build = [&feedback](Model* model, double k, double rate, double a, double c) {
+        Scenario scenario;
+        model->setParameter("k", k);
+        scenario.a = model->createSystem("A", a);
+        scenario.b = model->createSystem("B", 0);
+        scenario.c = model->createSystem("C", c);
+        scenario.f = model->createFlow<LinearFlow>("f", scenario.a, scenario.b);
+        scenario.f->setRate(rate);
+        assert(model->createFlow("g", scenario.b, scenario.c, "k * source * dest / (1 + 0.01 * dest) + 0.001 * exp(0.01 * source)"));
+        model->createFlow<LookupFlow>("h", scenario.c, scenario.a)->setTable(feedback);
+        return scenario;
+    };
+
+    // Loss on the final values, whose gradient follows from the forward sensitivities.
+    Model::Loss final = [](int time, std::span<const double> values, std::span<double> seeds) {
+        if (time != 50) {
+            return 0.0;
+        }
+        seeds[0] = values[0] / 50;
+        seeds[2] = 3;
+        return values[0] * values[0] / 100 + 3 * values[2];
+    };
+    // Loss over every step, tracking a target for B.
+    Model::Loss tracking = [](int time, std::span<const double> values, std::span<double> seeds) {
+        double error = values[1] - time;
+        seeds[1] = 0.02 * error;
+        return 0.01 * error * error;
+    };
+
+    const double k = 0.002, rate = 0.05, a = 100, c = 10;
+    Model* model = Model::createModel("");
+    Scenario scenario = build(model, k, rate, a, c);
+    std::vector<Sensitivity> with = {
+        {Sensitivity::PARAMETER, "k"},
+        {Sensitivity::RATE, "", scenario.f},
+        {Sensitivity::INITIAL_VALUE, "", nullptr, scenario.a},
+        {Sensitivity::INITIAL_VALUE, "", nullptr, scenario.c},
+    };
+    std::vector<double> tangents(3 * with.size());
+    assert(model->computeSensitivities(0, 50, 1, with, tangents));
+    std::vector<double> expected(3);
+    model->readValues(expected);
+    double seeds[3] = {expected[0] / 50, 0, 3};
+    auto chained = [&tangents, &seeds](size_t j) {
+        return seeds[0] * tangents[j] + seeds[1] * tangents[4 + j] + seeds[2] * tangents[8 + j];
+    };
+
+    Gradient reference;
+    for (size_t checkpoints : {0, 1, 7, 50}) {
+        scenario.a->setValue(a);
+        scenario.b->setValue(0);
+        scenario.c->setValue(c);
+        Gradient gradient;
+        assert(model->computeGradient(0, 50, 1, final, gradient, checkpoints));
+        std::vector<double> values(3);
+        model->readValues(values);
+        assert(values == expected);
+        assert(gradient.loss == expected[0] * expected[0] / 100 + 3 * expected[2]);
+        assert(gradient.parameters.size() == 1 && gradient.rates.size() == 3 && gradient.initialValues.size() == 3);
+        assert(gradient.rates[1] == 0 && gradient.rates[2] == 0);
+        double adjoints[4] = {gradient.parameters[0], gradient.rates[0], gradient.initialValues[0], gradient.initialValues[2]};
+        for (size_t j = 0; j < 4; j++) {
+            assert(fabs(adjoints[j] - chained(j)) <= 1e-9 * (fabs(chained(j)) + 1e-9));
+        }
+        if (checkpoints == 0) {
+            reference = gradient;
+        }
+        assert(fabs(gradient.initialValues[1] - reference.initialValues[1]) <= 1e-12 * (fabs(reference.initialValues[1]) + 1));
+    }
+    Model::deleteModel();
+
+    auto run = [&build, &tracking](double k, double rate, double a, double c, Gradient& gradient) {
+        Model* model = Model::createModel("");
+        build(model, k, rate, a, c);
+        assert(model->computeGradient(0, 50, 1, tracking, gradient, 5));
+        Model::deleteModel();
+    };
+    Gradient gradient;
+    run(k, rate, a, c, gradient);
+    double adjoints[4] = {gradient.parameters[0], gradient.rates[0], gradient.initialValues[0], gradient.initialValues[2]};
+    double parameters[4] = {k, rate, a, c};
+    for (size_t j = 0; j < 4; j++) {
+        double h = 1e-5 * parameters[j];
+        double plus[4] = {k, rate, a, c};
+        double minus[4] = {k, rate, a, c};
+        plus[j] += h;
+        minus[j] -= h;
+        Gradient up, down;
+        run(plus[0], plus[1], plus[2], plus[3], up);
+        run(minus[0], minus[1], minus[2], minus[3], down);
+        double difference = (up.loss - down.loss) / (2 * h);
+        assert(fabs(adjoints[j] - difference) <= 1e-5 * (fabs(difference) + 1e-3));
+    }
+
+    // Stochastic flows are differentiated along the noise of the run, which the adjoint pass must draw again 
+    // at the time of each step; the steps executed again are not profiled.
+    auto buildNoisy = [](Model* model, double rate, double a) {
+        System* source = model->createSystem("A", a);
+        System* b = model->createSystem("B", 0);
+        System* c = model->createSystem("C", 10);
+        model->createFlow<LinearFlow>("f", source, b)->setRate(rate);
+        model->createFlow<StochasticFlow>("shock", source, b)->setNoise(0.02, 0.01, StochasticFlow::NORMAL, true);
+        model->createFlow<StochasticFlow>("supply", c, source)->setNoise(0.5, 1.0);
+        model->setRun(7);
+    };
+    auto noisy = [&buildNoisy, &tracking](double rate, double a, Gradient& gradient, Profiler* profiler) {
+        Model* model = Model::createModel("");
+        buildNoisy(model, rate, a);
+        model->setProfiler(profiler);
+        assert(model->computeGradient(0, 50, 1, tracking, gradient, 5));
+        Model::deleteModel();
+    };
+    Profiler profiler(1);
+    noisy(rate, a, gradient, &profiler);
+    assert(profiler.getSteps() == 50);
+
+    model = Model::createModel("");
+    buildNoisy(model, rate, a);
+    double forwardLoss = 0.0;
+    std::vector<double> unused(3);
+    for (StepView view : model->steps(0, 50, 1)) {
+        forwardLoss += tracking(view.time, view.values, unused);
+    }
+    assert(fabs(gradient.loss - forwardLoss) <= 1e-12 * forwardLoss);
+    Model::deleteModel();
+
+    double noisyAdjoints[2] = {gradient.rates[0], gradient.initialValues[0]};
+    double noisyParameters[2] = {rate, a};
+    for (size_t j = 0; j < 2; j++) {
+        double h = 1e-5 * noisyParameters[j];
+        double plus[2] = {rate, a};
+        double minus[2] = {rate, a};
+        plus[j] += h;
+        minus[j] -= h;
+        Gradient up, down;
+        noisy(plus[0], plus[1], up, nullptr);
+        noisy(minus[0], minus[1], down, nullptr);
+        double difference = (up.loss - down.loss) / (2 * h);
+        assert(fabs(noisyAdjoints[j] - difference) <= 1e-5 * (fabs(difference) + 1e-3));
+    }
+
+    model = Model::createModel("");
+    System* p1 = model->createSystem("p1", 100);
+    System* p2 = model->createSystem("p2", 10);
+    model->createFlow<LogisticFlow>("logistic", p1, p2);
+    assert(!model->computeGradient(0, 10, 1, tracking, gradient));
+    assert(p1->getValue() == 100);
+    Model::deleteModel();
+
+    std::cout << "Adjoint Gradients Test Passed!" << std::endl;
+}
+
+void calibration() {
+    Model* model = Model::createModel("");
+    model->setParameter("inflow", 2.0);
+    model->setParameter("decay", 0.05);
+    System* reservoir = model->createSystem("reservoir", 1000);
+    System* stock = model->createSystem("stock", 100);
+    System* sink = model->createSystem("sink", 0);
+    assert(model->createFlow("in", reservoir, stock, "inflow"));
+    assert(model->createFlow("out", stock, sink, "decay * source"));
+
+    std::vector<double> times, observed;
+    for (const StepView& view : model->steps(0, 60, 1)) {
+        times.push_back(view.time);
+        observed.push_back(view.values[1]);
+    }
+    TimeSeries series;
+    assert(series.set(times, observed));
+    std::vector<double> initial = {1000, 100, 0};
+    model->writeValues(initial);
+    model->setParameter("inflow", 0.5);
+    model->setParameter("decay", 0.2);
+
+    Calibrator calibrator(model, 0, 60, 1);
+    assert(!calibrator.addParameter("missing", 0, 1));
+    assert(!calibrator.addParameter("decay", 1, 0));
+    assert(!calibrator.addObservation(stock, nullptr));
+    Calibrator::Result result;
+    assert(!calibrator.run(Calibrator::Settings(), result));
+    assert(calibrator.addParameter("inflow", 0, 10));
+    assert(calibrator.addParameter("decay", 0, 1));
+    assert(calibrator.addObservation(stock, &series));
+    std::vector<double> truth = {2.0, 0.05};
+    assert(calibrator.evaluate(truth) < 1e-20);
+
+    for (Calibrator::Method method : {Calibrator::DIFFERENTIAL_EVOLUTION, Calibrator::NELDER_MEAD}) {
+        Calibrator::Settings settings;
+        settings.method = method;
+        settings.tolerance = 1e-14;
+        assert(calibrator.run(settings, result));
+        assert(fabs(result.parameters[0] - 2.0) < 1e-3 && fabs(result.parameters[1] - 0.05) < 1e-3);
+        assert(result.objective == calibrator.evaluate(result.parameters));
+        assert(result.evaluations > 0 && result.evaluations <= settings.maxEvaluations + 2);
+        assert(result.evaluationsPerSecond > 0 && result.iterations == result.trace.back().iteration);
+        for (size_t i = 1; i < result.trace.size(); i++) {
+            assert(result.trace[i].best <= result.trace[i - 1].best);
+            assert(result.trace[i].evaluations > result.trace[i - 1].evaluations);
+        }
+
+        std::vector<double> values(3);
+        model->readValues(values);
+        assert(values == initial);
+        assert(model->getParameter("inflow") == 0.5 && model->getParameter("decay") == 0.2);
+    }
+
+    assert(calibrator.apply(result));
+    assert(model->getParameter("inflow") == result.parameters[0] && model->getParameter("decay") == result.parameters[1]);
+    Model::deleteModel();
+
+    // Candidates of a model past the parallel sparse product threshold run it inside the parallel evaluation.
+    model = Model::createModel("");
+    model->setParameter("gain", 1.5);
+    const size_t numSystems = (size_t(1) << 16) + 2;
+    std::vector<string> names(numSystems), flowNames(numSystems - 1);
+    std::vector<double> start(numSystems, 1.0);
+    for (size_t i = 0; i < numSystems; i++) {
+        names[i] = "c" + std::to_string(i);
+    }
+    std::vector<System*> chain = model->createSystems(names, start);
+    std::vector<System*> sources(chain.begin(), chain.end() - 1), destinations(chain.begin() + 1, chain.end());
+    for (size_t i = 0; i + 1 < numSystems; i++) {
+        flowNames[i] = "l" + std::to_string(i);
+    }
+    for (LinearFlow* flow : model->createFlows<LinearFlow>(flowNames, sources, destinations)) {
+        flow->setRate(0.01);
+    }
+    System* tracked = model->createSystem("tracked", 0);
+    assert(model->createFlow("gained", chain[0], tracked, "gain * 0.01 * source"));
+    times.clear();
+    observed.clear();
+    for (const StepView& view : model->steps(0, 5, 1)) {
+        times.push_back(view.time);
+        observed.push_back(view.values[numSystems]);
+    }
+    assert(series.set(times, observed));
+    start.push_back(0);
+    model->writeValues(start);
+    model->setParameter("gain", 0.5);
+
+    Calibrator large(model, 0, 5, 1);
+    assert(large.addParameter("gain", 0, 3) && large.addObservation(tracked, &series));
+    Calibrator::Settings settings;
+    settings.population = 8;
+    settings.maxEvaluations = 48;
+    assert(large.run(settings, result));
+    assert(result.evaluations >= 8 && result.objective <= large.evaluate(std::vector<double>{0.5}));
+    assert(large.evaluate(std::vector<double>{1.5}) < 1e-20);
+    Model::deleteModel();
+
+    std::cout << "Calibration Test Passed!" << std::endl;
+}
+
+void stochasticFlows() {
+    uint32_t zeros[4] = {0, 0, 0, 0};
+    uint32_t ones[4] = {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff};
+    uint32_t block[4];
+    Philox::generate(zeros, zeros, block);
+    assert(block[0] == 0x6627e8d5 && block[1] == 0xe169c58d && block[2] == 0xbc57ac4c && block[3] == 0x9b00dbd8);
+    Philox::generate(ones, ones, block);
+    assert(block[0] == 0x408f276d && block[1] == 0x41c83b0e && block[2] == 0xa20bc7c6 && block[3] == 0x6d5451fd);
+
+    for (StochasticFlow::Distribution distribution : {StochasticFlow::NORMAL, StochasticFlow::UNIFORM}) {
+        double sum = 0.0, sumOfSquares = 0.0;
+        const int count = 20000;
+        for (int time = 0; time < count; time++) {
+            double z = StochasticFlow::draw(Philox::hash("noise"), 3, time, distribution);
+            sum += z;
+            sumOfSquares += z * z;
+        }
+        assert(fabs(sum / count) < 0.05 && fabs(sumOfSquares / count - 1.0) < 0.05);
+    }
+
+    Model* model = Model::createModel("");
+    System* pool = model->createSystem("pool", 1000);
+    System* queue = model->createSystem("queue", 0);
+    System* done = model->createSystem("done", 0);
+    StochasticFlow* arrivals = model->createFlow<StochasticFlow>("arrivals", pool, queue);
+    arrivals->setNoise(5.0, 2.0);
+    StochasticFlow* service = model->createFlow<StochasticFlow>("service", queue, done);
+    service->setNoise(0.1, 0.05, StochasticFlow::UNIFORM, true);
+    assert(arrivals->equation() == 5.0 && service->equation() == 0.0);
+
+    std::vector<double> initial = {1000, 0, 0};
+    auto runValues = [&initial](Model* run, uint64_t number) {
+        run->writeValues(initial);
+        run->setRun(number);
+        run->execute(0, 100, 1);
+        std::vector<double> values(3);
+        run->readValues(values);
+        return values;
+    };
+
+    model->setRun(7);
+    model->execute(0, 1, 1);
+    double arrived = arrivals->sample(7, 0, 1000);
+    assert(queue->getValue() == arrived - service->sample(7, 0, 0));
+    assert(pool->getValue() == 1000 - arrived);
+
+    std::vector<double> expected = runValues(model, 7);
+    assert(runValues(model, 7) == expected);
+    assert(runValues(model, 8) != expected);
+    assert(fabs(expected[0] + expected[1] + expected[2] - 1000) < 1e-9);
+
+    // Replicates on several threads draw what they would draw alone.
+    const size_t replicates = 8;
+    std::vector<std::vector<double>> sequential(replicates);
+    for (size_t r = 0; r < replicates; r++) {
+        sequential[r] = runValues(model, r);
+    }
+    std::vector<Model*> forks;
+    for (size_t r = 0; r < replicates; r++) {
+        forks.push_back(model->fork());
+    }
+    std::vector<std::vector<double>> concurrent(replicates);
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < replicates; r++) {
+        threads.emplace_back([&, r] { concurrent[r] = runValues(forks[r], r); });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (size_t r = 0; r < replicates; r++) {
+        assert(concurrent[r] == sequential[r]);
+        delete forks[r];
+    }
+
+    assert(model->compile("/tmp"));
+    std::vector<double> compiled = runValues(model, 7);
+    for (size_t i = 0; i < 3; i++) {
+        assert(fabs(compiled[i] - expected[i]) <= 1e-9 * (fabs(expected[i]) + 1));
+    }
+    Model::deleteModel();
+
+    std::cout << "Stochastic Flows Test Passed!" << std::endl;
+}
+
+void profiler() {
+    FlowRegistry::add<ExponentialFlow>("exponential");
+    Model* model = Model::createModel("");
+    System* a = model->createSystem("a", 100);
+    System* b = model->createSystem("b", 10);
+    System* c = model->createSystem("c", 0);
+    model->createFlow<LinearFlow>("drain", a, b)->setRate(0.01);
+    assert(model->createFlow("transfer", b, c, "0.02 * source"));
+    model->createFlow<ExponentialFlow>("growth", c, a);
+    model->createFlow<LogisticFlow>("logistic", a, c);
+
+    std::vector<double> initial = {100, 10, 0};
+    std::vector<double> expected(3);
+    model->execute(0, 100, 1);
+    model->readValues(expected);
+
+    Profiler profiler(10, 3);
+    model->writeValues(initial);
+    model->setProfiler(&profiler);
+    model->execute(0, 100, 1);
+    std::vector<double> values(3);
+    model->readValues(values);
+    assert(values == expected);
+
+    assert(profiler.getSteps() == 100 && profiler.getSampledSteps() == 10 && profiler.getStepNanoseconds() > 0);
+    std::vector<Profiler::Entry> flows = profiler.getFlows();
+    assert(flows.size() == 4);
+    for (size_t i = 0; i < flows.size(); i++) {
+        const Profiler::Entry& entry = flows[i];
+        assert(entry.calls == 10 && entry.slowest.size() == 3);
+        assert(entry.slowest[0].nanoseconds == entry.maxNanoseconds);
+        assert(entry.slowest[0].nanoseconds >= entry.slowest[1].nanoseconds && entry.slowest[1].nanoseconds >= entry.slowest[2].nanoseconds);
+        assert(entry.slowest[0].time % 10 == 0 && entry.getMean() <= entry.maxNanoseconds);
+        assert(i == 0 || flows[i - 1].nanoseconds >= entry.nanoseconds);
+    }
+    auto find = [&flows](const string& name) {
+        return *std::find_if(flows.begin(), flows.end(), [&name](const Profiler::Entry& entry) { return entry.name == name; });
+    };
+    assert(find("drain").type == "LinearFlow" && find("transfer").type == "ExpressionFlow");
+    assert(find("growth").type == "exponential" && find("logistic").type == "LogisticFlow");
+
+    std::vector<Profiler::Entry> types = profiler.getTypes();
+    assert(types.size() == 4);
+    double total = 0.0;
+    for (const Profiler::Entry& type : types) {
+        assert(type.calls == 10);
+        total += type.nanoseconds;
+    }
+    double flowTotal = 0.0;
+    for (const Profiler::Entry& entry : flows) {
+        flowTotal += entry.nanoseconds;
+    }
+    assert(fabs(total - flowTotal) <= 1e-9 * flowTotal);
+
+    string report = profiler.report(2);
+    assert(report.find("Profile of 100 steps, 10 timed (one in 10)") != string::npos);
+    assert(report.find(flows[0].name) != string::npos && report.find("(2 more)") != string::npos);
+    string json = profiler.toJson();
+    assert(json.find("\"sampledSteps\": 10") != string::npos && json.find("\"name\": \"logistic\"") != string::npos);
+    assert(profiler.writeJson("/tmp/profile_test.json"));
+    std::ifstream input("/tmp/profile_test.json");
+    string dumped((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    assert(dumped == json);
+    std::remove("/tmp/profile_test.json");
+    assert(!profiler.writeJson("/nonexistent/profile.json"));
+
+    model->setProfiler(nullptr);
+    model->execute(0, 100, 1);
+    assert(profiler.getSteps() == 100);
+    profiler.reset();
+    assert(profiler.getSteps() == 0 && profiler.getFlows().empty());
+    Model::deleteModel();
+
+    std::cout << "Profiler Test Passed!" << std::endl;
+}
+
+void trace() {
+    Model* model = Model::createModel("");
+    System* a = model->createSystem("a", 100);
+    System* b = model->createSystem("b", 0);
+    model->createFlow<LinearFlow>("drain", a, b)->setRate(0.1);
+
+    Trace::clear();
+    model->execute(0, 10, 1);
+    assert(Trace::getEvents().empty());
+
+    Trace::enable();
+    model->execute(0, 10, 1);
+    std::vector<Trace::Event> events = Trace::getEvents();
+    auto count = [&events](const string& name) {
+        return std::count_if(events.begin(), events.end(), [&name](const Trace::Event& event) { return event.name == name; });
+    };
+    assert(count("step") == 10 && count("flows") == 10 && count("update") == 10 && count("plan") >= 1);
+    uint64_t planEnd = 0;
+    for (const Trace::Event& event : events) {
+        assert(event.thread == events[0].thread);
+        if (string(event.name) == "plan") {
+            planEnd = event.start + event.duration;
+        }
+    }
+    for (const Trace::Event& event : events) {
+        if (string(event.name) == "step") {
+            assert(event.start >= planEnd && string(event.category) == "model");
+        }
+    }
+
+    Trace::clear();
+    ThreadPool::getInstance().parallelFor(16, [](size_t) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+    events = Trace::getEvents();
+    assert(count("chunk") == 16);
+    std::vector<uint32_t> threads;
+    for (const Trace::Event& event : events) {
+        if (std::find(threads.begin(), threads.end(), event.thread) == threads.end()) {
+            threads.push_back(event.thread);
+        }
+    }
+    assert(threads.size() >= 2 || ThreadPool::getInstance().getNumThreads() == 1);
+
+    std::thread([] {
+        Trace::setThreadName("tracer");
+        Trace::Scope scope("named", "test");
+    }).join();
+    Trace::enable(4);
+    std::thread([] {
+        for (int i = 0; i < 10; i++) {
+            Trace::Scope scope("overflow", "test");
+        }
+    }).join();
+    events = Trace::getEvents();
+    assert(count("named") == 1 && count("overflow") == 4 && Trace::getDropped() == 6);
+
+    string json = Trace::toJson();
+    assert(json.find("\"traceEvents\"") != string::npos && json.find("\"name\": \"tracer\"") != string::npos);
+    assert(json.find("\"name\": \"chunk\", \"cat\": \"pool\", \"ph\": \"X\"") != string::npos);
+    assert(Trace::writeJson("/tmp/trace_test.json"));
+    std::ifstream input("/tmp/trace_test.json");
+    string dumped((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    assert(dumped == json);
+    std::remove("/tmp/trace_test.json");
+    string error;
+    assert(!Trace::writeJson("/nonexistent/trace.json", &error) && !error.empty());
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> recorded{0};
+    std::thread writer([&stop, &recorded] {
+        while (!stop) {
+            Trace::Scope scope("racing", "test");
+            recorded++;
+        }
+    });
+    for (int i = 0; i < 1000; i++) {
+        Trace::clear();
+        for (const Trace::Event& event : Trace::getEvents()) {
+            assert(event.name == string("racing"));
+        }
+    }
+    Trace::clear();
+    for (int seen = recorded; recorded < seen + 2;) {
+        std::this_thread::yield();
+    }
+    stop = true;
+    writer.join();
+    events = Trace::getEvents();
+    assert(count("racing") >= 1 && count("racing") <= 4 && size_t(count("racing")) == events.size());
+
+    Trace::disable();
+    Trace::clear();
+    model->execute(0, 10, 1);
+    assert(Trace::getEvents().empty() && Trace::getDropped() == 0);
+    Model::deleteModel();
+
+    std::cout << "Trace Test Passed!" << std::endl;
+}
@@ -2,6 +2,21 @@
 #define FUNCIONAL_TESTS_HPP
 
 #include "../../src/FlowImpl.hpp"
+#include "../../src/LinearFlow.hpp"
+#include "../../src/ExpressionFlow.hpp"
+#include "../../src/DelayFlow.hpp"
+#include "../../src/LookupFlow.hpp"
+#include "../../src/StochasticFlow.hpp"
+#include "../../src/TimeSeries.hpp"
+#include "../../src/Aggregator.hpp"
+#include "../../src/Calibrator.hpp"
+#include "../../src/Profiler.hpp"
+#include "../../src/Trace.hpp"
+#include "../../src/ThreadPool.hpp"
+#include "../../src/StaticModel.hpp"
+#include "../../src/FlowRegistry.hpp"
+#include "../../src/ModelLoader.hpp"
+#include "../../src/ModelSnapshot.hpp"
 #include "../../src/Model.hpp"
 #include "../../src/System.hpp"
 #include "../../src/Bridge.hpp"
@@ -107,6 +122,25 @@ class LogisticFlow : public FlowHandle {
         };
 };
 
+/**
+ * @struct ExponentialLaw
+ * @brief Compile-time law of the ExponentialFlow, for StaticModel.
+ * @details \f[ f = 0.01 \times source \f]
+ */
+struct ExponentialLaw {
+    static constexpr double rate = 0.01;
+    static constexpr double equation(double source, double) { return rate * source; }
+};
+
+/**
+ * @struct LogisticLaw
+ * @brief Compile-time law of the LogisticFlow, for StaticModel.
+ * @details \f[ f = 0.01 \times destination \times \left(1 - \frac{destination}{70}\right) \f]
+ */
+struct LogisticLaw {
+    static constexpr double equation(double, double destination) { return 0.01 * destination * (1 - destination / 70); }
+};
+
 /**
  * @brief Tests the ExponentialFlow class.
  * @pre A Model object with an ExponentialFlow object connected to two System objects is created.
@@ -140,4 +174,326 @@ void logisticFlow();
  */
 void complexFlow();
 
+/**
+ * @brief Tests the lazy stepping generator of the Model class.
+ * @pre A Model object with an ExponentialFlow object connected to two System objects is created.
+ * @post Only the steps pulled by the consumer are executed.
+ * @assert Each yielded view carries the time of its step and the current values of the systems; a range
+ * algorithm stops the run at the first step where the destination exceeds the source.
+ * @test Consumes the generator through `std::views::take` and `std::ranges::find_if` and checks the model time.
+ */
+void lazySteps();
+
+/**
+ * @brief Tests the steady-state detection of the Model class.
+ * @pre A Model object with a LogisticFlow object connected to two System objects is created.
+ * @post Runs far longer than needed end as soon as the systems stop changing.
+ * @assert The run stops (or fast-forwards to the end time) at the detection time with the systems at 
+ * the logistic equilibrium, and disabling the criteria restores full-length runs.
+ * @test Executes the model with stopping, fast-forwarding and disabled criteria.
+ */
+void steadyState();
+
+/**
+ * @brief Tests the closed-form execution of linear models.
+ * @pre Models made only of linear flows, and a model with a LogisticFlow, are created.
+ * @post Linear models jump directly to the end time; the non-linear model is executed step by step.
+ * @assert The complex flow scenario reaches the same values as the step-by-step execution, a long 
+ * linear run matches its analytical solution, and the logistic model falls back to stepping.
+ * @test Calls fastForward on linear and non-linear models and checks its result and the system values.
+ */
+void linearFastForward();
+
+/**
+ * @brief Tests a large model mixing linear and non-linear flows.
+ * @pre A chain of systems connected by LinearFlow objects, plus LogisticFlow objects, is created.
+ * @post The linear flows are evaluated as a sparse matrix product and the logistic ones through `equation`.
+ * @assert After the run, every system matches a reference integration computed directly in the test.
+ * @test Executes a model large enough for the sparse product to be split in blocks.
+ */
+void mixedFlows();
+
+/**
+ * @brief Tests flows defined by runtime expressions.
+ * @pre A Model object with parameters and flows created from expression strings is created.
+ * @post The expressions are evaluated by the bytecode interpreter during the run.
+ * @assert The logistic and exponential scenarios written as expressions reach the same values as their 
+ * C++ counterparts, parameter changes take effect, and invalid expressions are rejected.
+ * @assert A model mixing linear and expression flows is fast-forwarded step by step, to the values of execute.
+ * @assert An expression changed between runs is bound and evaluated from the next run on.
+ * @test Creates expression flows referencing endpoints, systems by name and parameters, and executes them.
+ */
+void expressionFlow();
+
+/**
+ * @brief Tests the compiled step function of the Model class.
+ * @pre A Model object mixing linear and expression flows is created, together with a copy built with the 
+ * same systems and flows.
+ * @post One model runs with a generated, compiled and loaded step function; the other with the generic engine.
+ * @assert Both models reach the same values within a relative tolerance of 1e-9, and models with flows 
+ * that have no symbolic form cannot be compiled.
+ * @assert No generated file is left in the build directory, whose path needs quoting for the shell.
+ * @assert Editing an expression after compiling brings the model back to the generic evaluation.
+ * @test Compiles a model into a shared library in /tmp and compares its run with the generic one.
+ */
+void compiledStep();
+
+/**
+ * @brief Tests the compile-time StaticModel against the exponential, logistic and complex flow scenarios.
+ * @pre StaticModel types are declared with the same structure as the exponentialFlow, logisticFlow and 
+ * complexFlow tests.
+ * @post Each static model is executed, and the complex one is also copied into a runtime Model and executed there.
+ * @assert The static models reach the values expected by the runtime tests, a step can be evaluated in a 
+ * constant expression, and the runtime copy reaches the same values.
+ * @test Executes the three scenarios with StaticModel and with the runtime engine through StaticFlowAdapter.
+ */
+void staticModels();
+
+/**
+ * @brief Tests loading models from the text model format.
+ * @pre The ExponentialFlow class is registered in the FlowRegistry and a model file describing the complex 
+ * flow scenario, with linear, expression and registered flows, is written.
+ * @post The file is loaded into a Model, which is then executed.
+ * @assert The loaded model reaches the values of the complexFlow test, and malformed declarations, 
+ * including unterminated quotes and empty keywords, are rejected with the number of the faulty line.
+ * @test Loads a model file and several invalid texts with ModelLoader.
+ */
+void modelFile();
+
+/**
+ * @brief Tests that a model restored from a binary snapshot continues exactly like the original.
+ * @details A model with parameters and linear, expression and registered flows runs half of its time
+ * range, is saved, and runs the other half. The snapshot, loaded into a new model, must run the second
+ * half to the same values. Truncated or corrupted snapshots must be rejected without creating anything.
+ * @pre None.
+ * @post The snapshot files are removed and the model is deleted.
+ * @assert The restored model has the same name, time and values, and ends with the same values as the original.
+ * @assert A snapshot with a flipped byte in its body or header fails the checksum and leaves the model empty.
+ * @assert A registered linear flow reloads with its rate, and a registered flow whose state a snapshot cannot 
+ * hold is refused.
+ * @test Saves and loads snapshots with ModelSnapshot.
+ */
+void modelSnapshot();
+
+/**
+ * @brief Tests that models built with the bulk creation API match models built one object at a time.
+ * @details A chain of 20000 systems connected by linear flows is built with createSystems and createFlows, 
+ * large enough to be split across threads, and again with createSystem and createFlow. Both models run 
+ * for the same time and must end with the same values.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert Bulk-created systems and flows keep the order, names and endpoints they were given.
+ * @assert Both models end with identical values.
+ * @assert Arrays of different sizes create nothing.
+ * @test Builds and executes models with Model::createSystems and Model::createFlows.
+ */
+void bulkCreation();
+
+/**
+ * @brief Tests reading and writing the values of a model through buffers.
+ * @details The initial values of a model are exported with readValues, the model runs, and writeValues 
+ * resets it from the exported buffer so a second run gives the same result. Indices resolved once by 
+ * name read and write a subset of the systems.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert Values read in bulk equal the values of each system, and a reset run repeats the first run.
+ * @assert Unknown names map to Model::NO_SYSTEM, and buffers of the wrong size are rejected.
+ * @test Uses Model::readValues, Model::writeValues and Model::getSystemIndices.
+ */
+void bulkValues();
+
+/**
+ * @brief Tests what-if scenarios branched from a running model with Model::fork.
+ * @details A model with linear and expression flows is warmed up and forked into variants with different 
+ * parameters, which run on their own threads while the original is left untouched. A fork that changes 
+ * its topology must not change the original, and a fork running generic flows must hand the shared 
+ * systems back with the values of the original.
+ * @pre None.
+ * @post The forks and the model are deleted, and the snapshot file removed.
+ * @assert A fork with the original parameters ends exactly like the original; other forks differ.
+ * @assert Forks run concurrently give the same values as forks run one after the other.
+ * @assert Systems and flows created or deleted in a fork do not appear in or disappear from the original.
+ * @assert A snapshot of a fork reloads to the values, time and parameters of the fork.
+ * @assert An expression evaluated by a generic flow of a fork reads the parameters of the fork, and can 
+ * still be evaluated once the model that created it is deleted.
+ * @test Forks models and executes the forks sequentially and on several threads.
+ */
+void modelFork();
+
+/**
+ * @brief Tests topology and parameter edits staged while a run is in progress.
+ * @details While a run is paused at time 50, another thread stages the removal of a flow, the creation 
+ * of an expression flow and a parameter change. The run must apply them before its next step and end 
+ * with the same values as a model edited between two runs. Edits staged concurrently by several threads 
+ * must all be applied, in the order each thread staged them.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert Edits staged mid-run give the same values as the same edits made between runs.
+ * @assert Every edit staged by four threads is applied exactly once.
+ * @test Stages edits with Model::stageEdit from other threads during Model::steps.
+ */
+void stagedEdits();
+
+/**
+ * @brief Tests discrete events scheduled in a single run.
+ * @details Impulses, value changes, parameter changes and flows switched off and on again are scheduled 
+ * over one run, which must end like the same run split into several executions with the changes made 
+ * between them.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert A run with events gives exactly the values of the split runs.
+ * @assert Values reported by Model::steps for the time of an event include it.
+ * @assert Steady-state detection does not end a run before its pending events, and fastForward steps runs with events.
+ * @test Schedules events with Model::schedule and runs them with execute, steps and fastForward.
+ */
+void scheduledEvents();
+
+/**
+ * @brief Tests pipeline and exponential delay flows.
+ * @details A pipeline must deliver each entry exactly after its delay while conserving the total quantity, 
+ * including what is in transit. A third-order exponential delay must behave like a chain of three stocks 
+ * joined by linear flows. The contents of the delays must persist between runs and stay separate in forks.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert The destination of a pipeline of 5 steps receives nothing before step 6, then the first entry.
+ * @assert Systems and quantities in transit always add up to the initial total.
+ * @assert A DELAY3 gives the values of the equivalent chain of stocks.
+ * @assert Split runs and forks give the values of a single run, and forks leave the original delays unchanged.
+ * @test Runs DelayFlow instances with execute, steps and fork.
+ */
+void delayFlows();
+
+/**
+ * @brief Tests lookup tables and the flows using them.
+ * @details Tables with evenly and unevenly spaced breakpoints are evaluated one input at a time and in 
+ * batches, with linear and monotone cubic interpolation. A model of a thousand lookup flows sharing one table 
+ * whose curve is a straight line must give the values of the same model with linear flows.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert Tables pass through their breakpoints and hold their end values outside them.
+ * @assert Monotone cubic interpolation of increasing breakpoints is increasing and stays between them.
+ * @assert Batch and single evaluations give the same values, and invalid breakpoints are rejected.
+ * @assert Lookup flows share their table and match the equivalent linear flows.
+ * @test Evaluates LookupTable instances and executes LookupFlow instances.
+ */
+void lookupTables();
+
+/**
+ * @brief Tests input series driving systems and parameters.
+ * @details The same samples are read from memory, from a binary file and from a CSV file. A system and a 
+ * parameter bound to series must give the values obtained by setting them between single-step executions.
+ * @pre None.
+ * @post The model is deleted and the series files are removed.
+ * @assert The three sources give the same values, interpolated linearly or held, moving forward and back.
+ * @assert Bound inputs match values set by hand between single-step executions.
+ * @assert Removing a binding leaves the system free.
+ * @test Reads TimeSeries instances and binds them with Model::bindInput.
+ */
+void timeSeriesInputs();
+
+/**
+ * @brief Tests online aggregation and decimation of the values of systems.
+ * @details An aggregator fed with known values must report the exact means, variances, extremes and windows, 
+ * and percentile estimates close to the exact percentiles. Aggregators attached to a model must receive the 
+ * same values as those reported by Model::steps.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert Window statistics match direct computations; P-square estimates are within 0.01 of the true percentiles.
+ * @assert Decimation keeps every k-th value.
+ * @assert Attached aggregators match aggregators fed by hand from the steps of the same run.
+ * @test Feeds Aggregator instances directly and through Model::attachAggregator.
+ */
+void aggregators();
+
+/**
+ * @brief Tests forward-mode sensitivities of the final values.
+ * @details A model with linear, expression and lookup flows is differentiated with respect to a parameter, 
+ * a rate and two initial values in one run, and compared with central finite differences of full runs.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert The sensitivities match finite differences within 1e-5 relative.
+ * @assert The run ends with the values of a plain execution.
+ * @assert Models with generic flows, and unknown parameters, are refused.
+ * @test Calls Model::computeSensitivities.
+ */
+void sensitivities();
+
+/**
+ * @brief Tests adjoint gradients of a loss of a run.
+ * @details The model of the sensitivities test is differentiated in reverse mode, with several numbers of 
+ * checkpoints, for a loss on the final values and for a loss over every step.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert The gradient of a loss on the final values matches the forward sensitivities.
+ * @assert The gradient of a loss over every step matches finite differences within 1e-5 relative.
+ * @assert The number of checkpoints does not change the gradient, nor the values left by the run.
+ * @assert With stochastic flows, the loss is that of the forward run and the gradient matches finite 
+ * differences for the same run; the profiler only counts the steps of the forward run.
+ * @assert Models with generic flows are refused.
+ * @test Calls Model::computeGradient.
+ */
+void adjointGradients();
+
+/**
+ * @brief Tests the calibration of parameters against an observed series.
+ * @details Observations are generated by a run with known parameters; the calibrator then recovers them 
+ * from other values with differential evolution and with Nelder-Mead.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert Both methods recover the parameters within 1e-3 and report their statistics and trace.
+ * @assert The best objective of the trace never increases.
+ * @assert The model keeps its values and parameters until the result is applied.
+ * @assert Unknown parameters and null series are refused.
+ * @assert A model large enough for the parallel sparse product calibrates with concurrent candidates.
+ * @test Calls Calibrator::run and Calibrator::apply.
+ */
+void calibration();
+
+/**
+ * @brief Tests stochastic flows and their counter-based random numbers.
+ * @details Checks Philox against known-answer vectors, the moments of the draws, and that the values of a 
+ * run depend only on the run number, whether it runs again, in a fork, on other threads or compiled.
+ * @pre None.
+ * @post The model is deleted.
+ * @assert Philox matches the reference vectors of Random123.
+ * @assert Normal and uniform draws have mean 0 and variance 1 within 0.05.
+ * @assert The first step adds the sample of each flow for the run and time.
+ * @assert Runs with the same number give identical values, sequentially and concurrently.
+ * @assert Runs with different numbers differ.
+ * @test Calls Model::setRun and runs models with StochasticFlow.
+ */
+void stochasticFlows();
+
+/**
+ * @brief Tests the sampled per-flow profiler.
+ * @details Runs a model with linear, expression and generic flows with and without a profiler, and checks 
+ * the sampling, the timings by flow and by type, the report and the JSON dump.
+ * @pre None.
+ * @post The model is deleted and the dump file removed.
+ * @assert The values of a run do not depend on the profiler.
+ * @assert One step in the period is timed, and every flow is timed in each of them.
+ * @assert Flows and types are sorted by decreasing time, with their slowest evaluations first.
+ * @assert The report and the dump name every flow, and the dump file holds toJson.
+ * @assert Removing the profiler stops the counting.
+ * @test Calls Model::setProfiler and the Profiler accessors.
+ */
+void profiler();
+
+/**
+ * @brief Tests the Chrome trace of the execution phases.
+ * @details Runs a model and a parallel loop with tracing disabled and enabled, names a thread, overflows 
+ * a small buffer and checks the recorded events and their JSON dump.
+ * @pre None.
+ * @post The model is deleted, tracing is disabled and cleared, and the dump file removed.
+ * @assert Nothing is recorded while tracing is disabled.
+ * @assert Every step records its step, flows and update phases on the calling thread, after the plan.
+ * @assert The chunks of a parallel loop are recorded on several threads when the hardware has them.
+ * @assert Thread names appear in the dump, and the dump file holds toJson.
+ * @assert Events beyond the capacity of a buffer are counted as dropped.
+ * @assert Clearing and reading while another thread records leaves only whole events recorded after the 
+ * last clear.
+ * @test Calls Trace::enable, Trace::clear, Trace::getEvents, Trace::toJson and Trace::writeJson.
+ */
+void trace();
+
 #endif
\ No newline at end of file
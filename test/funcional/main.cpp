@@ -4,6 +4,30 @@ int main() {
     exponentialFlow();
     logisticFlow();
     complexFlow();
+    lazySteps();
+    steadyState();
+    linearFastForward();
+    mixedFlows();
+    expressionFlow();
+    compiledStep();
+    staticModels();
+    modelFile();
+    modelSnapshot();
+    bulkCreation();
+    bulkValues();
+    modelFork();
+    stagedEdits();
+    scheduledEvents();
+    delayFlows();
+    lookupTables();
+    timeSeriesInputs();
+    aggregators();
+    sensitivities();
+    adjointGradients();
+    calibration();
+    stochasticFlows();
+    profiler();
+    trace();
 
     return 0;
 }